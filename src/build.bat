@@ -9,5 +9,20 @@ set LinkerFlags=-incremental:no -opt:ref gdi32.lib user32.lib winmm.lib opengl32
 IF NOT EXIST ..\build mkdir ..\build
 pushd ..\build
 
+REM The running game reloads pong_module.dll when it changes, but not while
+REM lock.tmp says it's still being written.
+echo WAITING FOR BUILD > lock.tmp
+cl %CompilerFlags% -LD ..\src\pong_module.cpp /link -incremental:no -opt:ref opengl32.lib
+del lock.tmp
 cl %CompilerFlags% ..\src\pong.cpp /link %LinkerFlags% 
+cl %CompilerFlags% -LD ..\src\pong_env.cpp /link -incremental:no -opt:ref
+cl %CompilerFlags% ..\src\pong_env_bench.cpp /link -incremental:no -opt:ref
+cl %CompilerFlags% ..\src\pong_tournament.cpp /link -incremental:no -opt:ref
+cl %CompilerFlags% ..\src\pong_balls_bench.cpp /link -incremental:no -opt:ref
+cl %CompilerFlags% ..\src\pong_particles_bench.cpp /link -incremental:no -opt:ref
+cl %CompilerFlags% ..\src\pong_arena_bench.cpp /link -incremental:no -opt:ref
+cl %CompilerFlags% ..\src\pong_scale_bench.cpp /link -incremental:no -opt:ref
+cl %CompilerFlags% ..\src\pong_stream_bench.cpp /link -incremental:no -opt:ref
+cl %CompilerFlags% ..\src\pong_draw_bench.cpp /link -incremental:no -opt:ref
+cl %CompilerFlags% ..\src\pong_grid_bench.cpp /link -incremental:no -opt:ref
 popd
\ No newline at end of file
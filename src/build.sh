@@ -0,0 +1,21 @@
+#!/bin/sh
+# Builds the parts of the game that don't need Win32: the training
+# environment library, the benchmarks, the bot tournament runner and the
+# headless host.
+
+CompilerFlags="-O2 -g -std=c++11 -ffast-math -fno-exceptions -fno-rtti -Wall -Wno-unused-function -Wno-missing-braces"
+
+mkdir -p ../build
+cd ../build || exit 1
+
+c++ $CompilerFlags -fPIC -shared -fvisibility=hidden ../src/pong_env.cpp -o libpong_env.so || exit 1
+c++ $CompilerFlags ../src/pong_env_bench.cpp -o pong_env_bench -lpthread || exit 1
+c++ $CompilerFlags ../src/pong_tournament.cpp -o pong_tournament -lpthread || exit 1
+c++ $CompilerFlags ../src/pong_balls_bench.cpp -o pong_balls_bench || exit 1
+c++ $CompilerFlags ../src/pong_particles_bench.cpp -o pong_particles_bench || exit 1
+c++ $CompilerFlags ../src/pong_headless.cpp -o pong_headless -lpthread || exit 1
+c++ $CompilerFlags ../src/pong_arena_bench.cpp -o pong_arena_bench || exit 1
+c++ $CompilerFlags ../src/pong_scale_bench.cpp -o pong_scale_bench || exit 1
+c++ $CompilerFlags ../src/pong_stream_bench.cpp -o pong_stream_bench || exit 1
+c++ $CompilerFlags ../src/pong_draw_bench.cpp -o pong_draw_bench || exit 1
+c++ $CompilerFlags ../src/pong_grid_bench.cpp -o pong_grid_bench || exit 1
@@ -1,9 +1,28 @@
-#include "pong.h"
+// The Win32 host: window, input, timing, threads and memory. The game
+// itself is in pong_module.dll, loaded through loadGameCode().
 
-#define assert(n) do{ if (!(n)) *(int*)0 = 0xA11E; }while(0)
+#include "pong.h"
+#include "pong_capture.h"
+#include "pong_platform_win32.cpp"
+#include "pong_host.cpp"
+#include "pong_threads.cpp"
+#include "pong_scale.cpp"
+#include "pong_capture.cpp"
 
 static HWND hWnd;
 static WINDOWPLACEMENT globalWindowPosition = { sizeof(globalWindowPosition) };
+static HDC globalDeviceContext;
+
+// The software renderer draws into globalBackbuffer at the internal
+// resolution; presenting scales it into globalPresentBuffer, sized to the
+// window's letterbox, unless it already fits exactly.
+static offscreen_buffer globalBackbuffer;
+static offscreen_buffer globalPresentBuffer;
+static void *globalScaleScratch;
+static bool globalIntegerScale;
+static resolution_controller globalResolution;
+
+static bool globalShowPerfHud;
 
 #define VSYNC 1
 
@@ -33,18 +52,15 @@ void toggleFullscreen(HWND window) {
 	}
 }
 
-void processKeyboardMessage(button_state *state, bool isDown) {
-	if(state->endedDown != isDown) {
-		state->endedDown = isDown;
-	}
-}
+bool platformProcessInput(input_queue *queue) {
+	bool result = true;
+	u64 now = platformGetCounter();
 
-void processPendingMessages(game_state *gameState) {
 	MSG msg;
 	while(PeekMessage(&msg, 0, 0, 0, PM_REMOVE)) {
 		switch(msg.message) {
 			case WM_QUIT: {
-				gameState->programRunning = false;
+				result = false;
 			} break;
 
 			case WM_KEYUP:
@@ -57,20 +73,23 @@ void processPendingMessages(game_state *gameState) {
 				bool isDown = ((msg.lParam & (1 << 31)) == 0);
 				if(wasDown != isDown) {
 					if(vkCode == 'W') {
-						processKeyboardMessage(&gameState->input[0].up, isDown);
+						pushInputEvent(queue, now, 0, ButtonUp, isDown);
 					}
 					else if(vkCode == 'S') {
-						processKeyboardMessage(&gameState->input[0].down, isDown);
+						pushInputEvent(queue, now, 0, ButtonDown, isDown);
 					}
 					else if(vkCode == 'I') {
-						processKeyboardMessage(&gameState->input[1].up, isDown);
+						pushInputEvent(queue, now, 1, ButtonUp, isDown);
 					}
 					else if(vkCode == 'K') {
-						processKeyboardMessage(&gameState->input[1].down, isDown);
+						pushInputEvent(queue, now, 1, ButtonDown, isDown);
 					}
 					else if(vkCode == VK_ESCAPE) {
 						PostQuitMessage(0);
 					}
+					else if(vkCode == VK_F1 && isDown) {
+						globalShowPerfHud = !globalShowPerfHud;
+					}
 					if(isDown) {
 						int altKey = (msg.lParam & (1 << 29));
 						if((vkCode == VK_RETURN) && altKey) {
@@ -86,16 +105,7 @@ void processPendingMessages(game_state *gameState) {
 			} break;
 		}
 	}
-}
-
-inline LARGE_INTEGER getWallClock() {
-	LARGE_INTEGER result;
-	QueryPerformanceCounter(&result);
-	return result;
-}
 
-inline u64 getMicrosecondsElapsed(LARGE_INTEGER start, LARGE_INTEGER end, u64 perfCountFrequency) {
-	u64 result = (((end.QuadPart - start.QuadPart) * 1000000) / perfCountFrequency);
 	return result;
 }
 
@@ -123,174 +133,330 @@ window_dimension getWindowDimension(HWND hWnd) {
 	return result;
 }
 
-inline void makeRectFromCenterPoint(v2 vertices[], v2 centerPoint, v2 size) {
-	vertices[0] = V2(centerPoint.x - (0.5f * size.x), centerPoint.y - (0.5f * size.y));
-	vertices[1] = V2(centerPoint.x + (0.5f * size.x), centerPoint.y - (0.5f * size.y));
-	vertices[2] = V2(centerPoint.x + (0.5f * size.x), centerPoint.y + (0.5f * size.y));
-	vertices[3] = V2(centerPoint.x - (0.5f * size.x), centerPoint.y + (0.5f * size.y));
-}
-
-void initGameState(game_state *gameState, u32 arenaWidth, u32 arenaHeight,
-                   v2 player1Pos, v2 player2Pos, v2 pos, v2 playerSize, v2 ballSize) {
-	gameState->arenaWidth = arenaWidth;
-	gameState->arenaHeight = arenaHeight;
+bool initGL() {
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
 
-	gameState->players[0].pos = player1Pos;
-	gameState->players[0].score = 0;
-	gameState->players[0].size = playerSize;
+	GLenum error = glGetError();
+	if(error != GL_NO_ERROR) {
+		OutputDebugString("Error initializing OpenGL!\n");
+		return false;
+	}
 
-	gameState->players[1].pos = player2Pos;
-	gameState->players[1].score = 0;
-	gameState->players[1].size = playerSize;
+	return true;
+}
 
-	gameState->ball.pos = pos;
-	gameState->ball.size = ballSize;
-	gameState->ball.velocity = V2(0, 0);
+// Describes a width x height frame in whatever memory the buffer has.
+void setBufferSize(offscreen_buffer *buffer, int width, int height) {
+	buffer->width = width;
+	buffer->height = height;
+	buffer->bytesPerPixel = 4;
+	buffer->pitch = Align16(buffer->bytesPerPixel * buffer->width);
 
-	gameState->programRunning = true;
+	// GDI works the stride out from biWidth, so the DIB is as wide as the
+	// pitch and blits only take the first width pixels of each row. Negative
+	// height makes the DIB top-down, matching the GL projection.
+	buffer->info.bmiHeader.biSize = sizeof(buffer->info.bmiHeader);
+	buffer->info.bmiHeader.biWidth = buffer->pitch / buffer->bytesPerPixel;
+	buffer->info.bmiHeader.biHeight = -buffer->height;
+	buffer->info.bmiHeader.biPlanes = 1;
+	buffer->info.bmiHeader.biBitCount = 32;
+	buffer->info.bmiHeader.biCompression = BI_RGB;
 }
 
-inline wall collidedWithWall(v2 pos, v2 size, u32 arenaWidth, u32 arenaHeight) {
-	float xMin = pos.x - 0.5f * size.x;
-	float xMax = pos.x + 0.5f * size.x;
-	float yMin = pos.y - 0.5f * size.y;
-	float yMax = pos.y + 0.5f * size.y;
-
-	if(xMin < 0)
-		return WallLeft;
-	else if(yMin < 0)
-		return WallUp;
-	else if(xMax > arenaWidth)
-		return WallRight;
-	else if(yMax > arenaHeight)
-		return WallDown;
-
-	return WallNone;
-}
+void resizeDIBSection(offscreen_buffer *buffer, int width, int height) {
+	if(buffer->memory) {
+		platformFreeMemory(buffer->memory, buffer->pitch*buffer->height);
+	}
 
-void update(game_state *gameState, float dt) {
-	wall whichWallBall = collidedWithWall(gameState->ball.pos, gameState->ball.size,
-	                                      gameState->arenaWidth, gameState->arenaHeight);
+	setBufferSize(buffer, width, height);
+	int bitmapMemorySize = (buffer->pitch * buffer->height);
+	buffer->memory = platformAllocateMemory(bitmapMemorySize);
+}
 
-	if(whichWallBall == WallLeft || whichWallBall == WallRight) {
-		gameState->ball.velocity = V2(-gameState->ball.velocity.x, gameState->ball.velocity.y);
+// Scales buffer into the largest rectangle of the window with the base
+// internal resolution's aspect ourselves, so GDI only ever blits 1:1, and
+// blacks out the bars around it. Going by the base size keeps the rectangle
+// (and the present buffer) the same whatever dynamic resolution picks.
+void displayBufferInWindow(offscreen_buffer *buffer, HDC context, window_dimension window,
+                           s32 baseWidth, s32 baseHeight) {
+	rectangle2i fit = letterboxRect(baseWidth, baseHeight, window.width, window.height,
+	                                globalIntegerScale);
+	int width = fit.maxX - fit.minX;
+	int height = fit.maxY - fit.minY;
+	if(width <= 0 || height <= 0) {
+		return;
 	}
-	if(whichWallBall == WallUp || whichWallBall == WallDown) {
-		gameState->ball.velocity = V2(gameState->ball.velocity.x, -gameState->ball.velocity.y);
-	}
-
-	v2 acceleration = V2(200.0f, 500.0f);
-	gameState->ball.velocity += dt * acceleration;
-	gameState->ball.pos += dt * gameState->ball.velocity;
 
-	wall whichWallPlayer0 = collidedWithWall(gameState->players[0].pos, gameState->players[0].size,
-	                                         gameState->arenaWidth, gameState->arenaHeight);
-	v2 player0VelocityUp = Paddle_Velocity_Up;
-	v2 player0VelocityDown = Paddle_Velocity_Down;
+	PatBlt(context, 0, 0, window.width, fit.minY, BLACKNESS);
+	PatBlt(context, 0, fit.maxY, window.width, window.height - fit.maxY, BLACKNESS);
+	PatBlt(context, 0, fit.minY, fit.minX, height, BLACKNESS);
+	PatBlt(context, fit.maxX, fit.minY, window.width - fit.maxX, height, BLACKNESS);
+
+	offscreen_buffer *present = buffer;
+	if(width != buffer->width || height != buffer->height) {
+		present = &globalPresentBuffer;
+		if(present->width != width || present->height != height) {
+			if(globalScaleScratch) {
+				platformFreeMemory(globalScaleScratch, scaleScratchSize(present->width));
+			}
+			resizeDIBSection(present, width, height);
+			globalScaleScratch = platformAllocateMemory(scaleScratchSize(width));
+		}
 
-	if(whichWallPlayer0 == WallUp) {
-		player0VelocityUp = V2(0, 0);
-	}
-	if(whichWallPlayer0 == WallDown) {
-		player0VelocityDown = V2(0, 0);
+		pixel_image source = pixelImage(buffer);
+		pixel_image dest = pixelImage(present);
+		scaleImage(&source, &dest, globalScaleScratch);
 	}
 
-	wall whichWallPlayer1 = collidedWithWall(gameState->players[1].pos, gameState->players[1].size,
-	                                         gameState->arenaWidth, gameState->arenaHeight);
-	v2 player1VelocityUp = Paddle_Velocity_Up;
-	v2 player1VelocityDown = Paddle_Velocity_Down;
+	StretchDIBits(context, fit.minX, fit.minY, width, height, 0, 0, width, height,
+	              present->memory, &present->info, DIB_RGB_COLORS, SRCCOPY);
+}
 
-	if(whichWallPlayer1 == WallUp) {
-		player1VelocityUp = V2(0, 0);
-	}
-	if(whichWallPlayer1 == WallDown) {
-		player1VelocityDown = V2(0, 0);
+// "-render=WxH" sets the software renderer's internal resolution, the window
+// size by default; "-integerScale" presents it only at whole multiples.
+// "-renderBudget=MS" is what dynamic resolution aims to keep rendering under,
+// and "-fixedResolution" turns it off.
+void parseRenderOptions(const char *commandLine, int *width, int *height, u64 *budgetMicroseconds,
+                        bool *dynamic) {
+	*width = Window_Width;
+	*height = Window_Height;
+
+	const char *at = strstr(commandLine, "-render=");
+	if(at) {
+		at += 8;
+		int parsedWidth = atoi(at);
+		const char *separator = strchr(at, 'x');
+		int parsedHeight = separator ? atoi(separator + 1) : 0;
+		if(parsedWidth > 0 && parsedHeight > 0) {
+			*width = parsedWidth;
+			*height = parsedHeight;
+		}
 	}
 
+	globalIntegerScale = (strstr(commandLine, "-integerScale") != 0);
 
-	if(gameState->input[0].up.endedDown) {
-		gameState->players[0].pos += dt * player0VelocityUp;
-	}
-	if(gameState->input[0].down.endedDown) {
-		gameState->players[0].pos += dt * player0VelocityDown;
-	}
-	if(gameState->input[1].up.endedDown) {
-		gameState->players[1].pos += dt * player1VelocityUp;
-	}
-	if(gameState->input[1].down.endedDown) {
-		gameState->players[1].pos += dt * player1VelocityDown;
+	*budgetMicroseconds = Default_Render_Budget_Microseconds;
+	at = strstr(commandLine, "-renderBudget=");
+	if(at) {
+		float milliseconds = (float)atof(at + 14);
+		if(milliseconds > 0.0f) {
+			*budgetMicroseconds = (u64)(milliseconds*1000.0f);
+		}
 	}
+
+	*dynamic = (strstr(commandLine, "-fixedResolution") == 0);
 }
 
+void platformPresent(void) {
+#if SOFTWARE_RENDERER
+	displayBufferInWindow(&globalBackbuffer, globalDeviceContext, getWindowDimension(hWnd),
+	                      globalResolution.baseWidth, globalResolution.baseHeight);
+#else
+	SwapBuffers(globalDeviceContext);
+#endif
+}
 
+void writeSnapshot(simulation_context *sim) {
+	tick_clock *clock = &sim->clock;
+	render_snapshot *snapshot = beginSnapshot(&sim->snapshots);
 
+	sim->code->publish(sim, snapshot);
 
-bool initGL() {
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	glOrtho(0.0f, Screen_Width, Screen_Height, 0.0f, 1.0f, -1.0f);
+	snapshot->stateTime = clock->last - clock->accumulator;
+	snapshot->stepTime = tickClockSpan(clock, 1);
 
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
+	snapshot->tick = clock->tick;
+	snapshot->droppedTime = clock->droppedTime;
+	snapshot->droppedFrames = clock->droppedFrames;
+	snapshot->sweptUpdates = clock->sweptUpdates;
 
-	GLenum error = glGetError();
-	if(error != GL_NO_ERROR) {
-		OutputDebugString("Error initializing OpenGL!\n");
-		return false;
+	publishSnapshot(&sim->snapshots);
+}
+
+// Runs update() at the fixed tick rate independently of rendering and
+// presentation. Input arrives through sim->input, state leaves through
+// sim->snapshots; apart from the reload handshake nothing else is shared
+// with the window thread.
+DWORD WINAPI simulationThreadProc(LPVOID parameter) {
+	simulation_context *sim = (simulation_context *)parameter;
+	tick_clock *clock = &sim->clock;
+
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+
+	while(atomicLoadU32(&sim->running)) {
+		if(atomicLoadU32(&sim->pauseRequested)) {
+			atomicStoreU32(&sim->paused, 1);
+			while(atomicLoadU32(&sim->pauseRequested)) {
+				platformSleep(0);
+			}
+			atomicStoreU32(&sim->paused, 0);
+		}
+
+		tickClockBeginFrame(clock, platformGetCounter());
+
+		// The simulated timeline trails the wall clock by whatever is left in
+		// the accumulator, so each step covers [start, end) of real time and
+		// input is integrated over exactly that window.
+		bool stepped = false;
+		u32 steps;
+		u64 start = clock->last - clock->accumulator;
+		while((steps = tickClockNextStep(clock)) != 0) {
+			u64 end = clock->last - clock->accumulator;
+			float dt = tickClockSeconds(clock, steps);
+			integrateInput(sim, start, end);
+			sim->code->simulate(sim, dt);
+			start = end;
+			stepped = true;
+		}
+
+		if(stepped) {
+			sim->persistent->tick = clock->tick;
+			writeSnapshot(sim);
+		}
+
+		// Sleep through most of the wait for the next tick, then yield the rest
+		// away so the tick lands close to on time.
+		u64 untilNextTick = tickClockSpan(clock, 1) - clock->accumulator;
+		u64 msUntilNextTick = (untilNextTick * 1000) / clock->frequency;
+		if(msUntilNextTick > 1) {
+			platformSleep((u32)(msUntilNextTick - 1));
+		}
+		else {
+			platformSleep(0);
+		}
 	}
 
-	return true;
+	return 0;
 }
 
-inline void quad(v2 vertices[], int n) {
-	assert(n % 4 == 0);
-	
-	glBegin(GL_QUADS);
+GAME_INITIALIZE(gameInitializeStub) {
+}
+
+GAME_SIMULATE(gameSimulateStub) {
+}
 
-	for(int i=0; i < n; ++i) {
-		glVertex2f(vertices[i].x, vertices[i].y);
+GAME_PUBLISH(gamePublishStub) {
+}
+
+GAME_RENDER(gameRenderStub) {
+}
+
+inline FILETIME getLastWriteTime(const char *path) {
+	FILETIME result = {};
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if(GetFileAttributesExA(path, GetFileExInfoStandard, &data)) {
+		result = data.ftLastWriteTime;
 	}
+	return result;
+}
 
-	glEnd();
+// path with its file name replaced by fileName
+void buildSiblingPath(char *result, u32 resultSize, const char *path, const char *fileName) {
+	const char *lastSlash = path;
+	for(const char *at = path; *at; ++at) {
+		if(*at == '\\' || *at == '/') {
+			lastSlash = at + 1;
+		}
+	}
+
+	u32 directoryLength = (u32)(lastSlash - path);
+	u32 fileNameLength = (u32)strlen(fileName);
+	if(directoryLength + fileNameLength + 1 > resultSize) {
+		result[0] = 0;
+		return;
+	}
+	memcpy(result, path, directoryLength);
+	memcpy(result + directoryLength, fileName, fileNameLength + 1);
 }
 
-inline void line(float x0, float y0, float x1, float y1) {
-	glBegin(GL_LINES);
+// Loads a copy of the library rather than the library itself, so the build
+// can overwrite it while the game is running.
+game_code loadGameCode(const char *sourcePath, const char *tempPath) {
+	game_code result = {};
+	result.lastWriteTime = getLastWriteTime(sourcePath);
 
-	glVertex2f(x0, y0);
-	glVertex2f(x1, y1);
+	if(CopyFileA(sourcePath, tempPath, FALSE)) {
+		result.library = LoadLibraryA(tempPath);
+	}
+	if(result.library) {
+		result.initialize = (game_initialize *)GetProcAddress(result.library, "gameInitialize");
+		result.simulate = (game_simulate *)GetProcAddress(result.library, "gameSimulate");
+		result.publish = (game_publish *)GetProcAddress(result.library, "gamePublish");
+		result.render = (game_render *)GetProcAddress(result.library, "gameRender");
+		result.isValid = (result.initialize && result.simulate && result.publish && result.render);
+	}
+
+	if(!result.isValid) {
+		platformLog("Couldn't load the game code\n");
+		result.initialize = gameInitializeStub;
+		result.simulate = gameSimulateStub;
+		result.publish = gamePublishStub;
+		result.render = gameRenderStub;
+	}
 
-	glEnd();
+	return result;
 }
 
-void render(game_state *gameState, float offset) {
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+void unloadGameCode(game_code *code) {
+	if(code->library) {
+		FreeLibrary(code->library);
+	}
+	*code = {};
+	code->initialize = gameInitializeStub;
+	code->simulate = gameSimulateStub;
+	code->publish = gamePublishStub;
+	code->render = gameRenderStub;
+}
 
-	v2 ballOffset = (offset * gameState->ball.pos) + ((1.0f - offset) * gameState->ball.pos);
-	v2 player0Offset = (offset * gameState->players[0].pos) + ((1.0f - offset) * gameState->players[0].pos);
-	v2 player1Offset = (offset * gameState->players[1].pos) + ((1.0f - offset) * gameState->players[1].pos);
+// The game's one-time setup, run against the first valid library: at startup,
+// or on the first reload that works if that one didn't.
+void initializeGameCode(simulation_context *sim, render_context *renderer, host_memory *hostMemory,
+                        const char *commandLine) {
+	sim->code->initialize(sim, renderer, &hostMemory->permanentArena, &hostMemory->transientArena,
+	                      commandLine, hostMemory->persistence == PersistentResumed);
+	markPersistentMemoryInitialized(hostMemory);
+	sim->initialized = true;
+}
 
-	makeRectFromCenterPoint(gameState->ball.vertices, ballOffset, gameState->ball.size);
-	makeRectFromCenterPoint(gameState->players[0].vertices, player0Offset, gameState->players[0].size);
-	makeRectFromCenterPoint(gameState->players[1].vertices, player1Offset, gameState->players[1].size);
+// Swaps in a rebuilt library between frames. The simulation thread is parked
+// and the work queue drained first, since both run game code.
+void reloadGameCode(simulation_context *sim, render_context *renderer, host_memory *hostMemory,
+                    const char *commandLine, work_queue *queue, const char *sourcePath,
+                    const char *tempPath) {
+	u64 start = platformGetCounter();
 
-	glColor3f(1.0f, 1.0f, 1.0f);
+	atomicStoreU32(&sim->pauseRequested, 1);
+	while(!atomicLoadU32(&sim->paused) && atomicLoadU32(&sim->running)) {
+		platformSleep(0);
+	}
+	completeAllWork(queue);
+
+	unloadGameCode(sim->code);
+	*sim->code = loadGameCode(sourcePath, tempPath);
+	if(sim->code->isValid && !sim->initialized) {
+		// Everything published so far came from the stubs
+		initializeGameCode(sim, renderer, hostMemory, commandLine);
+		writeSnapshot(sim);
+	}
 
-	line(Screen_Width / 2.0f, 0.0f, Screen_Width / 2.0f, Screen_Height);
-	quad(gameState->players[0].vertices, 4);
-	quad(gameState->players[1].vertices, 4);
-	quad(gameState->ball.vertices, 4);
+	// Wait for the thread to actually leave, so the next reload can't mistake
+	// this pause for its own.
+	atomicStoreU32(&sim->pauseRequested, 0);
+	while(atomicLoadU32(&sim->paused) && atomicLoadU32(&sim->running)) {
+		platformSleep(0);
+	}
 
-	glFlush();
+	char text[128];
+	sprintf_s(text, "Reloaded the game code in %.2fms\n",
+	          getMicrosecondsElapsed(start, platformGetCounter(), platformCounterFrequency()) / 1000.0f);
+	platformLog(text);
 }
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
-	LARGE_INTEGER perfCountFrequencyResult;
-	QueryPerformanceFrequency(&perfCountFrequencyResult);
-	s64 perfCountFrequency = perfCountFrequencyResult.QuadPart;
+	u64 perfCountFrequency = platformCounterFrequency();
 
 	timeBeginPeriod(1);
 
@@ -306,8 +472,35 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	RegisterClassEx(&wc);
 
 	hWnd = CreateWindowEx(0, "WindowClass", "Pong", WS_OVERLAPPEDWINDOW|WS_VISIBLE,
-	                      0, 0, Screen_Width, Screen_Height, NULL, NULL, hInstance, NULL);
+	                      0, 0, Window_Width, Window_Height, NULL, NULL, hInstance, NULL);
 
+	HDC deviceContext = GetDC(hWnd);
+	globalDeviceContext = deviceContext;
+
+#if SOFTWARE_RENDERER
+	// The backbuffer's memory is reserved once at the base size; every
+	// dynamic resolution level is a smaller frame carved out of the same
+	// block.
+	int renderWidth, renderHeight;
+	u64 renderBudget;
+	bool dynamicResolution;
+	parseRenderOptions(lpCmdLine, &renderWidth, &renderHeight, &renderBudget, &dynamicResolution);
+	resizeDIBSection(&globalBackbuffer, renderWidth, renderHeight);
+	int backbufferSize = globalBackbuffer.pitch*globalBackbuffer.height;
+	initResolutionController(&globalResolution, renderWidth, renderHeight, renderBudget, dynamicResolution);
+
+	// Recorded at the base size; smaller dynamic resolution frames are
+	// scaled up on their way into the capture.
+	video_capture capture = {};
+	char capturePath[Max_Capture_Path];
+	bool capturing = false;
+	if(parseCaptureOption(lpCmdLine, capturePath, sizeof(capturePath))) {
+		capturing = startCapture(&capture, capturePath, renderWidth, renderHeight, Simulation_Hz);
+		if(!capturing) {
+			platformLog("Couldn't start the capture\n");
+		}
+	}
+#else
 	PIXELFORMATDESCRIPTOR pfd = {
 		sizeof(PIXELFORMATDESCRIPTOR),
 		1,
@@ -327,244 +520,172 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 		0, 0, 0
 	};
 
-	HDC deviceContext = GetDC(hWnd);
-
 	int pixelFormat = ChoosePixelFormat(deviceContext, &pfd);
 	SetPixelFormat(deviceContext, pixelFormat, &pfd);
 
 	HGLRC renderContext = wglCreateContext(deviceContext);
 	wglMakeCurrent(deviceContext, renderContext);
 
+	if(strstr(lpCmdLine, "-capture=")) {
+		platformLog("-capture needs the software renderer\n");
+	}
+#endif
+
 	ShowWindow(hWnd, nCmdShow);
 
-	game_memory gameMemory = {};
-	gameMemory.storageSize = megabytes(1);
-	gameMemory.storage = VirtualAlloc(0, (size_t)gameMemory.storageSize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+	host_memory hostMemory;
+	initHostMemory(&hostMemory, lpCmdLine, megabytes(16), megabytes(64));
+	memory_arena *arena = &hostMemory.transientArena;
+	persistent_state *persistent = hostMemory.persistent;
+
+	simulation_context *sim = pushStruct(arena, simulation_context);
+	render_context *renderer = pushStruct(arena, render_context);
+
+	// The build writes pong_module.dll next to the executable and holds
+	// lock.tmp while it does.
+	char exePath[MAX_PATH];
+	char sourceCodePath[MAX_PATH];
+	char tempCodePath[MAX_PATH];
+	char lockPath[MAX_PATH];
+	GetModuleFileNameA(0, exePath, sizeof(exePath));
+	buildSiblingPath(sourceCodePath, sizeof(sourceCodePath), exePath, "pong_module.dll");
+	buildSiblingPath(tempCodePath, sizeof(tempCodePath), exePath, "pong_module_temp.dll");
+	buildSiblingPath(lockPath, sizeof(lockPath), exePath, "lock.tmp");
+
+	// A library that's still being written waits for the main loop to see the
+	// build finish, like any other reload; until then the stubs run.
+	game_code *code = pushStruct(arena, game_code);
+	unloadGameCode(code);
+	if(GetFileAttributesA(lockPath) == INVALID_FILE_ATTRIBUTES) {
+		*code = loadGameCode(sourceCodePath, tempCodePath);
+	}
 
-	game_state *gameState = (game_state*)gameMemory.storage;
+	// Two cores are left for the simulation and render threads.
+	u32 coreCount = getCoreCount();
+	work_queue *workQueue = pushStruct(arena, work_queue);
+	initWorkQueue(workQueue, (coreCount > 3) ? (coreCount - 2) : 1);
 
+#if !SOFTWARE_RENDERER
 	initGL();
-	initGameState(gameState, Screen_Width, Screen_Height, V2(50, Player_Default_Y),
-	              V2(Screen_Width - 50, Player_Default_Y), V2(Ball_Default_X, Ball_Default_Y),
-	              V2(Player_Width, Player_Height), V2(Ball_Width, Ball_Height));
+#endif
 
-	LARGE_INTEGER previous = getWallClock();
-	float accumulator = 0.0f;
-	float targetFixedStep = 1 / 60.0f;
+	u64 previous = platformGetCounter();
 	float targetFPS = 1 / 60.0f;
 
+	sim->gameState = &persistent->gameState;
+	sim->persistent = persistent;
+	sim->bots = persistent->bots;
+	sim->workQueue = workQueue;
+	sim->rolloutClock = getRolloutClock;
+	sim->code = code;
+	sim->running = 1;
+	initTickClock(&sim->clock, perfCountFrequency, Simulation_Hz, previous);
+	sim->clock.tick = persistent->tick;
+	initTripleBuffer(&sim->snapshots);
+
+	renderer->frameHistogram = pushStruct(arena, frame_histogram);
+	renderer->perfCountFrequency = perfCountFrequency;
+#if SOFTWARE_RENDERER
+	renderer->buffer = &globalBackbuffer;
+#endif
+
+	if(code->isValid) {
+		initializeGameCode(sim, renderer, &hostMemory, lpCmdLine);
+	}
+
+	// Publish the initial state so the renderer has something valid before the
+	// first tick.
+	writeSnapshot(sim);
+
+	HANDLE simulationThread = CreateThread(0, 0, simulationThreadProc, sim, 0, 0);
+
+#if !SOFTWARE_RENDERER
 	PFNWGLSWAPINTERVALEXTPROC proc = (PFNWGLSWAPINTERVALEXTPROC)wglGetProcAddress("wglSwapIntervalEXT");
 #if VSYNC
 	proc(1);
 #else
 	proc(0);
 #endif
-	while(gameState->programRunning) {
-		processPendingMessages(gameState);
-
-		LARGE_INTEGER current = getWallClock();
-		u64 microsecondsElapsed = getMicrosecondsElapsed(previous, current, perfCountFrequency);
-		previous = current;
-
-		// microsecondsElapsed is converted from microseconds to seconds and added to accumulator variable
-		accumulator += (microsecondsElapsed / (1000.0f * 1000.0f));
-
-		while(accumulator >= targetFixedStep) {
-			update(gameState, targetFixedStep);
-			accumulator -= targetFixedStep;
-		}
-
-		float offset = accumulator / targetFixedStep;
-		render(gameState, offset);
-		SwapBuffers(deviceContext);
-
-		// LARGE_INTEGER sleep = getWallClock();
-		// float remaining = getMicrosecondsElapsed(current, sleep, perfCountFrequency) / (1000.0f * 1000.0f);
-		// while(remaining < targetFPS) {
-		// 	remaining = getMicrosecondsElapsed(current, getWallClock(), perfCountFrequency) / (1000.0f * 1000.0f);
-		// }
-
-#if 1
-		LARGE_INTEGER end = getWallClock();
-		float msPerFrame = getMicrosecondsElapsed(previous, end, perfCountFrequency) / 1000.0f;
-
-		char fpsBuffer[50];
-		sprintf_s(fpsBuffer, "%.02fms/f\n", msPerFrame);
-
-		SetWindowText(hWnd, fpsBuffer);
 #endif
-	}
-
-	wglDeleteContext(renderContext);
-	VirtualFree(gameMemory.storage, 0, MEM_RELEASE);
-	return 0;
-}
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-#if 0
-void resizeDIBSection(offscreen_buffer *buffer, int width, int height) {
-	buffer->width = width;
-	buffer->height = height;
-	buffer->bytesPerPixel = 4;
-	buffer->pitch = Align16(buffer->bytesPerPixel * buffer->width);
-
-	buffer->info.bmiHeader.biSize = sizeof(buffer->info.bmiHeader);
-	buffer->info.bmiHeader.biWidth = buffer->width;
-	buffer->info.bmiHeader.biHeight = buffer->height;
-	buffer->info.bmiHeader.biPlanes = 1;
-	buffer->info.bmiHeader.biBitCount = 32;
-	buffer->info.bmiHeader.biCompression = BI_RGB;
-
-	int bitmapMemorySize = (buffer->pitch * buffer->height);	
-	buffer->memory = VirtualAlloc(0, bitmapMemorySize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-}
-
-void displayBufferInWindow(offscreen_buffer *buffer, HDC context) {
-	StretchDIBits(context, 0, 0, buffer->width, buffer->height, 0, 0, buffer->width, buffer->height,
-	              buffer->memory, &buffer->info, DIB_RGB_COLORS, SRCCOPY);
-}
-
-inline void drawRectangle(offscreen_buffer *buffer, v2 vMin, v2 vMax, int color) {
-	// vMin should be vertices[0] and vMax should be vertices[2]. At least for now.
-	rectangle2i source = makeRectV2(vMin, vMax);
-	rectangle2i dest = Rect(0, 0, buffer->width, buffer->height);
-	rectangle2i clip = clipRect(source, dest);
-
-	u8 *row = ((u8 *)buffer->memory + (clip.minX*buffer->bytesPerPixel) + 
-	           (clip.minY*buffer->pitch));
-	for(int y=clip.minY; y < clip.maxY; ++y) {
-		u32 *pixel = (u32 *)row;
-		for(int x=clip.minX; x < clip.maxX; ++x) {
-			*pixel++ = color;
+	float msPerFrame = 0.0f;
+	while(atomicLoadU32(&sim->running)) {
+		if(!platformProcessInput(&sim->input)) {
+			atomicStoreU32(&sim->running, 0);
 		}
-		row += buffer->pitch;
-	}
-}
 
-inline void clearBuffer(offscreen_buffer *buffer) {
-	u8 *row = (u8 *)buffer->memory;
-	for(int y=0; y < buffer->height; ++y) {
-		u32 *pixel = (u32 *)row;
-		for(int x=0; x < buffer->width; ++x) {
-			*pixel++ = 0x00000000;
+		FILETIME newCodeWriteTime = getLastWriteTime(sourceCodePath);
+		if(CompareFileTime(&newCodeWriteTime, &code->lastWriteTime) != 0 &&
+		   GetFileAttributesA(lockPath) == INVALID_FILE_ATTRIBUTES) {
+			reloadGameCode(sim, renderer, &hostMemory, lpCmdLine, workQueue, sourceCodePath, tempCodePath);
 		}
-		row += buffer->pitch;
-	}
-}
-
-void render(game_state *gameState, offscreen_buffer *buffer, float offset) {
-	clearBuffer(buffer);
-
-	v2 ballOffset = (offset * gameState->ball.pos) + ((1.0f - offset) * gameState->ball.pos);
-	v2 player0Offset = (offset * gameState->players[0].pos) + ((1.0f - offset) * gameState->players[0].pos);
-	v2 player1Offset = (offset * gameState->players[1].pos) + ((1.0f - offset) * gameState->players[1].pos);
-
-	makeRectFromCenterPoint(gameState->ball.vertices, ballOffset, gameState->ball.size);
-	makeRectFromCenterPoint(gameState->players[0].vertices, player0Offset, gameState->players[0].size);
-	makeRectFromCenterPoint(gameState->players[1].vertices, player1Offset, gameState->players[1].size);
-
-	drawRectangle(buffer, gameState->ball.vertices[0], gameState->ball.vertices[2], 0xffffffff);
-	drawRectangle(buffer, gameState->players[0].vertices[0], gameState->players[0].vertices[2], 0xffffffff);
-	drawRectangle(buffer, gameState->players[1].vertices[0], gameState->players[1].vertices[2], 0xffffffff);
-}
-
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
-	LARGE_INTEGER perfCountFrequencyResult;
-	QueryPerformanceFrequency(&perfCountFrequencyResult);
-	u64 perfCountFrequency = perfCountFrequencyResult.QuadPart;
-
-
-	WNDCLASSEX wc;
-	wc = {0};
-	wc.cbSize = sizeof(WNDCLASSEX);
-	wc.style = CS_OWNDC;
-	wc.lpfnWndProc = WndProc;
-	wc.hInstance = hInstance;
-	wc.hCursor = LoadCursor(NULL, IDC_ARROW);
-	wc.lpszClassName = "WindowClass";
-
-	RegisterClassEx(&wc);
 
-	offscreen_buffer buffer = {};
-	resizeDIBSection(&buffer, Screen_Width, Screen_Height);
-
-	hWnd = CreateWindowEx(0, "WindowClass", "Pong", WS_OVERLAPPEDWINDOW|WS_VISIBLE,
-	                      0, 0, CW_USEDEFAULT, CW_USEDEFAULT, 0, 
-	                      0, hInstance, 0);
-
-	HDC deviceContext = GetDC(hWnd);
-
-	ShowWindow(hWnd, nCmdShow);
-
-	game_memory gameMemory = {};
-	gameMemory.storageSize = megabytes(1);
-	gameMemory.storage = VirtualAlloc(0, (size_t)gameMemory.storageSize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-
-	game_state *gameState = (game_state*)gameMemory.storage;
-
-	initGameState(gameState, Screen_Width, Screen_Height, V2(50, Player_Default_Y), 
-	              V2(Screen_Width - 50, Player_Default_Y), V2(Ball_Default_X, Ball_Default_Y), 
-	              V2(Player_Width, Player_Height), V2(Ball_Width, Ball_Height));
-
-	timeBeginPeriod(1);
-
-	LARGE_INTEGER previous = getWallClock();
-	float lag = 0.0f;
-	float targetSeconds = 1 / 480.0f;
-
-	while(gameState->programRunning) {
-		processPendingMessages(gameState);
-
-		LARGE_INTEGER current = getWallClock();
-		u64 microsecondsElapsed = getMicrosecondsElapsed(previous, current, perfCountFrequency);
+		u64 current = platformGetCounter();
+		u64 microsecondsPerFrame = getMicrosecondsElapsed(previous, current, perfCountFrequency);
+		msPerFrame = microsecondsPerFrame / 1000.0f;
+		recordFrameTime(renderer->frameHistogram, microsecondsPerFrame);
 		previous = current;
 
-		// microsecondsElapsed is converted from microseconds to seconds and added to lag value
-		lag += (microsecondsElapsed / (1000.0f * 1000.0f));
+		// Read the counter after fetching the snapshot, so the simulation can't
+		// have published a state newer than it; the counters are unsigned, so
+		// compare before subtracting anyway.
+		render_snapshot *snapshot = latestSnapshot(&sim->snapshots);
+		u64 now = platformGetCounter();
+		float offset = 0.0f;
+		if(now > snapshot->stateTime) {
+			offset = (float)(now - snapshot->stateTime) / (float)snapshot->stepTime;
+		}
+		if(offset > 1.0f) {
+			offset = 1.0f;
+		}
 
-		while(lag >= targetSeconds) {
-			update(gameState, targetSeconds);
-			lag -= targetSeconds;
+		renderer->showPerfHud = globalShowPerfHud;
+		renderer->window = getWindowDimension(hWnd);
+#if SOFTWARE_RENDERER
+		u64 renderStart = platformGetCounter();
+		code->render(renderer, snapshot, offset, msPerFrame);
+		u64 renderMicroseconds = getMicrosecondsElapsed(renderStart, platformGetCounter(), perfCountFrequency);
+		if(capturing && captureFrameDue(&capture, platformGetCounter(), perfCountFrequency)) {
+			pixel_image frame = pixelImage(&globalBackbuffer);
+			captureFrame(&capture, &frame);
+		}
+		if(updateResolutionController(&globalResolution, renderMicroseconds)) {
+			u32 width, height;
+			resolutionLevelSize(&globalResolution, globalResolution.level, &width, &height);
+			setBufferSize(&globalBackbuffer, width, height);
 		}
+#else
+		code->render(renderer, snapshot, offset, msPerFrame);
+#endif
 
-		float offset = lag / targetSeconds;
-		render(gameState, &buffer, offset);
-		displayBufferInWindow(&buffer, deviceContext);
+		platformPresent();
 
-		// LARGE_INTEGER sleep = getWallClock();
-		// float remaining = getMicrosecondsElapsed(previous, sleep, perfCountFrequency) / (1000.0f * 1000.0f);
-		// while(remaining < targetSeconds) {
-		// 	s64 amount = (DWORD)((targetSeconds - remaining) * 1000.0f);
-		// 	remaining = getMicrosecondsElapsed(previous, getWallClock(), perfCountFrequency) / (1000.0f * 1000.0f);
-		// 	Sleep((DWORD)amount);
+		// u64 sleep = platformGetCounter();
+		// float remaining = getMicrosecondsElapsed(current, sleep, perfCountFrequency) / (1000.0f * 1000.0f);
+		// while(remaining < targetFPS) {
+		// 	remaining = getMicrosecondsElapsed(current, platformGetCounter(), perfCountFrequency) / (1000.0f * 1000.0f);
 		// }
+	}
 
-#if 0
-		LARGE_INTEGER end = getWallClock();
-		float msPerFrame = getMicrosecondsElapsed(previous, end, perfCountFrequency) / 1000.0f;
+	WaitForSingleObject(simulationThread, INFINITE);
+	CloseHandle(simulationThread);
+	completeAllWork(workQueue);
+	unloadGameCode(code);
 
-		char fpsBuffer[256];
-		sprintf_s(fpsBuffer, "%.02fms/f\n", msPerFrame);
+#if SOFTWARE_RENDERER
+	if(capturing) {
+		stopCapture(&capture);
 
-		OutputDebugString(fpsBuffer);
-#endif
+		char text[Max_Capture_Path + 64];
+		sprintf_s(text, "Captured %u frames to %s (%u dropped)\n", capture.written, capturePath, capture.dropped);
+		platformLog(text);
 	}
 
-	VirtualFree(gameMemory.storage, 0, MEM_RELEASE);
-	VirtualFree(buffer.memory, 0, MEM_RELEASE);
+	platformFreeMemory(globalBackbuffer.memory, backbufferSize);
+	platformFreeMemory(globalPresentBuffer.memory, globalPresentBuffer.pitch*globalPresentBuffer.height);
+	platformFreeMemory(globalScaleScratch, scaleScratchSize(globalPresentBuffer.width));
+#else
+	wglDeleteContext(renderContext);
+#endif
+	releaseHostMemory(&hostMemory);
 	return 0;
 }
-#endif
\ No newline at end of file
@@ -3,57 +3,22 @@
 
 #include <windows.h>
 #include <stdio.h>
-#include <stdint.h>
-#include <stddef.h>
-#include <cmath>
 #include <gl/gl.h>
 
 #include "gl/wglext.h"
 
-#include "pong_math.h"
+#include "pong_host.h"
+#include "pong_scale.h"
+#include "pong_draw.h"
 
-typedef uint8_t u8;
-typedef uint16_t u16;
-typedef uint32_t u32;
-typedef uint64_t u64;
+#define SOFTWARE_RENDERER 0
 
-typedef int8_t s8;
-typedef int16_t s16;
-typedef int32_t s32;
-typedef int64_t s64;
-
-#define kilobytes(value) ((value) * 1024LL)
-#define megabytes(value) (kilobytes(value) * 1024LL)
-#define gigabytes(value) (megabytes(value) * 1024LL)
-
-#define Screen_Width 1280
-#define Screen_Height 720
-
-#define Ball_Width 10
-#define Ball_Height 10
-#define Player_Width 20
-#define Player_Height 50
-
-#define Player_Default_Y (Screen_Height / 2.0f)
-
-#define Paddle_Velocity_Up V2(0.0f, -400.0f)
-#define Paddle_Velocity_Down V2(0.0f, 400.0f)
-
-#define Ball_Initial_Velocity V2(1600.0f, 0.0f)
-
-#define Ball_Default_X (Screen_Width / 2.0f)
-#define Ball_Default_Y (Screen_Height / 2.0f)
-
-#define Align16(value) (((value) + 15) & ~15)
-
-enum wall {
-	WallNone,
-
-	WallLeft,
-	WallRight,
-	WallUp,
-	WallDown,
-};
+// Initial window size. The arena has its own size (arena_config); the GL
+// renderer letterboxes it into the window, the software one draws it at the
+// internal resolution (-render=WxH, the window size by default) and the host
+// letterboxes that.
+#define Window_Width 1280
+#define Window_Height 720
 
 struct offscreen_buffer {
 	void* memory;
@@ -64,48 +29,27 @@ struct offscreen_buffer {
 	BITMAPINFO info;
 };
 
-struct game_memory {
-	void* storage;
-	u32 storageSize;
-};
-
-struct player {
-	v2 pos;
-	
-	// Size is (width, height)
-	v2 size; 
-	u32 score;
-
-	v2 vertices[4];
-};
-
-struct ball {
-	v2 pos;
-
-	// Size is (width, height)
-	v2 size; 
-	v2 velocity;
-
-	v2 vertices[4];
-};
-
-struct button_state {
-	bool endedDown;
-};
-
-struct program_input {
-	button_state up;
-	button_state down;
-};
-
-struct game_state {
-	player players[2];
-	program_input input[2];
-	ball ball;
-
-	u32 arenaWidth, arenaHeight;
-
-	bool programRunning;
+inline pixel_image pixelImage(offscreen_buffer *buffer) {
+	pixel_image result;
+	result.memory = buffer->memory;
+	result.width = buffer->width;
+	result.height = buffer->height;
+	result.pitch = buffer->pitch;
+	return result;
+}
+
+// The currently loaded pong_module.dll. The functions are stubs while it
+// isn't loaded.
+struct game_code {
+	HMODULE library;
+	FILETIME lastWriteTime;
+
+	game_initialize *initialize;
+	game_simulate *simulate;
+	game_publish *publish;
+	game_render *render;
+
+	bool isValid;
 };
 
 struct window_dimension {
@@ -113,4 +57,30 @@ struct window_dimension {
 	int height;
 };
 
+#include "pong_text.h"
+
+// Everything the render thread keeps between frames, in transient storage so
+// it survives a reload of the game code.
+struct render_context {
+	text_batch *textBatch;
+	particle_system *particles;
+	u32 effectsSeen;
+
+	// Four per stress-mode ball, 0 without -balls
+	v2 *poolVertices;
+
+	// Themed paddles and balls, 0 without THEMED_SPRITES. The vertices are
+	// four per paddle, ball and stress-mode ball.
+	sprite_atlas *sprites;
+	sprite_vertex *spriteVertices;
+
+	// Kept by the host. buffer is the software renderer's target at the
+	// internal resolution; window is the client area this frame.
+	frame_histogram *frameHistogram;
+	u64 perfCountFrequency;
+	bool showPerfHud;
+	offscreen_buffer *buffer;
+	window_dimension window;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,281 @@
+// Closed-form ball prediction and a bot that turns it into program_input.
+// Nothing here simulates forward; a decision is a couple of square roots and
+// a modulo regardless of how far away the intercept is.
+
+static bot_difficulty globalBotDifficulties[] = {
+	{12, 60.0f, 8.0f}, // easy
+	{6, 25.0f, 4.0f},  // medium
+	{2, 8.0f, 2.0f},   // hard
+	{0, 0.0f, 0.0f},   // perfect
+};
+
+// splitmix64, for deriving per-game seeds from one seed and an index
+inline u64 mixSeed(u64 x) {
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+inline u32 nextRandom(u32 *state) {
+	u32 x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+inline float randomUnilateral(u32 *state) {
+	float result = (float)(nextRandom(state) >> 8) / (float)(1 << 24);
+	return result;
+}
+
+// Roughly normal with unit variance.
+inline float randomGaussian(u32 *state) {
+	float sum = randomUnilateral(state) + randomUnilateral(state) +
+		randomUnilateral(state) + randomUnilateral(state);
+	float result = (sum - 2.0f) * 1.7320508f;
+	return result;
+}
+
+// minWall and maxWall bound the ball's center, pos/velocity/acceleration are
+// the components along this axis.
+bounce_orbit makeBounceOrbit(float minWall, float maxWall, float pos, float velocity, float acceleration) {
+	bounce_orbit result = {};
+
+	float length = maxWall - minWall;
+	if(acceleration >= 0.0f) {
+		result.floor = maxWall;
+		result.direction = -1.0f;
+	}
+	else {
+		result.floor = minWall;
+		result.direction = 1.0f;
+	}
+	result.g = fabsf(acceleration);
+
+	// Height above the floor and speed away from it
+	float h = (pos - result.floor) * result.direction;
+	float u = velocity * result.direction;
+	if(h < 0.0f) {
+		h = 0.0f;
+	}
+	if(h > length) {
+		h = length;
+	}
+	result.rest = result.floor + result.direction*h;
+
+	if(result.g < 1e-3f) {
+		// No acceleration: a triangle wave between the walls.
+		float speed = fabsf(u);
+		result.floorSpeed = speed;
+		result.topSpeed = speed;
+		result.top = length;
+		result.halfPeriod = (speed > 0.0f) ? (length / speed) : 0.0f;
+		result.period = 2.0f * result.halfPeriod;
+		if(speed > 0.0f) {
+			result.phase = (u >= 0.0f) ? (h / speed) : (result.halfPeriod + (length - h) / speed);
+		}
+		return result;
+	}
+
+	result.floorSpeed = sqrtf(u*u + 2.0f*result.g*h);
+
+	float apex = (result.floorSpeed * result.floorSpeed) / (2.0f * result.g);
+	if(apex > length) {
+		result.top = length;
+		result.topSpeed = sqrtf(result.floorSpeed*result.floorSpeed - 2.0f*result.g*length);
+	}
+	else {
+		result.top = apex;
+		result.topSpeed = 0.0f;
+	}
+
+	// Rising from the floor and falling back take the same time.
+	result.halfPeriod = (result.floorSpeed - result.topSpeed) / result.g;
+	result.period = 2.0f * result.halfPeriod;
+	if(u >= 0.0f) {
+		result.phase = (result.floorSpeed - u) / result.g;
+	}
+	else {
+		result.phase = result.halfPeriod + (-u - result.topSpeed) / result.g;
+	}
+
+	return result;
+}
+
+inline float orbitHeightAtPhase(bounce_orbit *orbit, float phase) {
+	float result;
+	if(phase < orbit->halfPeriod) {
+		result = orbit->floorSpeed*phase - 0.5f*orbit->g*phase*phase;
+	}
+	else {
+		float t = phase - orbit->halfPeriod;
+		result = orbit->top - (orbit->topSpeed*t + 0.5f*orbit->g*t*t);
+	}
+	return result;
+}
+
+float orbitPositionAt(bounce_orbit *orbit, float time) {
+	if(orbit->period <= 0.0f) {
+		return orbit->rest;
+	}
+
+	float phase = fmodf(orbit->phase + time, orbit->period);
+	float result = orbit->floor + orbit->direction*orbitHeightAtPhase(orbit, phase);
+	return result;
+}
+
+// Time until the ball next passes `pos`, or -1 if it never gets there.
+float orbitTimeToReach(bounce_orbit *orbit, float pos) {
+	float h = (pos - orbit->floor) * orbit->direction;
+	if(h < 0.0f || h > orbit->top || orbit->period <= 0.0f) {
+		return -1.0f;
+	}
+
+	// The two phases inside one period where the height equals h: once on the
+	// way up, once on the way back down.
+	float rising, falling;
+	if(orbit->g < 1e-3f) {
+		rising = h / orbit->floorSpeed;
+		falling = orbit->halfPeriod + (orbit->top - h) / orbit->topSpeed;
+	}
+	else {
+		float up = orbit->floorSpeed*orbit->floorSpeed - 2.0f*orbit->g*h;
+		float down = orbit->topSpeed*orbit->topSpeed + 2.0f*orbit->g*(orbit->top - h);
+		rising = (orbit->floorSpeed - sqrtf((up > 0.0f) ? up : 0.0f)) / orbit->g;
+		falling = orbit->halfPeriod + (sqrtf(down) - orbit->topSpeed) / orbit->g;
+	}
+
+	float untilRising = fmodf(rising - orbit->phase + orbit->period, orbit->period);
+	float untilFalling = fmodf(falling - orbit->phase + orbit->period, orbit->period);
+	if(untilRising < 0.0f) {
+		untilRising += orbit->period;
+	}
+	if(untilFalling < 0.0f) {
+		untilFalling += orbit->period;
+	}
+
+	float result = (untilRising < untilFalling) ? untilRising : untilFalling;
+	return result;
+}
+
+// Where the ball's center will be vertically when it next reaches x, using
+// the same motion update() integrates: constant acceleration plus
+// reflections off the arena walls. Returns false if it never gets there.
+bool predictBallAtX(game_state *gameState, bot_observation *ball, float x, float *y, float *time) {
+	v2 acceleration = gameState->ballAcceleration;
+	v2 halfSize = 0.5f * gameState->ball.size;
+
+	bounce_orbit horizontal = makeBounceOrbit(halfSize.x, gameState->arenaWidth - halfSize.x,
+	                                          ball->pos.x, ball->velocity.x, acceleration.x);
+	float t = orbitTimeToReach(&horizontal, x);
+	if(t < 0.0f) {
+		return false;
+	}
+
+	bounce_orbit vertical = makeBounceOrbit(halfSize.y, gameState->arenaHeight - halfSize.y,
+	                                        ball->pos.y, ball->velocity.y, acceleration.y);
+	*y = orbitPositionAt(&vertical, t);
+	*time = t;
+
+	return true;
+}
+
+void initBot(bot_state *bot, bot_difficulty difficulty, u32 seed) {
+	*bot = {};
+	bot->active = true;
+	bot->difficulty = difficulty;
+	bot->random = seed ? seed : 0x9E3779B9;
+}
+
+inline void setBotButton(button_state *button, bool down, float fraction) {
+	button->halfTransitionCount = (button->endedDown != down) ? 1 : 0;
+	button->endedDown = down;
+	button->heldFraction = down ? fraction : 0.0f;
+}
+
+// Overwrites gameState->input[playerIndex] for the step of length dt that is
+// about to run.
+void botDecide(bot_state *bot, game_state *gameState, u32 playerIndex, float dt) {
+	bot_observation *observation = bot->history + (bot->observed++ & (Bot_History_Size - 1));
+	observation->pos = gameState->ball.pos;
+	observation->velocity = gameState->ball.velocity;
+
+	player *paddle = gameState->players + playerIndex;
+
+	if(bot->ticksUntilReplan == 0) {
+		u32 delay = bot->difficulty.reactionTicks;
+		if(delay > bot->observed - 1) {
+			delay = bot->observed - 1;
+		}
+		bot_observation *seen = bot->history + ((bot->observed - 1 - delay) & (Bot_History_Size - 1));
+
+		// Aim for the ball center when it reaches the paddle's inner face.
+		float faceOffset = 0.5f*(paddle->size.x + gameState->ball.size.x);
+		float faceX = (paddle->pos.x < 0.5f*gameState->arenaWidth) ? (paddle->pos.x + faceOffset) : (paddle->pos.x - faceOffset);
+
+		float y, time;
+		if(predictBallAtX(gameState, seen, faceX, &y, &time)) {
+			bot->targetY = y + bot->difficulty.noise*time*randomGaussian(&bot->random);
+		}
+		else {
+			bot->targetY = 0.5f*gameState->arenaHeight;
+		}
+
+		float minY = 0.5f*paddle->size.y;
+		float maxY = gameState->arenaHeight - 0.5f*paddle->size.y;
+		bot->targetY = (bot->targetY < minY) ? minY : ((bot->targetY > maxY) ? maxY : bot->targetY);
+
+		bot->ticksUntilReplan = bot->difficulty.reactionTicks;
+	}
+	else {
+		--bot->ticksUntilReplan;
+	}
+
+	// Hold the key only for as much of the step as it takes to arrive, so the
+	// paddle settles on the target instead of oscillating around it.
+	float distance = bot->targetY - paddle->pos.y;
+	float reach = gameState->paddleSpeed * dt;
+	float fraction = 0.0f;
+	if(fabsf(distance) > bot->difficulty.deadZone && reach > 0.0f) {
+		fraction = fabsf(distance) / reach;
+		if(fraction > 1.0f) {
+			fraction = 1.0f;
+		}
+	}
+
+	program_input *input = gameState->input + playerIndex;
+	setBotButton(&input->up, (fraction > 0.0f) && (distance < 0.0f), fraction);
+	setBotButton(&input->down, (fraction > 0.0f) && (distance > 0.0f), fraction);
+}
+
+// Looks for "-bot0" / "-bot1" on the command line, optionally followed by
+// "=easy", "=medium", "=hard" or "=perfect".
+void parseBotOption(const char *commandLine, u32 playerIndex, bot_state *bot) {
+	char flag[] = "-botN";
+	flag[4] = (char)('0' + playerIndex);
+
+	const char *at = strstr(commandLine, flag);
+	if(!at) {
+		return;
+	}
+
+	bot_difficulty difficulty = globalBotDifficulties[1];
+	at += sizeof(flag) - 1;
+	if(*at == '=') {
+		++at;
+		if(strncmp(at, "easy", 4) == 0) {
+			difficulty = globalBotDifficulties[0];
+		}
+		else if(strncmp(at, "hard", 4) == 0) {
+			difficulty = globalBotDifficulties[2];
+		}
+		else if(strncmp(at, "perfect", 7) == 0) {
+			difficulty = globalBotDifficulties[3];
+		}
+	}
+
+	initBot(bot, difficulty, 0x1234567 + playerIndex);
+}
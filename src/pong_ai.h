@@ -0,0 +1,59 @@
+#ifndef PONG_AI_H
+#define PONG_AI_H
+
+// Must be a power of two larger than any reactionTicks
+#define Bot_History_Size 32
+
+struct bot_difficulty {
+	// The bot plans from the ball as it was this many ticks ago and only
+	// re-plans this often.
+	u32 reactionTicks;
+
+	// Aim error, in pixels per second of predicted ball flight.
+	float noise;
+
+	// The paddle stays put while it is this close to the target.
+	float deadZone;
+};
+
+struct bot_observation {
+	v2 pos;
+	v2 velocity;
+};
+
+struct bot_state {
+	bool active;
+	bot_difficulty difficulty;
+
+	u32 random;
+	u32 ticksUntilReplan;
+	float targetY;
+
+	u32 observed;
+	bot_observation history[Bot_History_Size];
+};
+
+// Motion along one axis under constant acceleration between two walls with
+// perfectly elastic reflections. It is periodic, so it can be described by
+// one period measured from the moment the ball leaves the wall the
+// acceleration pushes it towards ("floor"), plus where in that period it is.
+struct bounce_orbit {
+	float g;
+	float floor;
+	float direction;
+
+	// Highest point reached (the other wall or the apex) and the speeds at
+	// the floor and at that point.
+	float top;
+	float floorSpeed;
+	float topSpeed;
+
+	float halfPeriod;
+	float period;
+	float phase;
+
+	// Where the ball sits if it isn't moving at all (period is 0)
+	float rest;
+};
+
+#endif
@@ -0,0 +1,68 @@
+// Cost of update() per game for each arena preset's specialized kernel
+// against the generic kernel running the same configuration, over a batch
+// of games in play.
+//
+//   pong_arena_bench [games] [ticks]
+
+#include "pong_game.h"
+#include "pong_bench.h"
+#include "pong_game.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Every game served in a random direction with a paddle key held on each
+// side, so points, wall bounces and paddle hits all happen.
+static void setupGames(game_state *games, u32 count, arena_config *config, bool generic) {
+	u32 random = 1234;
+	for(u32 i=0; i < count; ++i) {
+		game_state *gameState = games + i;
+		initGameState(gameState, config);
+		if(generic) {
+			gameState->preset = ArenaCustom;
+		}
+		serveBall(gameState, (nextRandom(&random) & 1) ? 1.0f : -1.0f);
+		gameState->ball.velocity.y = (randomUnilateral(&random) - 0.5f) * 800.0f;
+		gameState->input[0].up.heldFraction = randomUnilateral(&random);
+		gameState->input[1].down.heldFraction = randomUnilateral(&random);
+	}
+}
+
+// Nanoseconds per update(), best of a few runs
+static double timeUpdates(game_state *games, u32 count, u32 ticks, arena_config *config, bool generic) {
+	float dt = 1.0f / Simulation_Hz;
+	double best = 0.0;
+	for(u32 run=0; run < 5; ++run) {
+		setupGames(games, count, config, generic);
+
+		double start = benchSeconds();
+		for(u32 tick=0; tick < ticks; ++tick) {
+			updateBatch(games, count, dt);
+		}
+		double seconds = benchSeconds() - start;
+		if(run == 0 || seconds < best) {
+			best = seconds;
+		}
+	}
+	return (best * 1e9) / ((double)count * ticks);
+}
+
+int main(int argc, char **argv) {
+	u32 count = (argc > 1) ? (u32)atoi(argv[1]) : 1024;
+	u32 ticks = (argc > 2) ? (u32)atoi(argv[2]) : 1000;
+	if(count == 0) {
+		count = 1;
+	}
+
+	game_state *games = (game_state *)calloc(count, sizeof(game_state));
+
+	printf("%10s %14s %14s %8s\n", "PRESET", "SPECIAL NS", "GENERIC NS", "RATIO");
+	for(u32 preset=0; preset < Arena_Preset_Count; ++preset) {
+		arena_config *config = globalArenaPresets + preset;
+		double special = timeUpdates(games, count, ticks, config, false);
+		double generic = timeUpdates(games, count, ticks, config, true);
+		printf("%10s %14.2f %14.2f %8.2f\n", globalArenaPresetNames[preset], special, generic, generic / special);
+	}
+
+	return 0;
+}
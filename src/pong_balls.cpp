@@ -0,0 +1,272 @@
+// Everything is stored structure-of-arrays so the integrate and wall passes
+// are straight loops over floats.
+
+void initBallPool(ball_pool *pool, memory_arena *arena, u32 capacity, float size,
+                  u32 arenaWidth, u32 arenaHeight) {
+	*pool = {};
+	pool->capacity = (capacity < Max_Pool_Balls) ? capacity : Max_Pool_Balls;
+	pool->size = size;
+
+	pool->x = pushArray(arena, pool->capacity, float);
+	pool->y = pushArray(arena, pool->capacity, float);
+	pool->prevX = pushArray(arena, pool->capacity, float);
+	pool->prevY = pushArray(arena, pool->capacity, float);
+	pool->velocityX = pushArray(arena, pool->capacity, float);
+	pool->velocityY = pushArray(arena, pool->capacity, float);
+
+	pool->cellSize = (size > 4.0f) ? size : 4.0f;
+	pool->cellsX = (u32)((float)arenaWidth / pool->cellSize) + 1;
+	pool->cellsY = (u32)((float)arenaHeight / pool->cellSize) + 1;
+	pool->cellStart = pushArray(arena, pool->cellsX*pool->cellsY + 1, u32);
+	pool->ballCell = pushArray(arena, pool->capacity, u32);
+	pool->order = pushArray(arena, pool->capacity, u32);
+	pool->scratch = pushArray(arena, pool->capacity, float);
+}
+
+// Full size until the balls would cover more than about a quarter of the
+// arena, then shrinking so they don't just pile up.
+float ballPoolSize(u32 count, game_state *gameState) {
+	float size = sqrtf(0.25f*gameState->arenaWidth*gameState->arenaHeight / (float)(count ? count : 1));
+	return (size < gameState->ball.size.x) ? size : gameState->ball.size.x;
+}
+
+// Looks for "-balls=N" on the command line; 0 if it isn't there.
+u32 parseBallsOption(const char *commandLine) {
+	const char *at = strstr(commandLine, "-balls=");
+	if(!at) {
+		return 0;
+	}
+
+	u32 count = (u32)atoi(at + 7);
+	return (count < Max_Pool_Balls) ? count : Max_Pool_Balls;
+}
+
+// Scatters count balls (up to capacity) over the arena at random speeds.
+void spawnBalls(ball_pool *pool, u32 count, u32 arenaWidth, u32 arenaHeight, u32 seed) {
+	u32 random = seed ? seed : 1;
+	pool->count = (count < pool->capacity) ? count : pool->capacity;
+
+	float half = 0.5f*pool->size;
+	for(u32 i=0; i < pool->count; ++i) {
+		pool->x[i] = half + randomUnilateral(&random)*(arenaWidth - pool->size);
+		pool->y[i] = half + randomUnilateral(&random)*(arenaHeight - pool->size);
+		pool->prevX[i] = pool->x[i];
+		pool->prevY[i] = pool->y[i];
+
+		float angle = 6.2831853f*randomUnilateral(&random);
+		float speed = 200.0f + 400.0f*randomUnilateral(&random);
+		pool->velocityX[i] = speed*cosf(angle);
+		pool->velocityY[i] = speed*sinf(angle);
+	}
+}
+
+inline void collideBallPair(ball_pool *pool, u32 a, u32 b) {
+	float dx = pool->x[a] - pool->x[b];
+	float dy = pool->y[a] - pool->y[b];
+	float distanceSquared = dx*dx + dy*dy;
+	float diameter = pool->size;
+	if(distanceSquared >= diameter*diameter || distanceSquared <= 0.0f) {
+		return;
+	}
+
+	float distance = sqrtf(distanceSquared);
+	float nx = dx / distance;
+	float ny = dy / distance;
+
+	// Equal masses: exchange the velocity components along the normal, but
+	// only while they're still closing.
+	float closing = (pool->velocityX[a] - pool->velocityX[b])*nx + (pool->velocityY[a] - pool->velocityY[b])*ny;
+	if(closing < 0.0f) {
+		pool->velocityX[a] -= closing*nx;
+		pool->velocityY[a] -= closing*ny;
+		pool->velocityX[b] += closing*nx;
+		pool->velocityY[b] += closing*ny;
+	}
+
+	float push = 0.5f*(diameter - distance);
+	pool->x[a] += push*nx;
+	pool->y[a] += push*ny;
+	pool->x[b] -= push*nx;
+	pool->y[b] -= push*ny;
+
+	++pool->contacts;
+}
+
+static void buildBallGrid(ball_pool *pool) {
+	u32 cellCount = pool->cellsX*pool->cellsY;
+	float inverseCell = 1.0f / pool->cellSize;
+	float maxX = (float)(pool->cellsX - 1);
+	float maxY = (float)(pool->cellsY - 1);
+	memset(pool->cellStart, 0, (cellCount + 1)*sizeof(u32));
+
+	for(u32 i=0; i < pool->count; ++i) {
+		// Clamped while still a float: a ball pushed just outside the arena
+		// can be negative, and converting that to u32 is undefined.
+		float fx = pool->x[i]*inverseCell;
+		float fy = pool->y[i]*inverseCell;
+		fx = (fx > 0.0f) ? fx : 0.0f;
+		fy = (fy > 0.0f) ? fy : 0.0f;
+		u32 cx = (u32)((fx < maxX) ? fx : maxX);
+		u32 cy = (u32)((fy < maxY) ? fy : maxY);
+
+		u32 cell = cy*pool->cellsX + cx;
+		pool->ballCell[i] = cell;
+		++pool->cellStart[cell + 1];
+	}
+
+	for(u32 cell=0; cell < cellCount; ++cell) {
+		pool->cellStart[cell + 1] += pool->cellStart[cell];
+	}
+
+	// Placing balls advances each cell's start to its end, which is where the
+	// next cell starts; shift back afterwards.
+	for(u32 i=0; i < pool->count; ++i) {
+		pool->order[pool->cellStart[pool->ballCell[i]]++] = i;
+	}
+	for(u32 cell=cellCount; cell > 0; --cell) {
+		pool->cellStart[cell] = pool->cellStart[cell - 1];
+	}
+	pool->cellStart[0] = 0;
+
+	// Balls mostly stay in the same cell from tick to tick, so after the first
+	// sort this gather is close to a straight copy.
+	float **arrays[] = {&pool->x, &pool->y, &pool->prevX, &pool->prevY, &pool->velocityX, &pool->velocityY};
+	for(u32 a=0; a < arrayCount(arrays); ++a) {
+		float *source = *arrays[a];
+		float *sorted = pool->scratch;
+		for(u32 i=0; i < pool->count; ++i) {
+			sorted[i] = source[pool->order[i]];
+		}
+		*arrays[a] = sorted;
+		pool->scratch = source;
+	}
+}
+
+// Every pair is visited once: within a cell, then against the cell to the
+// right and the three below.
+static void collideBallGrid(ball_pool *pool) {
+	for(u32 cy=0; cy < pool->cellsY; ++cy) {
+		for(u32 cx=0; cx < pool->cellsX; ++cx) {
+			u32 cell = cy*pool->cellsX + cx;
+			u32 first = pool->cellStart[cell];
+			u32 last = pool->cellStart[cell + 1];
+			if(first == last) {
+				continue;
+			}
+
+			u32 neighbors[4];
+			u32 neighborCount = 0;
+			if(cx + 1 < pool->cellsX) {
+				neighbors[neighborCount++] = cell + 1;
+			}
+			if(cy + 1 < pool->cellsY) {
+				if(cx > 0) {
+					neighbors[neighborCount++] = cell + pool->cellsX - 1;
+				}
+				neighbors[neighborCount++] = cell + pool->cellsX;
+				if(cx + 1 < pool->cellsX) {
+					neighbors[neighborCount++] = cell + pool->cellsX + 1;
+				}
+			}
+
+			for(u32 a=first; a < last; ++a) {
+				for(u32 b=a + 1; b < last; ++b) {
+					collideBallPair(pool, a, b);
+				}
+				pool->pairTests += last - a - 1;
+
+				for(u32 n=0; n < neighborCount; ++n) {
+					u32 otherFirst = pool->cellStart[neighbors[n]];
+					u32 otherLast = pool->cellStart[neighbors[n] + 1];
+					for(u32 b=otherFirst; b < otherLast; ++b) {
+						collideBallPair(pool, a, b);
+					}
+					pool->pairTests += otherLast - otherFirst;
+				}
+			}
+		}
+	}
+}
+
+// Reference for checking the grid: tests every pair.
+static void collideBallsBruteForce(ball_pool *pool) {
+	for(u32 a=0; a < pool->count; ++a) {
+		for(u32 b=a + 1; b < pool->count; ++b) {
+			collideBallPair(pool, a, b);
+		}
+	}
+	pool->pairTests += (u64)pool->count*(pool->count - 1) / 2;
+}
+
+// Same motion as update() gives the real ball, then walls and the paddles in
+// gameState.
+void moveBallPool(ball_pool *pool, game_state *gameState, float dt) {
+	v2 acceleration = gameState->ballAcceleration;
+	float half = 0.5f*pool->size;
+	float minX = half;
+	float maxX = gameState->arenaWidth - half;
+	float minY = half;
+	float maxY = gameState->arenaHeight - half;
+
+	for(u32 i=0; i < pool->count; ++i) {
+		pool->prevX[i] = pool->x[i];
+		pool->prevY[i] = pool->y[i];
+
+		float vx = pool->velocityX[i] + dt*acceleration.x;
+		float vy = pool->velocityY[i] + dt*acceleration.y;
+		float x = pool->x[i] + dt*vx;
+		float y = pool->y[i] + dt*vy;
+
+		if(x < minX) {
+			x = 2.0f*minX - x;
+			vx = -vx;
+		}
+		if(x > maxX) {
+			x = 2.0f*maxX - x;
+			vx = -vx;
+		}
+		if(y < minY) {
+			y = 2.0f*minY - y;
+			vy = -vy;
+		}
+		if(y > maxY) {
+			y = 2.0f*maxY - y;
+			vy = -vy;
+		}
+
+		pool->x[i] = x;
+		pool->y[i] = y;
+		pool->velocityX[i] = vx;
+		pool->velocityY[i] = vy;
+	}
+
+	// The same swept face test update() uses for the real ball
+	for(int p=0; p < 2; ++p) {
+		player *paddle = gameState->players + p;
+		float side = (paddle->pos.x < 0.5f*gameState->arenaWidth) ? 1.0f : -1.0f;
+		float face = paddle->pos.x + side*0.5f*(paddle->size.x + pool->size);
+		float reach = 0.5f*(paddle->size.y + pool->size);
+
+		for(u32 i=0; i < pool->count; ++i) {
+			float before = (pool->prevX[i] - face) * side;
+			float after = (pool->x[i] - face) * side;
+			if(before >= 0.0f && after < 0.0f) {
+				float t = before / (before - after);
+				float y = pool->prevY[i] + t*(pool->y[i] - pool->prevY[i]);
+				if(fabsf(y - paddle->pos.y) < reach) {
+					pool->x[i] = face - side*after;
+					pool->velocityX[i] = -pool->velocityX[i];
+				}
+			}
+		}
+	}
+}
+
+void updateBallPool(ball_pool *pool, game_state *gameState, float dt) {
+	moveBallPool(pool, gameState, dt);
+
+	pool->pairTests = 0;
+	pool->contacts = 0;
+	buildBallGrid(pool);
+	collideBallGrid(pool);
+}
@@ -0,0 +1,43 @@
+#ifndef PONG_BALLS_H
+#define PONG_BALLS_H
+
+// Stress mode: a pool of extra balls that bounce off the walls, the paddles
+// and each other. They don't score; they exist to load the physics and the
+// renderer.
+
+#define Max_Pool_Balls 100000
+
+struct ball_pool {
+	u32 count;
+	u32 capacity;
+
+	// Balls are squares of this size against walls and paddles and circles
+	// of this diameter against each other.
+	float size;
+
+	float *x;
+	float *y;
+	float *prevX;
+	float *prevY;
+	float *velocityX;
+	float *velocityY;
+
+	// Uniform grid broadphase, rebuilt every tick with a counting sort that
+	// also reorders the ball arrays, so each cell's balls are a contiguous
+	// range [cellStart[cell], cellStart[cell + 1]). Cells are at least one
+	// ball wide, so a ball can only touch balls in its own cell and the eight
+	// around it.
+	float cellSize;
+	u32 cellsX;
+	u32 cellsY;
+	u32 *cellStart;
+	u32 *ballCell;
+	u32 *order;
+	float *scratch;
+
+	// From the last tick
+	u64 pairTests;
+	u32 contacts;
+};
+
+#endif
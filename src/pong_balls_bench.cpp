@@ -0,0 +1,75 @@
+// Ticks per second of the many-ball stress mode against ball count, with
+// the all-pairs test alongside for the counts where it finishes.
+//
+//   pong_balls_bench [max balls] [ticks per count]
+
+#include "pong_game.h"
+#include "pong_bench.h"
+#include "pong_game.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Past this the all-pairs test takes longer than is worth waiting for
+#define Max_Brute_Force_Balls 8000
+
+static double runTicks(ball_pool *pool, game_state *gameState, u32 ticks, bool bruteForce, u64 *pairTests) {
+	float dt = 1.0f / Simulation_Hz;
+	*pairTests = 0;
+
+	double start = benchSeconds();
+	for(u32 tick=0; tick < ticks; ++tick) {
+		if(bruteForce) {
+			moveBallPool(pool, gameState, dt);
+			pool->pairTests = 0;
+			pool->contacts = 0;
+			collideBallsBruteForce(pool);
+		}
+		else {
+			updateBallPool(pool, gameState, dt);
+		}
+		*pairTests += pool->pairTests;
+	}
+	return benchSeconds() - start;
+}
+
+int main(int argc, char **argv) {
+	u32 maxBalls = (argc > 1) ? (u32)atoi(argv[1]) : Max_Pool_Balls;
+	u32 ticks = (argc > 2) ? (u32)atoi(argv[2]) : 120;
+	if(maxBalls > Max_Pool_Balls) {
+		maxBalls = Max_Pool_Balls;
+	}
+
+	size_t size = megabytes(64);
+	void *memory = calloc(1, size);
+	memory_arena arena;
+
+	game_state gameState = {};
+	initGameState(&gameState, globalArenaPresets + ArenaStandard);
+
+	u32 counts[] = {100, 1000, 2000, 5000, 10000, 20000, 50000, 100000};
+	printf("%8s %6s %12s %14s %12s %14s\n", "BALLS", "SIZE", "GRID TICK/S", "GRID PAIRS", "ALL TICK/S", "ALL PAIRS");
+	for(u32 c=0; c < arrayCount(counts) && counts[c] <= maxBalls; ++c) {
+		u32 count = counts[c];
+		float ballSize = ballPoolSize(count, &gameState);
+
+		initArena(&arena, memory, size);
+		ball_pool *pool = pushStruct(&arena, ball_pool);
+		initBallPool(pool, &arena, count, ballSize, gameState.arenaWidth, gameState.arenaHeight);
+
+		spawnBalls(pool, count, gameState.arenaWidth, gameState.arenaHeight, 1234);
+		u64 gridPairs;
+		double gridSeconds = runTicks(pool, &gameState, ticks, false, &gridPairs);
+
+		printf("%8u %6.2f %12.0f %14.0f", count, ballSize, ticks / gridSeconds, (double)gridPairs / ticks);
+		if(count <= Max_Brute_Force_Balls) {
+			spawnBalls(pool, count, gameState.arenaWidth, gameState.arenaHeight, 1234);
+			u64 allPairs;
+			double allSeconds = runTicks(pool, &gameState, ticks, true, &allPairs);
+			printf(" %12.0f %14.0f", ticks / allSeconds, (double)allPairs / ticks);
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,25 @@
+#ifndef PONG_BENCH_H
+#define PONG_BENCH_H
+
+// The wall clock every benchmark times itself with.
+
+#if defined(_WIN32)
+#include <windows.h>
+
+static double benchSeconds() {
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+#else
+#include <time.h>
+
+static double benchSeconds() {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + 1e-9*(double)now.tv_nsec;
+}
+#endif
+
+#endif
@@ -0,0 +1,282 @@
+// See pong_capture.h.
+
+#include <emmintrin.h>
+
+// BT.601 studio range, in the 8-bit integer form most encoders use:
+//   Y = ((66R + 129G + 25B + 128) >> 8) + 16
+//   U = ((-38R - 74G + 112B + 128) >> 8) + 128
+//   V = ((112R - 94G - 18B + 128) >> 8) + 128
+// with U and V taken from the rounded average of each 2x2 block.
+inline u8 lumaOf(u32 r, u32 g, u32 b) {
+	return (u8)(((66*r + 129*g + 25*b + 128) >> 8) + 16);
+}
+
+inline void chromaOf(s32 r, s32 g, s32 b, u8 *u, u8 *v) {
+	*u = (u8)(((-38*r - 74*g + 112*b + 128) >> 8) + 128);
+	*v = (u8)(((112*r - 94*g - 18*b + 128) >> 8) + 128);
+}
+
+// Eight 0xAARRGGBB pixels spread into 16-bit lanes, one register per channel.
+inline void unpackChannels(__m128i pixels0, __m128i pixels1, __m128i *r, __m128i *g, __m128i *b) {
+	__m128i mask = _mm_set1_epi32(0xFF);
+	*b = _mm_packs_epi32(_mm_and_si128(pixels0, mask), _mm_and_si128(pixels1, mask));
+	*g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(pixels0, 8), mask),
+	                     _mm_and_si128(_mm_srli_epi32(pixels1, 8), mask));
+	*r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(pixels0, 16), mask),
+	                     _mm_and_si128(_mm_srli_epi32(pixels1, 16), mask));
+}
+
+// The luma sum tops out at 56228, so it's done in unsigned 16-bit lanes:
+// mullo's wrapped products still add up to the right low 16 bits.
+inline __m128i lumaOf(__m128i r, __m128i g, __m128i b) {
+	__m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)),
+	                                          _mm_mullo_epi16(g, _mm_set1_epi16(129))),
+	                            _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), _mm_set1_epi16(128)));
+	return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+}
+
+// Channel sums over two rows of 16 pixels (each register one row's 8) down to
+// the 8 block averages.
+inline __m128i blockAverage(__m128i top0, __m128i bottom0, __m128i top1, __m128i bottom1) {
+	__m128i ones = _mm_set1_epi16(1);
+	__m128i sum0 = _mm_madd_epi16(_mm_add_epi16(top0, bottom0), ones);
+	__m128i sum1 = _mm_madd_epi16(_mm_add_epi16(top1, bottom1), ones);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(sum0, sum1), _mm_set1_epi16(2)), 2);
+}
+
+// Chroma stays within +-28688 before the shift, so signed 16-bit lanes hold it.
+inline __m128i chromaOf(__m128i r, __m128i g, __m128i b, s16 weightR, s16 weightG, s16 weightB) {
+	__m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(weightR)),
+	                                          _mm_mullo_epi16(g, _mm_set1_epi16(weightG))),
+	                            _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(weightB)), _mm_set1_epi16(128)));
+	return _mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(128));
+}
+
+// A pair of rows at a time: 16 pixels across both make 32 luma and 8 of each
+// chroma sample per step, and a scalar tail finishes rows that aren't a
+// multiple of 16. image's width and height must be even.
+void convertToYUV420(pixel_image *image, u8 *lumaPlane, u8 *uPlane, u8 *vPlane) {
+	u32 width = (u32)image->width;
+	u32 chromaWidth = width / 2;
+	for(u32 y=0; y < (u32)image->height; y += 2) {
+		u32 *top = (u32 *)((u8 *)image->memory + y*image->pitch);
+		u32 *bottom = (u32 *)((u8 *)top + image->pitch);
+		u8 *lumaTop = lumaPlane + y*width;
+		u8 *lumaBottom = lumaTop + width;
+		u8 *u = uPlane + (y/2)*chromaWidth;
+		u8 *v = vPlane + (y/2)*chromaWidth;
+
+		u32 x = 0;
+		for(; x + 16 <= width; x += 16) {
+			__m128i r[4], g[4], b[4];
+			unpackChannels(_mm_loadu_si128((__m128i *)(top + x)), _mm_loadu_si128((__m128i *)(top + x + 4)),
+			               r + 0, g + 0, b + 0);
+			unpackChannels(_mm_loadu_si128((__m128i *)(top + x + 8)), _mm_loadu_si128((__m128i *)(top + x + 12)),
+			               r + 1, g + 1, b + 1);
+			unpackChannels(_mm_loadu_si128((__m128i *)(bottom + x)), _mm_loadu_si128((__m128i *)(bottom + x + 4)),
+			               r + 2, g + 2, b + 2);
+			unpackChannels(_mm_loadu_si128((__m128i *)(bottom + x + 8)), _mm_loadu_si128((__m128i *)(bottom + x + 12)),
+			               r + 3, g + 3, b + 3);
+
+			_mm_storeu_si128((__m128i *)(lumaTop + x), _mm_packus_epi16(lumaOf(r[0], g[0], b[0]),
+			                                                             lumaOf(r[1], g[1], b[1])));
+			_mm_storeu_si128((__m128i *)(lumaBottom + x), _mm_packus_epi16(lumaOf(r[2], g[2], b[2]),
+			                                                                lumaOf(r[3], g[3], b[3])));
+
+			__m128i averageR = blockAverage(r[0], r[2], r[1], r[3]);
+			__m128i averageG = blockAverage(g[0], g[2], g[1], g[3]);
+			__m128i averageB = blockAverage(b[0], b[2], b[1], b[3]);
+			__m128i chromaU = chromaOf(averageR, averageG, averageB, -38, -74, 112);
+			__m128i chromaV = chromaOf(averageR, averageG, averageB, 112, -94, -18);
+			_mm_storel_epi64((__m128i *)(u + x/2), _mm_packus_epi16(chromaU, chromaU));
+			_mm_storel_epi64((__m128i *)(v + x/2), _mm_packus_epi16(chromaV, chromaV));
+		}
+
+		for(; x < width; x += 2) {
+			u32 pixels[4] = {top[x], top[x + 1], bottom[x], bottom[x + 1]};
+			u32 sumR = 0, sumG = 0, sumB = 0;
+			for(u32 i=0; i < 4; ++i) {
+				u32 r = (pixels[i] >> 16) & 0xFF;
+				u32 g = (pixels[i] >> 8) & 0xFF;
+				u32 b = pixels[i] & 0xFF;
+				sumR += r;
+				sumG += g;
+				sumB += b;
+				(i < 2 ? lumaTop : lumaBottom)[x + (i & 1)] = lumaOf(r, g, b);
+			}
+			chromaOf((s32)((sumR + 2) >> 2), (s32)((sumG + 2) >> 2), (s32)((sumB + 2) >> 2),
+			         u + x/2, v + x/2);
+		}
+	}
+}
+
+// Drains the ring one frame per signal until asked to stop. A failed write
+// stops writing but not draining, so the render thread never backs up.
+static THREAD_PROC(captureWriterProc) {
+	video_capture *capture = (video_capture *)parameter;
+	u32 lumaSize = capture->width*capture->height;
+	u32 chromaSize = lumaSize / 4;
+	u8 *luma = capture->record + 6;
+
+	for(;;) {
+		waitSemaphore(&capture->frameReady);
+
+		u32 completed = capture->completed;
+		if(completed == atomicLoadU32(&capture->submitted)) {
+			if(atomicLoadU32(&capture->stopping)) {
+				break;
+			}
+			continue;
+		}
+
+		if(!capture->writeFailed) {
+			pixel_image *frame = capture->frames + (completed & (Capture_Ring_Frames - 1));
+			convertToYUV420(frame, luma, luma + lumaSize, luma + lumaSize + chromaSize);
+			if(platformWriteOutputFile(&capture->file, capture->record, capture->recordSize)) {
+				++capture->written;
+			}
+			else {
+				capture->writeFailed = true;
+			}
+		}
+		atomicStoreU32(&capture->completed, completed + 1);
+	}
+
+	return 0;
+}
+
+// "-capture=FILE" records the software renderer's frames to FILE. path gets
+// the file name, up to the next space.
+bool parseCaptureOption(const char *commandLine, char *path, u32 pathSize) {
+	const char *at = strstr(commandLine, "-capture=");
+	if(!at || pathSize == 0) {
+		return false;
+	}
+
+	at += 9;
+	u32 length = 0;
+	while(at[length] && at[length] != ' ' && length + 1 < pathSize) {
+		path[length] = at[length];
+		++length;
+	}
+	path[length] = 0;
+	return length > 0;
+}
+
+// Frames are width x height (rounded down to even) at rate per second.
+// Everything is allocated and the stream header written up front.
+bool startCapture(video_capture *capture, const char *path, u32 width, u32 height, u32 rate) {
+	*capture = {};
+	width &= ~1u;
+	height &= ~1u;
+	if(width == 0 || height == 0) {
+		return false;
+	}
+
+	capture->file = platformCreateOutputFile(path);
+	if(!capture->file.valid) {
+		return false;
+	}
+
+	char header[128];
+	formatText(header, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", width, height, rate);
+	if(!platformWriteOutputFile(&capture->file, header, (u32)strlen(header))) {
+		platformCloseOutputFile(&capture->file);
+		return false;
+	}
+
+	capture->width = width;
+	capture->height = height;
+	capture->rate = rate;
+
+	s32 pitch = Align16((s32)width*4);
+	size_t frameSize = (size_t)pitch*height;
+	capture->recordSize = 6 + width*height + 2*(width/2)*(height/2);
+	capture->memorySize = Capture_Ring_Frames*frameSize + Align16(capture->recordSize) + scaleScratchSize(width);
+	capture->memory = platformAllocateMemory(capture->memorySize);
+	if(!capture->memory) {
+		platformCloseOutputFile(&capture->file);
+		return false;
+	}
+
+	u8 *at = (u8 *)capture->memory;
+	for(u32 i=0; i < Capture_Ring_Frames; ++i) {
+		pixel_image *frame = capture->frames + i;
+		frame->memory = at;
+		frame->width = (s32)width;
+		frame->height = (s32)height;
+		frame->pitch = pitch;
+		at += frameSize;
+	}
+	capture->record = at;
+	memcpy(capture->record, "FRAME\n", 6);
+	capture->scaleScratch = at + Align16(capture->recordSize);
+
+	initSemaphore(&capture->frameReady, Capture_Ring_Frames + 1);
+	capture->writer = startThread(captureWriterProc, capture);
+	return true;
+}
+
+// For hosts that render at their own rate: whether a frame is due at
+// counter to keep the video at its rate. Frame times that went by without
+// one count as dropped.
+bool captureFrameDue(video_capture *capture, u64 counter, u64 frequency) {
+	u64 period = frequency / capture->rate;
+	if(capture->nextFrameTime == 0) {
+		capture->nextFrameTime = counter;
+	}
+	if(counter < capture->nextFrameTime) {
+		return false;
+	}
+
+	u64 missed = (counter - capture->nextFrameTime) / period;
+	capture->dropped += (u32)missed;
+	capture->nextFrameTime += (missed + 1)*period;
+	return true;
+}
+
+// The ring slot to draw the next frame into, or 0 (and one more dropped
+// frame) if the writer hasn't freed one yet. Never waits.
+pixel_image *beginCaptureFrame(video_capture *capture) {
+	if(capture->submitted - atomicLoadU32(&capture->completed) >= Capture_Ring_Frames) {
+		++capture->dropped;
+		return 0;
+	}
+	return capture->frames + (capture->submitted & (Capture_Ring_Frames - 1));
+}
+
+// For batch rendering, where there's no clock to keep up with: waits for a
+// free slot rather than drop the frame.
+pixel_image *waitForCaptureFrame(video_capture *capture) {
+	while(capture->submitted - atomicLoadU32(&capture->completed) >= Capture_Ring_Frames) {
+		platformSleep(1);
+	}
+	return capture->frames + (capture->submitted & (Capture_Ring_Frames - 1));
+}
+
+// Hands the slot from begin/waitForCaptureFrame to the writer.
+void endCaptureFrame(video_capture *capture) {
+	atomicStoreU32(&capture->submitted, capture->submitted + 1);
+	signalSemaphore(&capture->frameReady);
+}
+
+// Copies a finished frame into the ring, scaled up to the capture size if
+// it's smaller (dynamic resolution), or drops it.
+void captureFrame(video_capture *capture, pixel_image *source) {
+	pixel_image *frame = beginCaptureFrame(capture);
+	if(frame) {
+		scaleImage(source, frame, capture->scaleScratch);
+		endCaptureFrame(capture);
+	}
+}
+
+// Writes out whatever is still queued, then closes the file.
+void stopCapture(video_capture *capture) {
+	atomicStoreU32(&capture->stopping, 1);
+	signalSemaphore(&capture->frameReady);
+	joinThread(capture->writer);
+
+	platformCloseOutputFile(&capture->file);
+	platformFreeMemory(capture->memory, capture->memorySize);
+	capture->memory = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef PONG_CAPTURE_H
+#define PONG_CAPTURE_H
+
+// Raw video of rendered frames, streamed to disk as Y4M (YUV 4:2:0) by a
+// thread of its own. The render thread only copies a finished frame into
+// the next slot of a ring of preallocated frames and moves on; the writer
+// converts each one to YUV and writes it. If every slot is still waiting to
+// be written, the frame is dropped and counted instead of waited for.
+
+#include "pong_threads.h"
+#include "pong_scale.h"
+#include "pong_platform.h"
+
+// A power of two. Eight frames is over 100ms of slack at 60fps.
+#define Capture_Ring_Frames 8
+
+#define Max_Capture_Path 260
+
+struct video_capture {
+	platform_output_file file;
+
+	// Always even, as 4:2:0 needs
+	u32 width;
+	u32 height;
+	u32 rate;
+
+	// Frames (submitted - completed) are waiting for the writer; the rest of
+	// the ring belongs to the render thread. Both counts only ever increase
+	// and are masked on access, and the semaphore is signalled once per
+	// submitted frame (plus once to stop).
+	pixel_image frames[Capture_Ring_Frames];
+	u32 volatile submitted;
+	u32 volatile completed;
+	platform_semaphore frameReady;
+	platform_thread writer;
+	u32 volatile stopping;
+
+	// The writer's: one Y4M frame record, its header then the Y, U and V
+	// planes, so each frame is a single write.
+	u8 *record;
+	u32 recordSize;
+	u32 written;
+	bool writeFailed;
+
+	// The render thread's: scratch for scaling up frames smaller than the
+	// capture, and pacing for hosts that render at their own rate.
+	void *scaleScratch;
+	u64 nextFrameTime;
+	u32 dropped;
+
+	void *memory;
+	size_t memorySize;
+};
+
+#endif
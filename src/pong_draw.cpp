@@ -0,0 +1,272 @@
+// See pong_draw.h.
+
+#include <emmintrin.h>
+
+inline void makeRectFromCenterPoint(v2 vertices[], v2 centerPoint, v2 size) {
+	vertices[0] = V2(centerPoint.x - (0.5f * size.x), centerPoint.y - (0.5f * size.y));
+	vertices[1] = V2(centerPoint.x + (0.5f * size.x), centerPoint.y - (0.5f * size.y));
+	vertices[2] = V2(centerPoint.x + (0.5f * size.x), centerPoint.y + (0.5f * size.y));
+	vertices[3] = V2(centerPoint.x - (0.5f * size.x), centerPoint.y + (0.5f * size.y));
+}
+
+inline void drawRectangle(pixel_image *image, v2 vMin, v2 vMax, u32 color) {
+	// vMin should be vertices[0] and vMax should be vertices[2]. At least for now.
+	rectangle2i source = makeRectV2(vMin, vMax);
+	rectangle2i dest = Rect(0, 0, image->width, image->height);
+	rectangle2i clip = clipRect(source, dest);
+
+	u8 *row = ((u8 *)image->memory + (clip.minX*sizeof(u32)) + (clip.minY*image->pitch));
+	for(int y=clip.minY; y < clip.maxY; ++y) {
+		u32 *pixel = (u32 *)row;
+		for(int x=clip.minX; x < clip.maxX; ++x) {
+			*pixel++ = color;
+		}
+		row += image->pitch;
+	}
+}
+
+// Pixels between (minX, y) and (maxX, y) set to color, four at a time.
+inline void fillSpan(u32 *row, s32 minX, s32 maxX, u32 color) {
+	__m128i wide = _mm_set1_epi32((int)color);
+	s32 x = minX;
+	for(; x + 4 <= maxX; x += 4) {
+		_mm_storeu_si128((__m128i *)(row + x), wide);
+	}
+	for(; x < maxX; ++x) {
+		row[x] = color;
+	}
+}
+
+// Blends are (dest*(256 - weight) + color*weight + 128) >> 8 per channel,
+// which stays inside 16 bits for weights up to 256. That lets the scalar
+// blend do two channels per multiply and the SIMD one use unsigned 16-bit
+// lanes.
+inline u32 blendPixel(u32 dest, u32 color, u32 weight) {
+	u32 inverse = 256 - weight;
+	u32 redBlue = ((dest & 0x00FF00FF)*inverse + (color & 0x00FF00FF)*weight + 0x00800080) >> 8;
+	u32 alphaGreen = ((dest >> 8) & 0x00FF00FF)*inverse + ((color >> 8) & 0x00FF00FF)*weight + 0x00800080;
+	return (redBlue & 0x00FF00FF) | (alphaGreen & 0xFF00FF00);
+}
+
+inline void blendSpan(u32 *row, s32 minX, s32 maxX, u32 color, u32 weight) {
+	if(weight >= 256) {
+		fillSpan(row, minX, maxX, color);
+		return;
+	}
+
+	// color*weight + 128 is the same for every pixel
+	__m128i zero = _mm_setzero_si128();
+	__m128i colorTerm = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero),
+	                                                  _mm_set1_epi16((short)weight)),
+	                                  _mm_set1_epi16(128));
+	__m128i inverse = _mm_set1_epi16((short)(256 - weight));
+	s32 x = minX;
+	for(; x + 4 <= maxX; x += 4) {
+		__m128i dest = _mm_loadu_si128((__m128i *)(row + x));
+		__m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dest, zero), inverse), colorTerm), 8);
+		__m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dest, zero), inverse), colorTerm), 8);
+		_mm_storeu_si128((__m128i *)(row + x), _mm_packus_epi16(lo, hi));
+	}
+	for(; x < maxX; ++x) {
+		row[x] = blendPixel(row[x], color, weight);
+	}
+}
+
+// Coverage along one axis of a rectangle already clipped to [0, size): the
+// pixels it covers completely, and the partly covered pixel on either side
+// with its weight in 256ths (0 when there isn't one). A rectangle inside a
+// single pixel has only the leading one.
+struct coverage_span {
+	s32 fullMin, fullMax;
+	s32 leading, trailing;
+	u32 leadingWeight, trailingWeight;
+};
+
+inline coverage_span coverageSpan(float min, float max) {
+	coverage_span result;
+	s32 touchedMin = (s32)min;
+	result.fullMin = touchedMin + (((float)touchedMin < min) ? 1 : 0);
+	result.fullMax = (s32)max;
+	result.leading = touchedMin;
+	result.trailing = result.fullMax;
+
+	if(result.fullMin > result.fullMax) {
+		// Inside one pixel
+		result.leadingWeight = (u32)(256.0f*(max - min) + 0.5f);
+		result.trailingWeight = 0;
+		result.fullMin = result.fullMax = touchedMin + 1;
+	}
+	else {
+		result.leadingWeight = (u32)(256.0f*((float)result.fullMin - min) + 0.5f);
+		result.trailingWeight = (u32)(256.0f*(max - (float)result.fullMax) + 0.5f);
+	}
+	return result;
+}
+
+// One row of an anti-aliased rectangle, everything in it scaled by
+// rowWeight.
+inline void blendCoverageRow(u32 *row, coverage_span *columns, u32 color, u32 rowWeight) {
+	if(columns->leadingWeight) {
+		row[columns->leading] = blendPixel(row[columns->leading], color,
+		                                   (columns->leadingWeight*rowWeight + 128) >> 8);
+	}
+	blendSpan(row, columns->fullMin, columns->fullMax, color, rowWeight);
+	if(columns->trailingWeight) {
+		row[columns->trailing] = blendPixel(row[columns->trailing], color,
+		                                    (columns->trailingWeight*rowWeight + 128) >> 8);
+	}
+}
+
+// Anti-aliased: every pixel takes color in proportion to how much of it the
+// rectangle covers, which for an axis-aligned rectangle is the horizontal
+// overlap times the vertical one (as in renderObservation). Fully covered
+// rows and columns are the same plain fill drawRectangle does; only the
+// one-pixel border around them blends, so moving edges slide smoothly
+// instead of snapping a whole pixel at a time.
+void drawRectangleAA(pixel_image *image, v2 vMin, v2 vMax, u32 color) {
+	float minX = (vMin.x > 0.0f) ? vMin.x : 0.0f;
+	float minY = (vMin.y > 0.0f) ? vMin.y : 0.0f;
+	float maxX = (vMax.x < (float)image->width) ? vMax.x : (float)image->width;
+	float maxY = (vMax.y < (float)image->height) ? vMax.y : (float)image->height;
+	if(minX >= maxX || minY >= maxY) {
+		return;
+	}
+
+	coverage_span columns = coverageSpan(minX, maxX);
+	coverage_span rows = coverageSpan(minY, maxY);
+
+	u8 *base = (u8 *)image->memory;
+	if(rows.leadingWeight) {
+		blendCoverageRow((u32 *)(base + rows.leading*image->pitch), &columns, color, rows.leadingWeight);
+	}
+
+	u8 *row = base + rows.fullMin*image->pitch;
+	for(s32 y=rows.fullMin; y < rows.fullMax; ++y) {
+		blendCoverageRow((u32 *)row, &columns, color, 256);
+		row += image->pitch;
+	}
+
+	if(rows.trailingWeight) {
+		blendCoverageRow((u32 *)(base + rows.trailing*image->pitch), &columns, color, rows.trailingWeight);
+	}
+}
+
+inline void clearImage(pixel_image *image) {
+	u8 *row = (u8 *)image->memory;
+	for(int y=0; y < image->height; ++y) {
+		u32 *pixel = (u32 *)row;
+		for(int x=0; x < image->width; ++x) {
+			*pixel++ = 0x00000000;
+		}
+		row += image->pitch;
+	}
+}
+
+inline void drawSceneRectangle(pixel_image *image, v2 vMin, v2 vMax, u32 color) {
+#if ANTIALIASED_RECTANGLES
+	drawRectangleAA(image, vMin, vMax, color);
+#else
+	drawRectangle(image, vMin, vMax, color);
+#endif
+}
+
+// A sprite centered on center (in pixels). It's placed to a fraction of a
+// pixel, like drawRectangleAA() places the plain fills, so themed entities
+// move as smoothly as untextured ones.
+inline void drawSceneSprite(pixel_image *image, sprite_atlas *sprites, sprite_id id, v2 center) {
+	rectangle2i rect = sprites->sprites[id];
+	float x = center.x - 0.5f*(rect.maxX - rect.minX);
+	float y = center.y - 0.5f*(rect.maxY - rect.minY);
+	blitSpriteSubpixel(image, sprites, id, x, y);
+}
+
+// scale takes arena units to image pixels, as in drawSceneSoftware().
+void drawBallPoolSoftware(render_snapshot *snapshot, sprite_atlas *sprites, pixel_image *image, v2 scale,
+                          float offset) {
+	bool themed = sprites && spriteReady(sprites, SpritePoolBall);
+	v2 size = hadamard(scale, V2(snapshot->poolSize, snapshot->poolSize));
+	for(u32 i=0; i < snapshot->poolCount; ++i) {
+		v2 center = hadamard(scale, lerp(V2(snapshot->poolPrevX[i], snapshot->poolPrevY[i]), offset,
+		                                 V2(snapshot->poolX[i], snapshot->poolY[i])));
+		if(themed) {
+			drawSceneSprite(image, sprites, SpritePoolBall, center);
+		}
+		else {
+			v2 vertices[4];
+			makeRectFromCenterPoint(vertices, center, size);
+			drawSceneRectangle(image, vertices[0], vertices[2], 0xff8080ff);
+		}
+	}
+}
+
+void drawParticlesSoftware(particle_system *particles, pixel_image *image, v2 scale) {
+	u32 vertexCount = buildParticleVertices(particles);
+	for(u32 i=0; i < vertexCount; i += 4) {
+		particle_vertex *corner = particles->vertices + i;
+		rectangle2i clip = clipRect(makeRectV2(hadamard(scale, V2(corner[0].x, corner[0].y)),
+		                                       hadamard(scale, V2(corner[2].x, corner[2].y))),
+		                            Rect(0, 0, image->width, image->height));
+
+		u32 a = corner->a;
+		u32 r = corner->r*a;
+		u32 g = corner->g*a;
+		u32 b = corner->b*a;
+		u32 inverse = 255 - a;
+
+		u8 *row = (u8 *)image->memory + clip.minX*sizeof(u32) + clip.minY*image->pitch;
+		for(int y=clip.minY; y < clip.maxY; ++y) {
+			u32 *pixel = (u32 *)row;
+			for(int x=clip.minX; x < clip.maxX; ++x) {
+				u32 dest = *pixel;
+				u32 destR = (r + ((dest >> 16) & 0xFF)*inverse) / 255;
+				u32 destG = (g + ((dest >> 8) & 0xFF)*inverse) / 255;
+				u32 destB = (b + (dest & 0xFF)*inverse) / 255;
+				*pixel++ = 0xFF000000 | (destR << 16) | (destG << 8) | destB;
+			}
+			row += image->pitch;
+		}
+	}
+}
+
+void buildFrameGeometry(frame_geometry *geometry, render_snapshot *snapshot, float offset) {
+	v2 player0Offset = lerp(snapshot->players[0].prevPos, offset, snapshot->players[0].pos);
+	v2 player1Offset = lerp(snapshot->players[1].prevPos, offset, snapshot->players[1].pos);
+	v2 ballOffset = lerp(snapshot->ball.prevPos, offset, snapshot->ball.pos);
+
+	makeRectFromCenterPoint(geometry->vertices + 4*QuadPlayer0, player0Offset, snapshot->players[0].size);
+	makeRectFromCenterPoint(geometry->vertices + 4*QuadPlayer1, player1Offset, snapshot->players[1].size);
+	makeRectFromCenterPoint(geometry->vertices + 4*QuadBall, ballOffset, snapshot->ball.size);
+}
+
+// Everything but text. The arena fills the image, whatever size it is.
+// particles may be 0; so may sprites, for solid rectangles.
+void drawSceneSoftware(render_snapshot *snapshot, particle_system *particles, sprite_atlas *sprites,
+                       pixel_image *image, float offset) {
+	clearImage(image);
+
+	v2 scale = V2((float)image->width / snapshot->arenaWidth, (float)image->height / snapshot->arenaHeight);
+	if(sprites) {
+		updateSpriteAtlas(sprites, snapshot->players[0].size, snapshot->ball.size,
+		                  snapshot->poolCount ? snapshot->poolSize : 0.0f, scale);
+	}
+
+	frame_geometry geometry;
+	buildFrameGeometry(&geometry, snapshot, offset);
+
+	float midX = 0.5f*image->width;
+	drawSceneRectangle(image, V2(midX, 0.0f), V2(midX + 1.0f, (float)image->height), 0xffffffff);
+	for(u32 i=0; i < Entity_Quad_Count; ++i) {
+		v2 *corners = geometry.vertices + 4*i;
+		sprite_id id = (i == QuadBall) ? SpriteBall : SpritePaddle;
+		if(sprites && spriteReady(sprites, id)) {
+			drawSceneSprite(image, sprites, id, hadamard(scale, 0.5f*(corners[0] + corners[2])));
+		}
+		else {
+			drawSceneRectangle(image, hadamard(scale, corners[0]), hadamard(scale, corners[2]), 0xffffffff);
+		}
+	}
+	drawBallPoolSoftware(snapshot, sprites, image, scale, offset);
+	if(particles) {
+		drawParticlesSoftware(particles, image, scale);
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef PONG_DRAW_H
+#define PONG_DRAW_H
+
+// The software renderer's scene drawing, on plain pixel_images so any host
+// can draw a frame: the module into the Win32 backbuffer, the headless host
+// straight into capture frames. Text stays in the module with the glyph
+// atlas it shares with GL.
+
+#include "pong_scale.h"
+#include "pong_sprite.h"
+
+// Paddles, balls and the center line with analytic edge coverage
+// (drawRectangleAA) rather than snapped to whole pixels.
+#define ANTIALIASED_RECTANGLES 1
+
+// Paddles and balls drawn from the sprite atlas (pong_sprite.h) rather than
+// as solid rectangles, in both renderers.
+#define THEMED_SPRITES 1
+
+// The paddles and the ball as quads, blended for the frame being drawn and
+// built fresh from the snapshot every frame.
+enum entity_quad {
+	QuadPlayer0,
+	QuadPlayer1,
+	QuadBall,
+
+	Entity_Quad_Count
+};
+
+struct frame_geometry {
+	v2 vertices[4*Entity_Quad_Count];
+};
+
+#endif
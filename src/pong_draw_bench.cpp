@@ -0,0 +1,348 @@
+// Cost of the software renderer's anti-aliased rectangle fill and sprite
+// blits against the aliased fill in a 1280x720 frame: whole frames of a bot
+// match as drawSceneSoftware draws them (with and without stress-mode
+// balls), each themed sprite against a fill of its size, then single
+// rectangles from the whole frame down to a few pixels at sub-pixel
+// positions. The anti-aliased output is checked against a float reference
+// and the SIMD blit against the scalar one first.
+//
+//   pong_draw_bench [rectangles per size] [frames]
+
+#include "pong_game.h"
+#include "pong_host.h"
+#include "pong_draw.h"
+#include "pong_bench.h"
+#include "pong_game.cpp"
+#include "pong_particles.cpp"
+#include "pong_scale.cpp"
+#include "pong_sprite.cpp"
+#include "pong_draw.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define Bench_Width 1280
+#define Bench_Height 720
+
+static void clearTo(pixel_image *image, u32 color) {
+	for(s32 y=0; y < image->height; ++y) {
+		u32 *row = (u32 *)((u8 *)image->memory + y*image->pitch);
+		for(s32 x=0; x < image->width; ++x) {
+			row[x] = color;
+		}
+	}
+}
+
+// Worst channel difference from blending by exact float coverage, over a
+// batch of random rectangles drawn one at a time onto a gray background.
+static u32 checkAgainstReference(pixel_image *image) {
+	u32 random = 99;
+	u32 worst = 0;
+	for(u32 i=0; i < 200; ++i) {
+		clearTo(image, 0xFF404040);
+		v2 min = V2(randomUnilateral(&random)*image->width - 20.0f, randomUnilateral(&random)*image->height - 20.0f);
+		v2 max = V2(min.x + 0.2f + 60.0f*randomUnilateral(&random), min.y + 0.2f + 60.0f*randomUnilateral(&random));
+		drawRectangleAA(image, min, max, 0xFFFFC080);
+
+		for(s32 y=0; y < image->height; ++y) {
+			u32 *row = (u32 *)((u8 *)image->memory + y*image->pitch);
+			for(s32 x=0; x < image->width; ++x) {
+				float overlapX = fminf(max.x, (float)(x + 1)) - fmaxf(min.x, (float)x);
+				float overlapY = fminf(max.y, (float)(y + 1)) - fmaxf(min.y, (float)y);
+				float coverage = (overlapX > 0.0f && overlapY > 0.0f) ? overlapX*overlapY : 0.0f;
+				for(u32 shift=0; shift < 32; shift += 8) {
+					float source = (float)((0xFFFFC080 >> shift) & 0xFF);
+					float dest = (float)((0xFF404040 >> shift) & 0xFF);
+					s32 expected = (s32)(dest + (source - dest)*coverage + 0.5f);
+					s32 actual = (s32)((row[x] >> shift) & 0xFF);
+					u32 error = (u32)((expected > actual) ? (expected - actual) : (actual - expected));
+					if(error > worst) {
+						worst = error;
+					}
+				}
+			}
+		}
+	}
+	return worst;
+}
+
+// Pixels the SIMD blit gets different from overPixel(), over every sprite
+// at a few positions (some clipped) on a patterned background.
+static u32 checkSpriteBlit(pixel_image *image, sprite_atlas *sprites) {
+	u32 *expected = (u32 *)malloc((size_t)image->pitch*image->height);
+	u32 mismatches = 0;
+	s32 positions[][2] = {{100, 100}, {-7, 33}, {image->width - 5, image->height - 9}, {401, -3}};
+	for(u32 id=0; id < Sprite_Count; ++id) {
+		if(!spriteReady(sprites, (sprite_id)id)) {
+			continue;
+		}
+		rectangle2i rect = sprites->sprites[id];
+		for(u32 p=0; p < arrayCount(positions); ++p) {
+			for(s32 y=0; y < image->height; ++y) {
+				u32 *row = (u32 *)((u8 *)image->memory + y*image->pitch);
+				for(s32 x=0; x < image->width; ++x) {
+					row[x] = 0xFF000000 | ((x*7) & 0xFF) << 16 | ((y*3) & 0xFF) << 8 | (((x ^ y) & 8) ? 0xFF : 0);
+				}
+			}
+			memcpy(expected, image->memory, (size_t)image->pitch*image->height);
+
+			s32 x0 = positions[p][0];
+			s32 y0 = positions[p][1];
+			for(s32 y=rect.minY; y < rect.maxY; ++y) {
+				for(s32 x=rect.minX; x < rect.maxX; ++x) {
+					s32 toX = x0 + x - rect.minX;
+					s32 toY = y0 + y - rect.minY;
+					if(toX >= 0 && toY >= 0 && toX < image->width && toY < image->height) {
+						u32 *pixel = (u32 *)((u8 *)expected + toY*image->pitch) + toX;
+						*pixel = overPixel(*pixel, sprites->pixels[y*sprites->pitch + x]);
+					}
+				}
+			}
+
+			blitSprite(image, sprites, (sprite_id)id, x0, y0);
+			for(s32 y=0; y < image->height; ++y) {
+				u32 *row = (u32 *)((u8 *)image->memory + y*image->pitch);
+				u32 *want = (u32 *)((u8 *)expected + y*image->pitch);
+				for(s32 x=0; x < image->width; ++x) {
+					mismatches += (row[x] != want[x]) ? 1 : 0;
+				}
+			}
+		}
+	}
+	free(expected);
+	return mismatches;
+}
+
+enum fill_mode {
+	FillAliased,
+	FillAntialiased,
+	FillSprites,
+
+	Fill_Mode_Count
+};
+
+// drawSceneSoftware without particles, with the fill picked at run time
+// rather than by ANTIALIASED_RECTANGLES and THEMED_SPRITES.
+static void drawScene(pixel_image *image, game_state *gameState, ball_pool *balls, sprite_atlas *sprites,
+                      fill_mode fill) {
+	clearImage(image);
+	v2 scale = V2((float)image->width / gameState->arenaWidth, (float)image->height / gameState->arenaHeight);
+
+	v2 mins[3 + 1024];
+	v2 maxes[3 + 1024];
+	u32 count = 0;
+	v2 sizes[3] = {gameState->players[0].size, gameState->players[1].size, gameState->ball.size};
+	v2 centers[3] = {gameState->players[0].pos, gameState->players[1].pos, gameState->ball.pos};
+	for(u32 i=0; i < 3; ++i, ++count) {
+		mins[count] = hadamard(scale, centers[i] - 0.5f*sizes[i]);
+		maxes[count] = hadamard(scale, centers[i] + 0.5f*sizes[i]);
+	}
+	for(u32 i=0; i < balls->count && count < arrayCount(mins); ++i, ++count) {
+		v2 half = V2(0.5f*balls->size, 0.5f*balls->size);
+		mins[count] = hadamard(scale, V2(balls->x[i], balls->y[i]) - half);
+		maxes[count] = hadamard(scale, V2(balls->x[i], balls->y[i]) + half);
+	}
+
+	float midX = 0.5f*image->width;
+	if(fill == FillSprites) {
+		updateSpriteAtlas(sprites, gameState->players[0].size, gameState->ball.size, balls->count ? balls->size : 0.0f,
+		                  scale);
+		drawRectangleAA(image, V2(midX, 0.0f), V2(midX + 1.0f, (float)image->height), 0xffffffff);
+		for(u32 i=0; i < count; ++i) {
+			sprite_id id = (i < 2) ? SpritePaddle : ((i == 2) ? SpriteBall : SpritePoolBall);
+			drawSceneSprite(image, sprites, id, 0.5f*(mins[i] + maxes[i]));
+		}
+	}
+	else if(fill == FillAntialiased) {
+		drawRectangleAA(image, V2(midX, 0.0f), V2(midX + 1.0f, (float)image->height), 0xffffffff);
+		for(u32 i=0; i < count; ++i) {
+			drawRectangleAA(image, mins[i], maxes[i], 0xffffffff);
+		}
+	}
+	else {
+		drawRectangle(image, V2(midX, 0.0f), V2(midX + 1.0f, (float)image->height), 0xffffffff);
+		for(u32 i=0; i < count; ++i) {
+			drawRectangle(image, mins[i], maxes[i], 0xffffffff);
+		}
+	}
+}
+
+// Microseconds per frame for one match, every fill drawing every frame (in
+// rotating order, so none of them always gets the warm cache)
+static void timeScene(pixel_image *image, sprite_atlas *sprites, u32 ballCount, u32 frames,
+                      double *microseconds) {
+	size_t arenaSize = megabytes(16);
+	memory_arena arena;
+	initArena(&arena, calloc(1, arenaSize), arenaSize);
+
+	game_state gameState = {};
+	initGameState(&gameState, globalArenaPresets + ArenaStandard);
+	bot_state bots[2];
+	initBot(bots + 0, globalBotDifficulties[1], 0x1234567);
+	initBot(bots + 1, globalBotDifficulties[1], 0x1234568);
+	ball_pool balls = {};
+	if(ballCount) {
+		initBallPool(&balls, &arena, ballCount, ballPoolSize(ballCount, &gameState),
+		             gameState.arenaWidth, gameState.arenaHeight);
+		spawnBalls(&balls, ballCount, gameState.arenaWidth, gameState.arenaHeight, 0x5EED);
+	}
+
+	float dt = 1.0f / Simulation_Hz;
+	double seconds[Fill_Mode_Count] = {};
+	for(u32 frame=0; frame < frames; ++frame) {
+		for(u32 player=0; player < 2; ++player) {
+			botDecide(bots + player, &gameState, player, dt);
+		}
+		update(&gameState, dt);
+		if(ballCount) {
+			updateBallPool(&balls, &gameState, dt);
+		}
+
+		for(u32 i=0; i < Fill_Mode_Count; ++i) {
+			u32 fill = (frame + i) % Fill_Mode_Count;
+			double start = benchSeconds();
+			drawScene(image, &gameState, &balls, sprites, (fill_mode)fill);
+			seconds[fill] += benchSeconds() - start;
+		}
+	}
+	for(u32 fill=0; fill < Fill_Mode_Count; ++fill) {
+		microseconds[fill] = (seconds[fill]*1e6) / frames;
+	}
+	free(arena.base);
+}
+
+// Nanoseconds per sprite blit at count integer positions
+static double timeSprites(pixel_image *image, sprite_atlas *sprites, sprite_id id, v2 *mins, u32 count) {
+	double best = 0.0;
+	for(u32 run=0; run < 5; ++run) {
+		double start = benchSeconds();
+		for(u32 i=0; i < count; ++i) {
+			blitSprite(image, sprites, id, (s32)mins[i].x, (s32)mins[i].y);
+		}
+		double seconds = benchSeconds() - start;
+		if(run == 0 || seconds < best) {
+			best = seconds;
+		}
+	}
+	return (best*1e9) / count;
+}
+
+static double timeRectangles(pixel_image *image, v2 *mins, v2 size, u32 count, bool antialiased) {
+	double best = 0.0;
+	for(u32 run=0; run < 5; ++run) {
+		double start = benchSeconds();
+		for(u32 i=0; i < count; ++i) {
+			v2 max = V2(mins[i].x + size.x, mins[i].y + size.y);
+			if(antialiased) {
+				drawRectangleAA(image, mins[i], max, 0xFFFFFFFF);
+			}
+			else {
+				drawRectangle(image, mins[i], max, 0xFFFFFFFF);
+			}
+		}
+		double seconds = benchSeconds() - start;
+		if(run == 0 || seconds < best) {
+			best = seconds;
+		}
+	}
+	return (best*1e9) / count;
+}
+
+int main(int argc, char **argv) {
+	u32 count = (argc > 1) ? (u32)atoi(argv[1]) : 2000;
+	u32 frames = (argc > 2) ? (u32)atoi(argv[2]) : 600;
+	if(count == 0) {
+		count = 1;
+	}
+	if(frames == 0) {
+		frames = 1;
+	}
+
+	pixel_image image;
+	image.width = Bench_Width;
+	image.height = Bench_Height;
+	image.pitch = Align16(Bench_Width*4);
+	image.memory = calloc(1, (size_t)image.pitch*Bench_Height);
+
+	size_t arenaSize = megabytes(4);
+	memory_arena arena;
+	initArena(&arena, calloc(1, arenaSize), arenaSize);
+	sprite_atlas sprites;
+	initSpriteAtlas(&sprites, &arena);
+
+	// The sprites as a 256-ball match at this size draws them
+	game_state gameState = {};
+	initGameState(&gameState, globalArenaPresets + ArenaStandard);
+	v2 scale = V2((float)Bench_Width / gameState.arenaWidth, (float)Bench_Height / gameState.arenaHeight);
+	updateSpriteAtlas(&sprites, gameState.players[0].size, gameState.ball.size, ballPoolSize(256, &gameState), scale);
+
+	printf("worst channel error against float coverage: %u\n", checkAgainstReference(&image));
+	printf("sprite blit pixels different from scalar: %u\n\n", checkSpriteBlit(&image, &sprites));
+
+	u32 ballCounts[] = {0, 256};
+	printf("%12s %12s %12s %12s %8s %8s\n", "FRAME", "ALIASED US", "AA US", "SPRITES US", "AA", "SPRITES");
+	for(u32 b=0; b < arrayCount(ballCounts); ++b) {
+		double microseconds[Fill_Mode_Count];
+		timeScene(&image, &sprites, ballCounts[b], frames, microseconds);
+
+		char name[32];
+		sprintf(name, "%u balls", ballCounts[b]);
+		printf("%12s %12.1f %12.1f %12.1f %8.2f %8.2f\n", name, microseconds[FillAliased],
+		       microseconds[FillAntialiased], microseconds[FillSprites],
+		       microseconds[FillAntialiased] / microseconds[FillAliased],
+		       microseconds[FillSprites] / microseconds[FillAliased]);
+	}
+	printf("\n");
+
+	v2 sizes[] = {
+		{1280.0f, 720.0f},
+		{640.0f, 360.0f},
+		{20.0f, 100.0f},
+		{10.0f, 10.0f},
+		{5.0f, 5.0f},
+		{2.5f, 2.5f},
+	};
+
+	v2 *mins = (v2 *)malloc(count*sizeof(v2));
+	const char *spriteNames[Sprite_Count] = {"paddle", "ball", "pool ball"};
+	printf("%12s %12s %12s %12s %8s\n", "SPRITE", "SIZE", "ALIASED NS", "BLIT NS", "RATIO");
+	for(u32 id=0; id < Sprite_Count; ++id) {
+		rectangle2i rect = sprites.sprites[id];
+		v2 size = V2((float)(rect.maxX - rect.minX), (float)(rect.maxY - rect.minY));
+		u32 random = 1234;
+		for(u32 i=0; i < count; ++i) {
+			mins[i] = V2((float)(s32)(randomUnilateral(&random)*(Bench_Width - size.x)),
+			             (float)(s32)(randomUnilateral(&random)*(Bench_Height - size.y)));
+		}
+
+		double aliased = timeRectangles(&image, mins, size, count, false);
+		double blit = timeSprites(&image, &sprites, (sprite_id)id, mins, count);
+
+		char sizeName[32];
+		sprintf(sizeName, "%gx%g", size.x, size.y);
+		printf("%12s %12s %12.1f %12.1f %8.2f\n", spriteNames[id], sizeName, aliased, blit, blit / aliased);
+	}
+	printf("\n");
+
+	printf("%12s %12s %12s %8s\n", "SIZE", "ALIASED NS", "AA NS", "RATIO");
+	for(u32 s=0; s < arrayCount(sizes); ++s) {
+		v2 size = sizes[s];
+		u32 random = 1234;
+		for(u32 i=0; i < count; ++i) {
+			mins[i] = V2(randomUnilateral(&random)*(Bench_Width - size.x),
+			             randomUnilateral(&random)*(Bench_Height - size.y));
+		}
+
+		double aliased = timeRectangles(&image, mins, size, count, false);
+		double antialiased = timeRectangles(&image, mins, size, count, true);
+
+		char name[32];
+		sprintf(name, "%gx%g", size.x, size.y);
+		printf("%12s %12.1f %12.1f %8.2f\n", name, aliased, antialiased, antialiased / aliased);
+	}
+
+	free(mins);
+	free(arena.base);
+	free(image.memory);
+	return 0;
+}
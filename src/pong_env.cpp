@@ -0,0 +1,242 @@
+#if defined(_WIN32)
+#define _CRT_SECURE_NO_WARNINGS
+#include <windows.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pong_game.h"
+#include "pong_threads.h"
+#include "pong_trajectory.h"
+
+#include "pong_game.cpp"
+#include "pong_threads.cpp"
+#include "pong_trajectory.cpp"
+
+#include "pong_env.h"
+#include "pong_observation.cpp"
+
+struct pong_env {
+	pong_env_config config;
+	u32 observationSize;
+
+	game_state *games;
+	bot_state *bots;
+	u32 *episodeSteps;
+	u32 *random;
+
+	// Set while exporting; tick counts pong_env_step calls since create.
+	trajectory_writer *trajectory;
+	u64 tick;
+
+	// What pong_env_export_end returns for an export that already ended at
+	// the tick limit
+	int exportResult;
+};
+
+static void resetGame(pong_env *env, u32 index) {
+	game_state *gameState = env->games + index;
+	u32 *random = env->random + index;
+
+	initGameState(gameState, globalArenaPresets + ArenaStandard);
+
+	serveBall(gameState, (nextRandom(random) & 1) ? 1.0f : -1.0f);
+	gameState->ball.velocity.y = (randomUnilateral(random) - 0.5f) * 800.0f;
+
+	if(env->config.agents == 1) {
+		u32 difficulty = env->config.botDifficulty;
+		if(difficulty >= arrayCount(globalBotDifficulties)) {
+			difficulty = 1;
+		}
+		initBot(env->bots + index, globalBotDifficulties[difficulty], nextRandom(random));
+	}
+
+	env->episodeSteps[index] = 0;
+}
+
+static void writeObservations(pong_env *env, void *observations, const u8 *restarted) {
+	if(env->config.observation == PONG_OBSERVATION_PIXELS) {
+		renderObservationBatch(env->games, env->config.count, (u8 *)observations,
+		                       env->config.pixelWidth, env->config.pixelHeight, env->config.frameStack,
+		                       restarted);
+		return;
+	}
+
+	for(u32 index=0; index < env->config.count; ++index) {
+		game_state *gameState = env->games + index;
+		float *state = (float *)observations + (size_t)index*PONG_ENV_STATE_SIZE;
+		float invWidth = 1.0f / gameState->arenaWidth;
+		float invHeight = 1.0f / gameState->arenaHeight;
+		float invSpeed = 1.0f / gameState->ballServeVelocity.x;
+
+		state[0] = gameState->ball.pos.x * invWidth;
+		state[1] = gameState->ball.pos.y * invHeight;
+		state[2] = gameState->ball.velocity.x * invSpeed;
+		state[3] = gameState->ball.velocity.y * invSpeed;
+		state[4] = gameState->players[0].pos.y * invHeight;
+		state[5] = gameState->players[1].pos.y * invHeight;
+	}
+}
+
+inline void applyAction(program_input *input, u8 action) {
+	input->up.endedDown = (action == PONG_ACTION_UP);
+	input->up.heldFraction = input->up.endedDown ? 1.0f : 0.0f;
+	input->down.endedDown = (action == PONG_ACTION_DOWN);
+	input->down.heldFraction = input->down.endedDown ? 1.0f : 0.0f;
+}
+
+pong_env_config pong_env_default_config(uint32_t count) {
+	pong_env_config result = {};
+
+	result.count = count;
+	result.observation = PONG_OBSERVATION_STATE;
+	result.pixelWidth = 84;
+	result.pixelHeight = 84;
+	result.frameStack = 1;
+	result.agents = 1;
+	result.botDifficulty = 1;
+	result.frameSkip = 1;
+	result.pointsPerEpisode = 21;
+	result.maxEpisodeSteps = 0;
+
+	return result;
+}
+
+pong_env *pong_env_create(const pong_env_config *config) {
+	if(config->count == 0 || config->agents < 1 || config->agents > 2) {
+		return 0;
+	}
+	if(config->observation == PONG_OBSERVATION_PIXELS &&
+	   (config->pixelWidth == 0 || config->pixelWidth > Max_Observation_Width || config->pixelHeight == 0)) {
+		return 0;
+	}
+
+	size_t count = config->count;
+	size_t size = (Align16(sizeof(pong_env)) +
+	               Align16(count*sizeof(game_state)) +
+	               Align16(count*sizeof(bot_state)) +
+	               Align16(count*sizeof(u32)) +
+	               Align16(count*sizeof(u32)));
+
+	// Everything lives in one block allocated here; stepping never allocates.
+	void *memory = calloc(1, size);
+	if(!memory) {
+		return 0;
+	}
+
+	memory_arena arena;
+	initArena(&arena, memory, size);
+
+	pong_env *env = pushStruct(&arena, pong_env);
+	env->config = *config;
+	if(env->config.frameSkip == 0) {
+		env->config.frameSkip = 1;
+	}
+	if(env->config.frameStack == 0) {
+		env->config.frameStack = 1;
+	}
+	env->games = pushArray(&arena, count, game_state);
+	env->bots = pushArray(&arena, count, bot_state);
+	env->episodeSteps = pushArray(&arena, count, u32);
+	env->random = pushArray(&arena, count, u32);
+
+	if(env->config.observation == PONG_OBSERVATION_PIXELS) {
+		env->observationSize = env->config.pixelWidth * env->config.pixelHeight * env->config.frameStack;
+	}
+	else {
+		env->observationSize = PONG_ENV_STATE_SIZE;
+	}
+
+	return env;
+}
+
+void pong_env_destroy(pong_env *env) {
+	pong_env_export_end(env);
+	free(env);
+}
+
+uint32_t pong_env_observation_size(pong_env *env) {
+	return env->observationSize;
+}
+
+void pong_env_reset(pong_env *env, uint64_t seed, void *observations) {
+	for(u32 i=0; i < env->config.count; ++i) {
+		u32 random = (u32)mixSeed(seed ^ mixSeed(i));
+		env->random[i] = random ? random : 1;
+
+		resetGame(env, i);
+	}
+
+	writeObservations(env, observations, 0);
+}
+
+void pong_env_step(pong_env *env, const uint8_t *actions, void *observations,
+                   float *rewards, uint8_t *dones) {
+	u32 agents = env->config.agents;
+	float dt = 1.0f / Simulation_Hz;
+
+	// The tick column can't count past this; end the export rather than wrap
+	if(env->trajectory && env->tick > Trajectory_Max_Tick) {
+		env->exportResult = pong_env_export_end(env);
+	}
+
+	for(u32 i=0; i < env->config.count; ++i) {
+		game_state *gameState = env->games + i;
+
+		applyAction(&gameState->input[0], actions[i*agents]);
+		if(agents == 2) {
+			applyAction(&gameState->input[1], actions[i*agents + 1]);
+		}
+
+		u32 points0 = 0;
+		u32 points1 = 0;
+		for(u32 step=0; step < env->config.frameSkip; ++step) {
+			if(agents == 1) {
+				botDecide(env->bots + i, gameState, 1, dt);
+			}
+			update(gameState, dt);
+
+			points0 += (gameState->events & EventPointPlayer0) ? 1 : 0;
+			points1 += (gameState->events & EventPointPlayer1) ? 1 : 0;
+		}
+
+		float reward = (float)points0 - (float)points1;
+
+		rewards[i*agents] = reward;
+		if(agents == 2) {
+			rewards[i*agents + 1] = -reward;
+		}
+
+		u32 points = gameState->players[0].score + gameState->players[1].score;
+		u32 steps = ++env->episodeSteps[i];
+		bool done = ((env->config.pointsPerEpisode && points >= env->config.pointsPerEpisode) ||
+		             (env->config.maxEpisodeSteps && steps >= env->config.maxEpisodeSteps));
+		dones[i] = done ? 1 : 0;
+		if(env->trajectory) {
+			recordTrajectoryRow(env->trajectory, gameState, points0, points1, steps == 1, done);
+		}
+		if(done) {
+			resetGame(env, i);
+		}
+	}
+
+	++env->tick;
+	writeObservations(env, observations, dones);
+}
+
+int pong_env_export_begin(pong_env *env, const char *directory, int compress) {
+	pong_env_export_end(env);
+	env->trajectory = openTrajectoryWriter(directory, compress != 0, env->tick, env->games, env->config.count);
+	return env->trajectory ? 0 : -1;
+}
+
+int pong_env_export_end(pong_env *env) {
+	int result = env->exportResult;
+	if(env->trajectory) {
+		result = closeTrajectoryWriter(env->trajectory) ? 0 : -1;
+		env->trajectory = 0;
+	}
+	env->exportResult = 0;
+	return result;
+}
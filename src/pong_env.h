@@ -0,0 +1,101 @@
+#ifndef PONG_ENV_H
+#define PONG_ENV_H
+
+// Batched headless environments for training agents. One pong_env runs
+// `count` independent games in lockstep; every call reads actions from and
+// writes results straight into caller-owned arrays laid out env-major.
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define PONG_ENV_API __declspec(dllexport)
+#else
+#define PONG_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+	PONG_OBSERVATION_STATE = 0,
+	PONG_OBSERVATION_PIXELS = 1,
+};
+
+enum {
+	PONG_ACTION_STAY = 0,
+	PONG_ACTION_UP = 1,
+	PONG_ACTION_DOWN = 2,
+};
+
+// State observations are floats: ball x, ball y, ball velocity x, ball
+// velocity y, left paddle y, right paddle y. Positions are divided by the
+// arena size and velocities by the serve speed.
+#define PONG_ENV_STATE_SIZE 6
+
+typedef struct pong_env_config {
+	uint32_t count;
+
+	uint32_t observation;
+
+	// Pixel observations: 8-bit grayscale with area-coverage anti-aliasing,
+	// the last frameStack frames per environment, oldest first.
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t frameStack;
+
+	// 1: the agent plays the left paddle against the built-in bot.
+	// 2: both paddles are agents; actions and rewards are [env][player].
+	uint32_t agents;
+	uint32_t botDifficulty;
+
+	// Simulation steps per pong_env_step; the action is held for all of them.
+	uint32_t frameSkip;
+
+	// An episode ends after this many points, or after this many env steps
+	// (0 for no limit).
+	uint32_t pointsPerEpisode;
+	uint32_t maxEpisodeSteps;
+} pong_env_config;
+
+typedef struct pong_env pong_env;
+
+PONG_ENV_API pong_env_config pong_env_default_config(uint32_t count);
+
+PONG_ENV_API pong_env *pong_env_create(const pong_env_config *config);
+PONG_ENV_API void pong_env_destroy(pong_env *env);
+
+// Per environment: floats for PONG_OBSERVATION_STATE, bytes for
+// PONG_OBSERVATION_PIXELS.
+PONG_ENV_API uint32_t pong_env_observation_size(pong_env *env);
+
+// Restarts every environment. Environment i is seeded from seed and i, so a
+// batch is reproducible regardless of how it is sharded.
+PONG_ENV_API void pong_env_reset(pong_env *env, uint64_t seed, void *observations);
+
+// actions: count * agents bytes. rewards: count * agents floats, +1 for a
+// point won and -1 for a point lost. dones: count bytes. Environments that
+// finish are reset immediately and report the first observation of the
+// next episode.
+PONG_ENV_API void pong_env_step(pong_env *env, const uint8_t *actions, void *observations,
+                                float *rewards, uint8_t *dones);
+
+// Streams every environment's state, held input, reward and done flag after
+// each pong_env_step into one file per column under directory, which must
+// already exist. Writing happens on a background thread; compress trades
+// its CPU time for smaller files that can no longer be mapped directly.
+// The tick column is 32 bits: the export ends by itself (as
+// pong_env_export_end) after the step with tick 2^32 - 1.
+// Returns 0 on success.
+PONG_ENV_API int pong_env_export_begin(pong_env *env, const char *directory, int compress);
+
+// Flushes and closes the files. Also done by pong_env_destroy. Returns 0 if
+// everything was written, -1 if a write failed (a full disk, say): the
+// export stopped there, and the files hold the rows written before it.
+PONG_ENV_API int pong_env_export_end(pong_env *env);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
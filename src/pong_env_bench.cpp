@@ -0,0 +1,177 @@
+// Measures pong_env throughput. Each thread owns its own batch of
+// environments, so this is the number a trainer sharding across cores sees.
+//
+//   pong_env_bench [envs per thread] [threads] [steps] [pixels] [export directory] [compress]
+//
+// With an export directory each thread also streams its trajectories into
+// <directory>/<thread>, to measure what exporting costs the step loop.
+
+#include "pong_env.cpp"
+#include "pong_bench.h"
+
+#include <stdio.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct bench_thread {
+	pong_env *env;
+	u32 steps;
+	u64 seed;
+
+	u8 *actions;
+	void *observations;
+	float *rewards;
+	u8 *dones;
+
+	u64 points;
+};
+
+static void runBench(bench_thread *thread) {
+	pong_env *env = thread->env;
+	u32 count = env->config.count;
+	u32 random = (u32)thread->seed | 1;
+
+	pong_env_reset(env, thread->seed, thread->observations);
+	for(u32 step=0; step < thread->steps; ++step) {
+		for(u32 i=0; i < count; ++i) {
+			thread->actions[i] = (u8)(nextRandom(&random) % 3);
+		}
+
+		pong_env_step(env, thread->actions, thread->observations, thread->rewards, thread->dones);
+
+		for(u32 i=0; i < count; ++i) {
+			thread->points += (thread->rewards[i] != 0.0f);
+		}
+	}
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI benchThreadProc(LPVOID parameter) {
+	runBench((bench_thread *)parameter);
+	return 0;
+}
+
+static u32 coreCount() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+}
+
+static void makeDirectory(const char *path) {
+	CreateDirectoryA(path, 0);
+}
+#else
+static void *benchThreadProc(void *parameter) {
+	runBench((bench_thread *)parameter);
+	return 0;
+}
+
+static u32 coreCount() {
+	return (u32)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static void makeDirectory(const char *path) {
+	mkdir(path, 0777);
+}
+#endif
+
+#define Max_Bench_Threads 256
+
+int main(int argc, char **argv) {
+	u32 envsPerThread = (argc > 1) ? (u32)atoi(argv[1]) : 4096;
+	u32 threadCount = (argc > 2) ? (u32)atoi(argv[2]) : coreCount();
+	u32 steps = (argc > 3) ? (u32)atoi(argv[3]) : 2000;
+	bool pixels = (argc > 4) && (atoi(argv[4]) != 0);
+	const char *exportDirectory = (argc > 5) ? argv[5] : 0;
+	bool compress = (argc > 6) && (atoi(argv[6]) != 0);
+	if(threadCount < 1) {
+		threadCount = 1;
+	}
+	if(threadCount > Max_Bench_Threads) {
+		threadCount = Max_Bench_Threads;
+	}
+
+	pong_env_config config = pong_env_default_config(envsPerThread);
+	if(pixels) {
+		config.observation = PONG_OBSERVATION_PIXELS;
+	}
+
+	static bench_thread threads[Max_Bench_Threads];
+	for(u32 t=0; t < threadCount; ++t) {
+		bench_thread *thread = threads + t;
+		thread->env = pong_env_create(&config);
+		thread->steps = steps;
+		thread->seed = 1000 + t;
+
+		u32 observationBytes = pong_env_observation_size(thread->env) * (pixels ? 1 : sizeof(float));
+		thread->actions = (u8 *)malloc(envsPerThread);
+		thread->observations = malloc((size_t)envsPerThread * observationBytes);
+		thread->rewards = (float *)malloc(envsPerThread * sizeof(float));
+		thread->dones = (u8 *)malloc(envsPerThread);
+
+		if(exportDirectory) {
+			char path[1024];
+			makeDirectory(exportDirectory);
+			sprintf(path, "%.1000s/%u", exportDirectory, t);
+			makeDirectory(path);
+			if(pong_env_export_begin(thread->env, path, compress) != 0) {
+				fprintf(stderr, "pong_env_bench: can't export to %s\n", path);
+				return 1;
+			}
+		}
+	}
+
+	double start = benchSeconds();
+
+#if defined(_WIN32)
+	HANDLE handles[Max_Bench_Threads];
+	for(u32 t=0; t < threadCount; ++t) {
+		handles[t] = CreateThread(0, 0, benchThreadProc, threads + t, 0, 0);
+	}
+	for(u32 t=0; t < threadCount; ++t) {
+		WaitForSingleObject(handles[t], INFINITE);
+		CloseHandle(handles[t]);
+	}
+#else
+	pthread_t handles[Max_Bench_Threads];
+	for(u32 t=0; t < threadCount; ++t) {
+		pthread_create(handles + t, 0, benchThreadProc, threads + t);
+	}
+	for(u32 t=0; t < threadCount; ++t) {
+		pthread_join(handles[t], 0);
+	}
+#endif
+
+	double seconds = benchSeconds() - start;
+
+	// Includes draining whatever the export threads still have queued.
+	u64 points = 0;
+	u32 failedExports = 0;
+	for(u32 t=0; t < threadCount; ++t) {
+		points += threads[t].points;
+		if(exportDirectory && pong_env_export_end(threads[t].env) != 0) {
+			++failedExports;
+		}
+		pong_env_destroy(threads[t].env);
+	}
+	double totalSeconds = benchSeconds() - start;
+
+	double envSteps = (double)envsPerThread * threadCount * steps;
+	printf("%u threads x %u envs x %u steps (%s observations): %.3fs\n",
+	       threadCount, envsPerThread, steps, pixels ? "pixel" : "state", seconds);
+	if(exportDirectory) {
+		printf("exported to %s%s, %.3fs including the final flush%s\n",
+		       exportDirectory, compress ? " (compressed)" : "", totalSeconds,
+		       failedExports ? ", but writing failed" : "");
+	}
+	printf("%.2fM env-steps/s total, %.2fM per thread, %llu points scored\n",
+	       envSteps / seconds / 1e6, envSteps / seconds / 1e6 / threadCount, (unsigned long long)points);
+
+	return 0;
+}
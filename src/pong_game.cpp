@@ -0,0 +1,374 @@
+// The presets as constants, one struct per preset, so the update() kernel
+// instantiated for one folds them all in. arena_runtime reads the same
+// values from the state for everything else.
+struct arena_standard {
+	static inline float width(game_state *) { return 1280.0f; }
+	static inline float height(game_state *) { return 720.0f; }
+	static inline v2 playerSize(game_state *) { return V2(20.0f, 50.0f); }
+	static inline v2 ballSize(game_state *) { return V2(10.0f, 10.0f); }
+	static inline float playerInset(game_state *) { return 50.0f; }
+	static inline float paddleSpeed(game_state *) { return 400.0f; }
+	static inline v2 ballServeVelocity(game_state *) { return V2(1600.0f, 0.0f); }
+	static inline v2 ballAcceleration(game_state *) { return V2(200.0f, 500.0f); }
+};
+
+// Half scale, for quick experiments and small observation renders
+struct arena_small {
+	static inline float width(game_state *) { return 640.0f; }
+	static inline float height(game_state *) { return 360.0f; }
+	static inline v2 playerSize(game_state *) { return V2(10.0f, 25.0f); }
+	static inline v2 ballSize(game_state *) { return V2(5.0f, 5.0f); }
+	static inline float playerInset(game_state *) { return 25.0f; }
+	static inline float paddleSpeed(game_state *) { return 200.0f; }
+	static inline v2 ballServeVelocity(game_state *) { return V2(800.0f, 0.0f); }
+	static inline v2 ballAcceleration(game_state *) { return V2(100.0f, 250.0f); }
+};
+
+struct arena_runtime {
+	static inline float width(game_state *gameState) { return (float)gameState->arenaWidth; }
+	static inline float height(game_state *gameState) { return (float)gameState->arenaHeight; }
+	static inline v2 playerSize(game_state *gameState) { return gameState->players[0].size; }
+	static inline v2 ballSize(game_state *gameState) { return gameState->ball.size; }
+	static inline float paddleSpeed(game_state *gameState) { return gameState->paddleSpeed; }
+	static inline v2 ballServeVelocity(game_state *gameState) { return gameState->ballServeVelocity; }
+	static inline v2 ballAcceleration(game_state *gameState) { return gameState->ballAcceleration; }
+};
+
+template<typename Arena> arena_config arenaConfigFrom() {
+	arena_config result;
+	result.width = (u32)Arena::width(0);
+	result.height = (u32)Arena::height(0);
+	result.playerSize = Arena::playerSize(0);
+	result.ballSize = Arena::ballSize(0);
+	result.playerInset = Arena::playerInset(0);
+	result.paddleSpeed = Arena::paddleSpeed(0);
+	result.ballServeVelocity = Arena::ballServeVelocity(0);
+	result.ballAcceleration = Arena::ballAcceleration(0);
+	return result;
+}
+
+// Indexed by arena_preset
+static arena_config globalArenaPresets[Arena_Preset_Count] = {
+	arenaConfigFrom<arena_standard>(),
+	arenaConfigFrom<arena_small>(),
+};
+
+static const char *globalArenaPresetNames[Arena_Preset_Count] = {
+	"standard",
+	"small",
+};
+
+inline bool arenaConfigsEqual(arena_config *a, arena_config *b) {
+	bool result = (a->width == b->width && a->height == b->height &&
+	               a->playerSize.x == b->playerSize.x && a->playerSize.y == b->playerSize.y &&
+	               a->ballSize.x == b->ballSize.x && a->ballSize.y == b->ballSize.y &&
+	               a->playerInset == b->playerInset && a->paddleSpeed == b->paddleSpeed &&
+	               a->ballServeVelocity.x == b->ballServeVelocity.x &&
+	               a->ballServeVelocity.y == b->ballServeVelocity.y &&
+	               a->ballAcceleration.x == b->ballAcceleration.x &&
+	               a->ballAcceleration.y == b->ballAcceleration.y);
+	return result;
+}
+
+// Reads a "W,H" or "WxH" pair; leaves result alone if there isn't one.
+static void parseArenaPair(const char *at, v2 *result) {
+	char *end;
+	float x = strtof(at, &end);
+	if(end == at || (*end != ',' && *end != 'x')) {
+		return;
+	}
+	const char *second = end + 1;
+	float y = strtof(second, &end);
+	if(end != second) {
+		*result = V2(x, y);
+	}
+}
+
+// Starts from "-arena=NAME" (a preset, standard by default) and applies any
+// of -arenaWidth=N, -arenaHeight=N, -paddleSize=WxH, -ballSize=WxH,
+// -paddleInset=N, -paddleSpeed=N, -serveVelocity=X,Y and
+// -ballAcceleration=X,Y on top.
+void parseArenaOption(const char *commandLine, arena_config *config) {
+	*config = globalArenaPresets[ArenaStandard];
+
+	const char *at = strstr(commandLine, "-arena=");
+	if(at) {
+		at += 7;
+		for(u32 i=0; i < Arena_Preset_Count; ++i) {
+			size_t length = strlen(globalArenaPresetNames[i]);
+			if(strncmp(at, globalArenaPresetNames[i], length) == 0) {
+				*config = globalArenaPresets[i];
+			}
+		}
+	}
+
+	if((at = strstr(commandLine, "-arenaWidth=")) != 0) {
+		config->width = (u32)atoi(at + 12);
+	}
+	if((at = strstr(commandLine, "-arenaHeight=")) != 0) {
+		config->height = (u32)atoi(at + 13);
+	}
+	if((at = strstr(commandLine, "-paddleSize=")) != 0) {
+		parseArenaPair(at + 12, &config->playerSize);
+	}
+	if((at = strstr(commandLine, "-ballSize=")) != 0) {
+		parseArenaPair(at + 10, &config->ballSize);
+	}
+	if((at = strstr(commandLine, "-paddleInset=")) != 0) {
+		config->playerInset = strtof(at + 13, 0);
+	}
+	if((at = strstr(commandLine, "-paddleSpeed=")) != 0) {
+		config->paddleSpeed = strtof(at + 13, 0);
+	}
+	if((at = strstr(commandLine, "-serveVelocity=")) != 0) {
+		parseArenaPair(at + 15, &config->ballServeVelocity);
+	}
+	if((at = strstr(commandLine, "-ballAcceleration=")) != 0) {
+		parseArenaPair(at + 18, &config->ballAcceleration);
+	}
+}
+
+// Paddles at their inset from either end, both they and the ball centered
+// vertically; the ball waits in the middle until served. No buttons are
+// held and no events are raised.
+void initGameState(game_state *gameState, arena_config *config) {
+	gameState->arenaWidth = config->width;
+	gameState->arenaHeight = config->height;
+	gameState->paddleSpeed = config->paddleSpeed;
+	gameState->ballServeVelocity = config->ballServeVelocity;
+	gameState->ballAcceleration = config->ballAcceleration;
+
+	gameState->preset = ArenaCustom;
+	for(u32 i=0; i < Arena_Preset_Count; ++i) {
+		if(arenaConfigsEqual(config, globalArenaPresets + i)) {
+			gameState->preset = i;
+		}
+	}
+
+	v2 center = V2(0.5f*config->width, 0.5f*config->height);
+	v2 player1Pos = V2(config->playerInset, center.y);
+	v2 player2Pos = V2(config->width - config->playerInset, center.y);
+
+	gameState->players[0].pos = player1Pos;
+	gameState->players[0].prevPos = player1Pos;
+	gameState->players[0].score = 0;
+	gameState->players[0].size = config->playerSize;
+
+	gameState->players[1].pos = player2Pos;
+	gameState->players[1].prevPos = player2Pos;
+	gameState->players[1].score = 0;
+	gameState->players[1].size = config->playerSize;
+
+	gameState->ball.pos = center;
+	gameState->ball.prevPos = center;
+	gameState->ball.size = config->ballSize;
+	gameState->ball.velocity = V2(0, 0);
+
+	memset(gameState->input, 0, sizeof(gameState->input));
+	gameState->events = 0;
+	gameState->programRunning = true;
+}
+
+template<typename Arena>
+inline wall collidedWithWall(game_state *gameState, v2 pos, v2 size) {
+	float xMin = pos.x - 0.5f * size.x;
+	float xMax = pos.x + 0.5f * size.x;
+	float yMin = pos.y - 0.5f * size.y;
+	float yMax = pos.y + 0.5f * size.y;
+
+	if(xMin < 0)
+		return WallLeft;
+	else if(yMin < 0)
+		return WallUp;
+	else if(xMax > Arena::width(gameState))
+		return WallRight;
+	else if(yMax > Arena::height(gameState))
+		return WallDown;
+
+	return WallNone;
+}
+
+// Puts the ball back in the middle, heading towards the given side (-1 left,
+// 1 right).
+template<typename Arena>
+inline void serveBall(game_state *gameState, float direction) {
+	v2 initialVelocity = Arena::ballServeVelocity(gameState);
+
+	gameState->ball.pos = V2(0.5f*Arena::width(gameState), 0.5f*Arena::height(gameState));
+	gameState->ball.prevPos = gameState->ball.pos;
+	gameState->ball.velocity = V2(direction*initialVelocity.x, initialVelocity.y);
+}
+
+void serveBall(game_state *gameState, float direction) {
+	serveBall<arena_runtime>(gameState, direction);
+}
+
+template<typename Arena>
+void update(game_state *gameState, float dt) {
+	// Keep the state at the start of the step around so render() can blend
+	// between two real simulation states.
+	gameState->ball.prevPos = gameState->ball.pos;
+	gameState->players[0].prevPos = gameState->players[0].pos;
+	gameState->players[1].prevPos = gameState->players[1].pos;
+	gameState->events = 0;
+
+	v2 ballSize = Arena::ballSize(gameState);
+	v2 playerSize = Arena::playerSize(gameState);
+	wall whichWallBall = collidedWithWall<Arena>(gameState, gameState->ball.pos, ballSize);
+
+	// Reaching the back wall is a point for the other side; the ball is served
+	// again towards the player who conceded.
+	if(whichWallBall == WallLeft) {
+		++gameState->players[1].score;
+		gameState->events |= EventPointPlayer1;
+		serveBall<Arena>(gameState, -1.0f);
+	}
+	if(whichWallBall == WallRight) {
+		++gameState->players[0].score;
+		gameState->events |= EventPointPlayer0;
+		serveBall<Arena>(gameState, 1.0f);
+	}
+	if(whichWallBall == WallUp || whichWallBall == WallDown) {
+		gameState->ball.velocity = V2(gameState->ball.velocity.x, -gameState->ball.velocity.y);
+		gameState->events |= EventWallBounce;
+	}
+
+	v2 acceleration = Arena::ballAcceleration(gameState);
+	gameState->ball.velocity += dt * acceleration;
+	gameState->ball.pos += dt * gameState->ball.velocity;
+
+	// Paddles are tested against the ball's path over the whole step rather
+	// than its end position, so a fast ball can't skip through one.
+	for(int i=0; i < 2; ++i) {
+		player *paddle = gameState->players + i;
+		ball *theBall = &gameState->ball;
+
+		// The x the ball's center has when it touches the paddle's inner face,
+		// and which way it has to be moving to hit it.
+		float side = (paddle->pos.x < 0.5f*Arena::width(gameState)) ? 1.0f : -1.0f;
+		float face = paddle->pos.x + side*0.5f*(playerSize.x + ballSize.x);
+
+		float before = (theBall->prevPos.x - face) * side;
+		float after = (theBall->pos.x - face) * side;
+		if(before >= 0.0f && after < 0.0f) {
+			float t = before / (before - after);
+			float y = theBall->prevPos.y + t*(theBall->pos.y - theBall->prevPos.y);
+			if(fabsf(y - paddle->pos.y) < 0.5f*(playerSize.y + ballSize.y)) {
+				theBall->pos.x = face - side*after;
+				theBall->velocity = V2(-theBall->velocity.x, theBall->velocity.y);
+				gameState->events |= EventPaddleHit;
+			}
+		}
+	}
+
+	float paddleSpeed = Arena::paddleSpeed(gameState);
+
+	wall whichWallPlayer0 = collidedWithWall<Arena>(gameState, gameState->players[0].pos, playerSize);
+	v2 player0VelocityUp = V2(0.0f, -paddleSpeed);
+	v2 player0VelocityDown = V2(0.0f, paddleSpeed);
+
+	if(whichWallPlayer0 == WallUp) {
+		player0VelocityUp = V2(0, 0);
+	}
+	if(whichWallPlayer0 == WallDown) {
+		player0VelocityDown = V2(0, 0);
+	}
+
+	wall whichWallPlayer1 = collidedWithWall<Arena>(gameState, gameState->players[1].pos, playerSize);
+	v2 player1VelocityUp = V2(0.0f, -paddleSpeed);
+	v2 player1VelocityDown = V2(0.0f, paddleSpeed);
+
+	if(whichWallPlayer1 == WallUp) {
+		player1VelocityUp = V2(0, 0);
+	}
+	if(whichWallPlayer1 == WallDown) {
+		player1VelocityDown = V2(0, 0);
+	}
+
+
+	// Paddles only move for the part of the step their key was actually held.
+	program_input *input0 = &gameState->input[0];
+	program_input *input1 = &gameState->input[1];
+	gameState->players[0].pos += (input0->up.heldFraction * dt) * player0VelocityUp;
+	gameState->players[0].pos += (input0->down.heldFraction * dt) * player0VelocityDown;
+	gameState->players[1].pos += (input1->up.heldFraction * dt) * player1VelocityUp;
+	gameState->players[1].pos += (input1->down.heldFraction * dt) * player1VelocityDown;
+}
+
+// Picks the kernel for the state's arena; the branch is the same every call
+// for a given game, so it predicts perfectly.
+void update(game_state *gameState, float dt) {
+	switch(gameState->preset) {
+		case ArenaStandard: {
+			update<arena_standard>(gameState, dt);
+		} break;
+
+		case ArenaSmall: {
+			update<arena_small>(gameState, dt);
+		} break;
+
+		default: {
+			update<arena_runtime>(gameState, dt);
+		} break;
+	}
+}
+
+// Steps `count` independent games stored contiguously by the same dt.
+void updateBatch(game_state *games, u32 count, float dt) {
+	for(u32 i=0; i < count; ++i) {
+		update(games + i, dt);
+	}
+}
+
+#include "pong_ai.cpp"
+#include "pong_balls.cpp"
+
+// The match a host keeps in permanent storage, set up the same way by every
+// host so a -persist file written by one resumes in another. A resumed match
+// keeps its state, bots and balls; the options only shape a fresh one. The
+// pool's arrays are pushed the same way whether or not they already hold a
+// resumed state, so the permanent layout comes out the same. With neither
+// -bot0 nor -bot1 given, defaultBots puts a medium bot on both sides.
+void initMatch(game_state *gameState, bot_state *bots, ball_pool *balls, memory_arena *permanentArena,
+               const char *commandLine, bool resumed, bool defaultBots) {
+	if(!resumed) {
+		arena_config arena;
+		parseArenaOption(commandLine, &arena);
+		initGameState(gameState, &arena);
+		if(defaultBots && !strstr(commandLine, "-bot0") && !strstr(commandLine, "-bot1")) {
+			initBot(bots + 0, globalBotDifficulties[1], 0x1234567);
+			initBot(bots + 1, globalBotDifficulties[1], 0x1234568);
+		}
+		else {
+			parseBotOption(commandLine, 0, bots + 0);
+			parseBotOption(commandLine, 1, bots + 1);
+		}
+	}
+
+	u32 poolCount = resumed ? balls->capacity : parseBallsOption(commandLine);
+	if(poolCount) {
+		ball_pool resumedPool = *balls;
+		initBallPool(balls, permanentArena, poolCount,
+		             ballPoolSize(poolCount, gameState), gameState->arenaWidth, gameState->arenaHeight);
+		if(resumed) {
+			*balls = resumedPool;
+		}
+		else {
+			spawnBalls(balls, poolCount, gameState->arenaWidth, gameState->arenaHeight, 0x5EED);
+		}
+	}
+}
+
+// One fixed step of that match: the bots, update() and the pool.
+void stepMatch(game_state *gameState, bot_state *bots, ball_pool *balls, float dt) {
+	for(u32 player=0; player < 2; ++player) {
+		if(bots[player].active) {
+			botDecide(bots + player, gameState, player, dt);
+		}
+	}
+
+	update(gameState, dt);
+	if(balls->capacity) {
+		updateBallPool(balls, gameState, dt);
+	}
+}
@@ -0,0 +1,181 @@
+#ifndef PONG_GAME_H
+#define PONG_GAME_H
+
+// Everything the simulation needs, with no platform headers, so the game can
+// be built into hosts other than the Win32 one.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+
+#include "pong_math.h"
+
+#define assert(n) do{ if (!(n)) *(int*)0 = 0xA11E; }while(0)
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+#include "pong_intrinsics.h"
+
+#define kilobytes(value) ((value) * 1024LL)
+#define megabytes(value) (kilobytes(value) * 1024LL)
+#define gigabytes(value) (megabytes(value) * 1024LL)
+#define terabytes(value) (gigabytes(value) * 1024LL)
+
+#define Align16(value) (((value) + 15) & ~15)
+#define arrayCount(array) (sizeof(array) / sizeof((array)[0]))
+
+// render() interpolates between the last two simulated states, so this can be
+// set well below the display rate (30 or even 20) on slow machines.
+#define Simulation_Hz 60
+
+enum wall {
+	WallNone,
+
+	WallLeft,
+	WallRight,
+	WallUp,
+	WallDown,
+};
+
+enum game_event {
+	EventWallBounce = 0x1,
+	EventPaddleHit = 0x2,
+	EventPointPlayer0 = 0x4,
+	EventPointPlayer1 = 0x8,
+};
+
+// Arena and entity sizes and speeds, picked at startup (parseArenaOption)
+// instead of being compiled in.
+struct arena_config {
+	u32 width;
+	u32 height;
+	v2 playerSize;
+	v2 ballSize;
+
+	// How far each paddle's center sits from its back wall
+	float playerInset;
+	float paddleSpeed;
+
+	v2 ballServeVelocity;
+	v2 ballAcceleration;
+};
+
+// Configurations update() has a kernel specialized for, with every value in
+// them a constant. Anything else runs the generic kernel, which reads them
+// from the game state.
+enum arena_preset {
+	ArenaStandard,
+	ArenaSmall,
+
+	Arena_Preset_Count,
+	ArenaCustom = Arena_Preset_Count
+};
+
+// Permanent storage holds the simulation and nothing that points outside
+// itself, so a host can back it with a file and pick up where the last run
+// stopped. Transient storage is everything rebuilt at startup.
+struct game_memory {
+	u64 permanentStorageSize;
+	void *permanentStorage;
+
+	u64 transientStorageSize;
+	void *transientStorage;
+};
+
+struct memory_arena {
+	u8 *base;
+	size_t size;
+	size_t used;
+};
+
+inline void initArena(memory_arena *arena, void *base, size_t size) {
+	arena->base = (u8 *)base;
+	arena->size = size;
+	arena->used = 0;
+}
+
+#define pushStruct(arena, type) (type *)pushSize(arena, sizeof(type))
+#define pushArray(arena, count, type) (type *)pushSize(arena, (count)*sizeof(type))
+inline void *pushSize(memory_arena *arena, size_t size) {
+	size = Align16(size);
+	assert(arena->used + size <= arena->size);
+
+	void *result = arena->base + arena->used;
+	arena->used += size;
+
+	return result;
+}
+
+struct player {
+	v2 pos;
+	v2 prevPos;
+	
+	// Size is (width, height)
+	v2 size; 
+	u32 score;
+};
+
+struct ball {
+	v2 pos;
+	v2 prevPos;
+
+	// Size is (width, height)
+	v2 size; 
+	v2 velocity;
+};
+
+struct button_state {
+	bool endedDown;
+
+	// Filled per step from timestamped input events: how often the button
+	// changed state during the step, and what fraction of it it was held for.
+	u32 halfTransitionCount;
+	float heldFraction;
+};
+
+struct program_input {
+	button_state up;
+	button_state down;
+};
+
+struct game_state {
+	player players[2];
+	program_input input[2];
+	struct ball ball;
+
+	u32 arenaWidth, arenaHeight;
+
+	// The rest of the arena_config the state was set up from, and which
+	// arena_preset it matched
+	float paddleSpeed;
+	v2 ballServeVelocity;
+	v2 ballAcceleration;
+	u32 preset;
+
+	// game_event flags raised by the most recent update()
+	u32 events;
+
+	bool programRunning;
+};
+
+// Only what update() needs lives here; anything derived for drawing is built
+// on the render side each frame. Everything that copies game states around
+// (snapshots, rollouts, batched envs) pays for every byte.
+static_assert(sizeof(player) == 28, "player grew; keep render data out of the simulation");
+static_assert(sizeof(ball) == 32, "ball grew; keep render data out of the simulation");
+static_assert(sizeof(game_state) == 176, "game_state grew; keep render data out of the simulation");
+
+#include "pong_ai.h"
+#include "pong_balls.h"
+
+#endif
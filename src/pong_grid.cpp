@@ -0,0 +1,96 @@
+// See pong_grid.h.
+
+#define Grid_Line_Color 0xff404040
+
+// The number of columns that makes the cells as large as they can be for
+// arenas this shape. Every cell is the same size, and the layout always
+// has room for count of them, even if the cells come out too small to
+// draw anything in.
+match_grid layoutMatchGrid(u32 count, s32 width, s32 height, u32 arenaWidth, u32 arenaHeight) {
+	match_grid result = {1, 1, width, height};
+	float bestScale = -1.0f;
+	for(u32 columns=1; columns <= count; ++columns) {
+		u32 rows = (count + columns - 1) / columns;
+		s32 cellWidth = width / (s32)columns;
+		s32 cellHeight = height / (s32)rows;
+		float scaleX = (float)(cellWidth - Grid_Gap) / (float)arenaWidth;
+		float scaleY = (float)(cellHeight - Grid_Gap) / (float)arenaHeight;
+		float scale = (scaleX < scaleY) ? scaleX : scaleY;
+		if(scale > bestScale) {
+			bestScale = scale;
+			result.columns = (s32)columns;
+			result.rows = (s32)rows;
+			result.cellWidth = cellWidth;
+			result.cellHeight = cellHeight;
+		}
+	}
+	return result;
+}
+
+// One match filling view: a dim outline and center line, then the paddles and
+// the ball. Entities that would cover less than a pixel are skipped,
+// which at wall sizes mostly means the ball in the smallest cells. Returns
+// how many were skipped.
+static u32 drawMatchCell(pixel_image *view, game_state *gameState) {
+	float width = (float)view->width;
+	float height = (float)view->height;
+	float midX = (float)(view->width / 2);
+	drawRectangle(view, V2(0.0f, 0.0f), V2(width, 1.0f), Grid_Line_Color);
+	drawRectangle(view, V2(0.0f, height - 1.0f), V2(width, height), Grid_Line_Color);
+	drawRectangle(view, V2(0.0f, 1.0f), V2(1.0f, height - 1.0f), Grid_Line_Color);
+	drawRectangle(view, V2(width - 1.0f, 1.0f), V2(width, height - 1.0f), Grid_Line_Color);
+	drawRectangle(view, V2(midX, 0.0f), V2(midX + 1.0f, height), Grid_Line_Color);
+
+	v2 scale = V2(width / gameState->arenaWidth, height / gameState->arenaHeight);
+	v2 centers[3] = {gameState->players[0].pos, gameState->players[1].pos, gameState->ball.pos};
+	v2 sizes[3] = {gameState->players[0].size, gameState->players[1].size, gameState->ball.size};
+
+	u32 culled = 0;
+	for(u32 i=0; i < arrayCount(centers); ++i) {
+		v2 size = hadamard(scale, sizes[i]);
+		if(size.x*size.y < 1.0f) {
+			++culled;
+			continue;
+		}
+
+		v2 center = hadamard(scale, centers[i]);
+		drawRectangleAA(view, center - 0.5f*size, center + 0.5f*size, 0xffffffff);
+	}
+	return culled;
+}
+
+// games[i] goes in cell i, left to right and top to bottom, with the grid
+// centered in the frame. The grid is laid out for games[0]'s arena shape;
+// a match with a different one is letterboxed inside its cell as well.
+// Returns how many entities were too small to draw.
+u32 drawMatchGrid(pixel_image *image, game_state **games, u32 count) {
+	clearImage(image);
+	if(count == 0) {
+		return 0;
+	}
+
+	match_grid grid = layoutMatchGrid(count, image->width, image->height,
+	                                  games[0]->arenaWidth, games[0]->arenaHeight);
+	s32 originX = (image->width - grid.columns*grid.cellWidth) / 2;
+	s32 originY = (image->height - grid.rows*grid.cellHeight) / 2;
+
+	u32 culled = 0;
+	for(u32 i=0; i < count; ++i) {
+		game_state *gameState = games[i];
+		rectangle2i fit = letterboxRect((s32)gameState->arenaWidth, (s32)gameState->arenaHeight,
+		                                grid.cellWidth - Grid_Gap, grid.cellHeight - Grid_Gap, false);
+		if(fit.minX >= fit.maxX || fit.minY >= fit.maxY) {
+			continue;
+		}
+
+		s32 x = originX + ((s32)i % grid.columns)*grid.cellWidth + Grid_Gap/2 + fit.minX;
+		s32 y = originY + ((s32)i / grid.columns)*grid.cellHeight + Grid_Gap/2 + fit.minY;
+		pixel_image view;
+		view.memory = (u8 *)image->memory + y*image->pitch + x*sizeof(u32);
+		view.width = fit.maxX - fit.minX;
+		view.height = fit.maxY - fit.minY;
+		view.pitch = image->pitch;
+		culled += drawMatchCell(&view, gameState);
+	}
+	return culled;
+}
@@ -0,0 +1,19 @@
+#ifndef PONG_GRID_H
+#define PONG_GRID_H
+
+// Spectator wall: many live matches in one frame, each letterboxed into its
+// own cell of a grid and drawn in one software pass, cell by cell. Every
+// cell is a view into the frame (a pixel_image with the frame's pitch), so
+// the ordinary clipping keeps a match inside its viewport.
+
+// Black pixels between neighbouring cells
+#define Grid_Gap 2
+
+struct match_grid {
+	s32 columns;
+	s32 rows;
+	s32 cellWidth;
+	s32 cellHeight;
+};
+
+#endif
@@ -0,0 +1,97 @@
+// Cost of the spectator wall on one core: bot matches stepped every frame
+// and drawn into one frame with drawMatchGrid(), at a few wall sizes and
+// match counts. Only the drawing is timed. The clear is timed on its own
+// too, so what's left over per match shows up separately.
+//
+//   pong_grid_bench [frames]
+
+#include "pong_game.h"
+#include "pong_host.h"
+#include "pong_draw.h"
+#include "pong_grid.h"
+#include "pong_bench.h"
+#include "pong_game.cpp"
+#include "pong_particles.cpp"
+#include "pong_scale.cpp"
+#include "pong_sprite.cpp"
+#include "pong_draw.cpp"
+#include "pong_grid.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+	u32 frames = (argc > 1) ? (u32)atoi(argv[1]) : 300;
+	if(frames == 0) {
+		frames = 1;
+	}
+
+	struct wall_size {
+		s32 width, height;
+	};
+	wall_size walls[] = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+	u32 matchCounts[] = {64, 256, 1024};
+
+	printf("%10s %8s %8s %10s %10s %10s %8s %8s\n", "WALL", "MATCHES", "GRID", "US/FRAME", "CLEAR US",
+	       "US/MATCH", "FPS", "CULLED");
+	for(u32 w=0; w < arrayCount(walls); ++w) {
+		pixel_image image;
+		image.width = walls[w].width;
+		image.height = walls[w].height;
+		image.pitch = Align16(image.width*4);
+		image.memory = calloc(1, (size_t)image.pitch*image.height);
+
+		double clearSeconds = 0.0;
+		for(u32 frame=0; frame < frames; ++frame) {
+			double start = benchSeconds();
+			clearImage(&image);
+			clearSeconds += benchSeconds() - start;
+		}
+		double clearMicroseconds = (clearSeconds*1e6) / frames;
+
+		for(u32 c=0; c < arrayCount(matchCounts); ++c) {
+			u32 count = matchCounts[c];
+			game_state *games = (game_state *)calloc(count, sizeof(game_state));
+			game_state **pointers = (game_state **)calloc(count, sizeof(game_state *));
+			bot_state *bots = (bot_state *)calloc(2*count, sizeof(bot_state));
+			for(u32 i=0; i < count; ++i) {
+				initGameState(games + i, globalArenaPresets + ArenaStandard);
+				initBot(bots + 2*i + 0, globalBotDifficulties[i % 3], 0x1000 + 2*i);
+				initBot(bots + 2*i + 1, globalBotDifficulties[(i / 3) % 3], 0x1001 + 2*i);
+				pointers[i] = games + i;
+			}
+
+			float dt = 1.0f / Simulation_Hz;
+			double seconds = 0.0;
+			u32 culled = 0;
+			for(u32 frame=0; frame < frames; ++frame) {
+				for(u32 i=0; i < count; ++i) {
+					botDecide(bots + 2*i + 0, games + i, 0, dt);
+					botDecide(bots + 2*i + 1, games + i, 1, dt);
+				}
+				updateBatch(games, count, dt);
+
+				double start = benchSeconds();
+				culled = drawMatchGrid(&image, pointers, count);
+				seconds += benchSeconds() - start;
+			}
+
+			double microseconds = (seconds*1e6) / frames;
+			match_grid grid = layoutMatchGrid(count, image.width, image.height,
+			                                  games[0].arenaWidth, games[0].arenaHeight);
+			char wallName[32], gridName[32];
+			sprintf(wallName, "%dx%d", image.width, image.height);
+			sprintf(gridName, "%dx%d", grid.columns, grid.rows);
+			printf("%10s %8u %8s %10.1f %10.1f %10.2f %8.0f %8u\n", wallName, count, gridName, microseconds,
+			       clearMicroseconds, (microseconds - clearMicroseconds) / count, 1e6 / microseconds, culled);
+
+			free(bots);
+			free(pointers);
+			free(games);
+		}
+
+		free(image.memory);
+	}
+
+	return 0;
+}
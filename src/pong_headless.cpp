@@ -0,0 +1,309 @@
+// Runs the game without a window on Linux, through the same platform layer
+// and host code as the Win32 build: for servers, soak tests and CI.
+//
+//   pong_headless [options]
+//
+//   -ticks=N        fixed steps to run (default one minute of play); 0 runs
+//                   until interrupted
+//   -realtime       step at Simulation_Hz against the wall clock instead of
+//                   as fast as possible
+//   -bot0, -bot1    as in the game; with neither given both sides are
+//                   medium bots, since nobody is there to press a key
+//   -arena=NAME     arena preset and overrides (see parseArenaOption), as in
+//                   the game
+//   -balls=N        stress mode pool, as in the game
+//   -persist=FILE   permanent storage in FILE, as in the game; a file written
+//                   by a compatible Win32 build resumes here too
+//   -capture=FILE   records a frame of every tick to FILE as Y4M video, drawn
+//                   by the software renderer (without text). Fast mode waits
+//                   for the writer rather than drop frames, so it renders
+//                   the whole run as fast as the disk takes it; -realtime
+//                   drops what the writer can't keep up with.
+//   -render=WxH     size of the captured frames (default the arena's)
+//   -wall=N         captures show a spectator wall of N matches instead:
+//                   this one and N - 1 more between medium bots, stepped
+//                   alongside it but not persisted
+//
+// Prints one summary line when done.
+
+#include "pong_game.h"
+#include "pong_host.h"
+#include "pong_draw.h"
+#include "pong_capture.h"
+#include "pong_grid.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pong_game.cpp"
+#include "pong_threads.cpp"
+#include "pong_platform_linux.cpp"
+#include "pong_host.cpp"
+#include "pong_particles.cpp"
+#include "pong_scale.cpp"
+#include "pong_sprite.cpp"
+#include "pong_draw.cpp"
+#include "pong_capture.cpp"
+#include "pong_grid.cpp"
+
+// Fast mode only polls for a stop request this often.
+#define Headless_Ticks_Per_Poll 4096
+
+#define Max_Headless_Command_Line 1024
+
+#define Max_Wall_Matches 4096
+
+static volatile sig_atomic_t globalStopRequested;
+
+static void handleStopSignal(int signal) {
+	(void)signal;
+	globalStopRequested = 1;
+}
+
+// Nothing to read but a request to stop.
+bool platformProcessInput(input_queue *queue) {
+	(void)queue;
+	return !globalStopRequested;
+}
+
+void platformPresent(void) {
+}
+
+// -wall: the extra matches, in transient storage, and pointers to every
+// match on the wall with the persistent one first.
+struct headless_wall {
+	u32 count;
+	game_state *games;
+	bot_state *bots;
+	game_state **matches;
+};
+
+// Looks for "-wall=N"; 0 if it isn't there.
+static u32 parseWallOption(const char *commandLine) {
+	const char *at = strstr(commandLine, "-wall=");
+	if(!at) {
+		return 0;
+	}
+
+	u32 count = (u32)atoi(at + 6);
+	return (count < Max_Wall_Matches) ? count : Max_Wall_Matches;
+}
+
+#define wallStorageSize(count) \
+	((count)*(Align16(sizeof(game_state)) + 2*Align16(sizeof(bot_state)) + sizeof(game_state *)) + 3*16)
+
+// The extra matches start fresh in the -arena the command line asks for,
+// whether or not the persistent one was resumed.
+static void initHeadlessWall(headless_wall *wall, memory_arena *arena, u32 count, persistent_state *persistent,
+                             const char *commandLine) {
+	wall->count = count;
+	wall->games = pushArray(arena, count - 1, game_state);
+	wall->bots = pushArray(arena, 2*(count - 1), bot_state);
+	wall->matches = pushArray(arena, count, game_state *);
+
+	arena_config config;
+	parseArenaOption(commandLine, &config);
+	wall->matches[0] = &persistent->gameState;
+	for(u32 i=0; i + 1 < count; ++i) {
+		game_state *gameState = wall->games + i;
+		initGameState(gameState, &config);
+		initBot(wall->bots + 2*i + 0, globalBotDifficulties[1], 0x2000 + 2*i);
+		initBot(wall->bots + 2*i + 1, globalBotDifficulties[1], 0x2001 + 2*i);
+		wall->matches[i + 1] = gameState;
+	}
+}
+
+static void stepWall(headless_wall *wall, float dt) {
+	u32 extra = wall->count - 1;
+	for(u32 i=0; i < extra; ++i) {
+		botDecide(wall->bots + 2*i + 0, wall->games + i, 0, dt);
+		botDecide(wall->bots + 2*i + 1, wall->games + i, 1, dt);
+	}
+	updateBatch(wall->games, extra, dt);
+}
+
+// Draws the current state into the next capture frame. wait is for batch
+// rendering, which would rather slow down than drop a frame.
+static void captureHeadlessFrame(video_capture *capture, persistent_state *persistent, headless_wall *wall,
+                                 bool wait) {
+	pixel_image *frame = wait ? waitForCaptureFrame(capture) : beginCaptureFrame(capture);
+	if(!frame) {
+		return;
+	}
+
+	if(wall->count) {
+		drawMatchGrid(frame, wall->matches, wall->count);
+		endCaptureFrame(capture);
+		return;
+	}
+
+	// Everything is drawn on this thread, so the snapshot can point straight
+	// at the pool instead of copying it.
+	game_state *gameState = &persistent->gameState;
+	render_snapshot snapshot = {};
+	snapshot.arenaWidth = gameState->arenaWidth;
+	snapshot.arenaHeight = gameState->arenaHeight;
+	snapshot.players[0] = gameState->players[0];
+	snapshot.players[1] = gameState->players[1];
+	snapshot.ball = gameState->ball;
+
+	ball_pool *balls = &persistent->balls;
+	if(balls->capacity) {
+		snapshot.poolCount = balls->count;
+		snapshot.poolSize = balls->size;
+		snapshot.poolX = balls->x;
+		snapshot.poolY = balls->y;
+		snapshot.poolPrevX = balls->prevX;
+		snapshot.poolPrevY = balls->prevY;
+	}
+
+	drawSceneSoftware(&snapshot, 0, 0, frame, 1.0f);
+	endCaptureFrame(capture);
+}
+
+int main(int argc, char **argv) {
+	u64 startCounter = platformGetCounter();
+	u64 frequency = platformCounterFrequency();
+
+	// Flattened into one string so the option parsers see what WinMain gets.
+	char commandLine[Max_Headless_Command_Line] = {};
+	u32 length = 0;
+	for(int i=1; i < argc; ++i) {
+		u32 argLength = (u32)strlen(argv[i]);
+		if(length + argLength + 2 > sizeof(commandLine)) {
+			break;
+		}
+		memcpy(commandLine + length, argv[i], argLength);
+		length += argLength;
+		commandLine[length++] = ' ';
+	}
+	commandLine[length] = 0;
+
+	u64 tickLimit = Simulation_Hz * 60;
+	const char *ticksOption = strstr(commandLine, "-ticks=");
+	if(ticksOption) {
+		tickLimit = strtoull(ticksOption + 7, 0, 10);
+	}
+	bool realtime = (strstr(commandLine, "-realtime") != 0);
+
+	signal(SIGINT, handleStopSignal);
+	signal(SIGTERM, handleStopSignal);
+
+	// Permanent storage is sized as in the Win32 host so a -persist file fits
+	// both; nothing transient is needed without a renderer, bar a wall.
+	u32 wallCount = parseWallOption(commandLine);
+	host_memory hostMemory;
+	initHostMemory(&hostMemory, commandLine, megabytes(16), kilobytes(64) + wallStorageSize(wallCount));
+	persistent_state *persistent = hostMemory.persistent;
+	bool resumed = (hostMemory.persistence == PersistentResumed);
+
+	initMatch(&persistent->gameState, persistent->bots, &persistent->balls, &hostMemory.permanentArena, commandLine,
+	          resumed, true);
+	markPersistentMemoryInitialized(&hostMemory);
+
+	headless_wall wall = {};
+	if(wallCount > 1) {
+		initHeadlessWall(&wall, &hostMemory.transientArena, wallCount, persistent, commandLine);
+	}
+
+	video_capture capture = {};
+	char capturePath[Max_Capture_Path];
+	bool capturing = false;
+	if(parseCaptureOption(commandLine, capturePath, sizeof(capturePath))) {
+		u32 captureWidth = persistent->gameState.arenaWidth;
+		u32 captureHeight = persistent->gameState.arenaHeight;
+		const char *renderOption = strstr(commandLine, "-render=");
+		if(renderOption) {
+			int width = atoi(renderOption + 8);
+			const char *separator = strchr(renderOption + 8, 'x');
+			int height = separator ? atoi(separator + 1) : 0;
+			if(width > 0 && height > 0) {
+				captureWidth = (u32)width;
+				captureHeight = (u32)height;
+			}
+		}
+
+		capturing = startCapture(&capture, capturePath, captureWidth, captureHeight, Simulation_Hz);
+		if(!capturing) {
+			fprintf(stderr, "Couldn't capture to %s\n", capturePath);
+		}
+	}
+
+	u64 startupMicroseconds = getMicrosecondsElapsed(startCounter, platformGetCounter(), frequency);
+
+	// The tick is stored with every step, as the Win32 simulation thread
+	// does, so a run that's killed resumes with the tick its state is at.
+	u64 runStart = platformGetCounter();
+	float dt = 1.0f / Simulation_Hz;
+	u64 ticks = 0;
+
+	if(realtime) {
+		tick_clock clock;
+		initTickClock(&clock, frequency, Simulation_Hz, runStart);
+		while((!tickLimit || ticks < tickLimit) && platformProcessInput(0)) {
+			tickClockBeginFrame(&clock, platformGetCounter());
+
+			u32 steps;
+			bool stepped = false;
+			while((steps = tickClockNextStep(&clock)) != 0) {
+				float stepSeconds = tickClockSeconds(&clock, steps);
+				stepMatch(&persistent->gameState, persistent->bots, &persistent->balls, stepSeconds);
+				if(wall.count) {
+					stepWall(&wall, stepSeconds);
+				}
+				persistent->tick += steps;
+				ticks += steps;
+				stepped = true;
+			}
+			if(capturing && stepped) {
+				captureHeadlessFrame(&capture, persistent, &wall, false);
+			}
+
+			u64 untilNextTick = tickClockSpan(&clock, 1) - clock.accumulator;
+			u64 msUntilNextTick = (untilNextTick * 1000) / frequency;
+			platformSleep((msUntilNextTick > 1) ? (u32)(msUntilNextTick - 1) : 0);
+		}
+	}
+	else {
+		while((!tickLimit || ticks < tickLimit) && platformProcessInput(0)) {
+			u64 batch = Headless_Ticks_Per_Poll;
+			if(tickLimit && batch > tickLimit - ticks) {
+				batch = tickLimit - ticks;
+			}
+			for(u64 i=0; i < batch; ++i) {
+				stepMatch(&persistent->gameState, persistent->bots, &persistent->balls, dt);
+				if(wall.count) {
+					stepWall(&wall, dt);
+				}
+				++persistent->tick;
+				if(capturing) {
+					captureHeadlessFrame(&capture, persistent, &wall, true);
+				}
+			}
+			ticks += batch;
+		}
+	}
+	// The video is finished when the writer is, so that counts as run time.
+	if(capturing) {
+		stopCapture(&capture);
+	}
+
+	u64 runMicroseconds = getMicrosecondsElapsed(runStart, platformGetCounter(), frequency);
+	game_state *gameState = &persistent->gameState;
+	printf("%llu ticks (tick %llu), score %u:%u, %.0f ticks/s, startup %lluus%s\n",
+	       (unsigned long long)ticks, (unsigned long long)persistent->tick,
+	       gameState->players[0].score, gameState->players[1].score,
+	       runMicroseconds ? (ticks * 1000000.0) / runMicroseconds : 0.0,
+	       (unsigned long long)startupMicroseconds, resumed ? " (resumed)" : "");
+	if(capturing) {
+		printf("captured %u frames at %ux%u to %s (%u dropped)%s%s\n", capture.written,
+		       capture.width, capture.height, capturePath, capture.dropped,
+		       capture.writeFailed ? ", stopped by a write error" : "",
+		       wall.count ? ", as a wall of every match" : "");
+	}
+
+	releaseHostMemory(&hostMemory);
+	return 0;
+}
@@ -0,0 +1,558 @@
+// Host code shared by every platform; see pong_host.h.
+
+bool pushInputEvent(input_queue *queue, u64 time, u8 player, u8 button, bool isDown) {
+	u32 writeIndex = queue->writeIndex;
+	if(writeIndex - atomicLoadU32(&queue->readIndex) == Input_Queue_Size) {
+		return false;
+	}
+
+	input_event *event = queue->events + (writeIndex & (Input_Queue_Size - 1));
+	event->time = time;
+	event->player = player;
+	event->button = button;
+	event->isDown = isDown;
+
+	atomicStoreU32(&queue->writeIndex, writeIndex + 1);
+	return true;
+}
+
+// Pops the oldest event only if it happened before `before`, so events that
+// belong to a later step stay queued.
+bool popInputEventBefore(input_queue *queue, u64 before, input_event *result) {
+	u32 readIndex = queue->readIndex;
+	if(readIndex == atomicLoadU32(&queue->writeIndex)) {
+		return false;
+	}
+
+	input_event *event = queue->events + (readIndex & (Input_Queue_Size - 1));
+	if(event->time >= before) {
+		return false;
+	}
+	*result = *event;
+
+	atomicStoreU32(&queue->readIndex, readIndex + 1);
+	return true;
+}
+
+void initTripleBuffer(triple_buffer *buffer) {
+	buffer->front = 0;
+	buffer->middle = 1;
+	buffer->back = 2;
+}
+
+inline render_snapshot *beginSnapshot(triple_buffer *buffer) {
+	render_snapshot *result = buffer->slots + buffer->back;
+	return result;
+}
+
+// Hand the slot that was just written to the reader and take back whatever
+// spare slot it left in the middle.
+inline void publishSnapshot(triple_buffer *buffer) {
+	u32 previous = atomicExchangeU32(&buffer->middle, buffer->back | Triple_Buffer_Fresh);
+	buffer->back = previous & ~Triple_Buffer_Fresh;
+}
+
+// Never blocks; returns the newest published snapshot, or the one read last
+// time if nothing new has arrived since.
+inline render_snapshot *latestSnapshot(triple_buffer *buffer) {
+	if(atomicLoadU32(&buffer->middle) & Triple_Buffer_Fresh) {
+		u32 previous = atomicExchangeU32(&buffer->middle, buffer->front);
+		buffer->front = previous & ~Triple_Buffer_Fresh;
+	}
+
+	render_snapshot *result = buffer->slots + buffer->front;
+	return result;
+}
+
+inline u64 getMicrosecondsElapsed(u64 start, u64 end, u64 frequency) {
+	u64 result = ((end - start) * 1000000) / frequency;
+	return result;
+}
+
+// Split so the multiply can't overflow however long the machine has been up.
+u64 getRolloutClock(void) {
+	u64 counter = platformGetCounter();
+	u64 frequency = platformCounterFrequency();
+	u64 result = (counter / frequency) * 1000000 + ((counter % frequency) * 1000000) / frequency;
+	return result;
+}
+
+void initTickClock(tick_clock *clock, u64 frequency, u32 rate, u64 now) {
+	*clock = {};
+	clock->frequency = frequency;
+	clock->rate = rate;
+	clock->step = frequency / rate;
+	clock->stepRemainder = frequency % rate;
+	clock->last = now;
+	clock->maxStepsPerFrame = Max_Steps_Per_Frame;
+#if SWEPT_CATCH_UP
+	clock->maxSweepFactor = Max_Sweep_Factor;
+#else
+	clock->maxSweepFactor = 1;
+#endif
+	clock->sweep = 1;
+}
+
+// Number of counter ticks covered by the next `steps` fixed steps.
+inline u64 tickClockSpan(tick_clock *clock, u64 steps) {
+	u64 result = steps*clock->step + (clock->stepError + steps*clock->stepRemainder) / clock->rate;
+	return result;
+}
+
+inline void tickClockConsume(tick_clock *clock, u64 steps) {
+	clock->accumulator -= tickClockSpan(clock, steps);
+	clock->stepError = (clock->stepError + steps*clock->stepRemainder) % clock->rate;
+}
+
+void tickClockBeginFrame(tick_clock *clock, u64 now) {
+	clock->accumulator += now - clock->last;
+	clock->last = now;
+
+	u64 pending = clock->accumulator / clock->step;
+	while(pending && tickClockSpan(clock, pending) > clock->accumulator) {
+		--pending;
+	}
+
+	// Spiral-of-death cap: never run more than maxStepsPerFrame updates. With
+	// sweeping enabled, a backlog is first absorbed by merging steps; only what
+	// is beyond maxStepsPerFrame * maxSweepFactor is thrown away.
+	u64 budget = (u64)clock->maxStepsPerFrame * clock->maxSweepFactor;
+	if(pending > budget) {
+		u64 dropped = pending - budget;
+		clock->droppedTime += tickClockSpan(clock, dropped);
+		clock->droppedSteps += dropped;
+		++clock->droppedFrames;
+		tickClockConsume(clock, dropped);
+		pending = budget;
+	}
+
+	clock->sweep = 1;
+	if(pending > clock->maxStepsPerFrame) {
+		clock->sweep = (u32)((pending + clock->maxStepsPerFrame - 1) / clock->maxStepsPerFrame);
+	}
+	clock->pendingSteps = pending;
+}
+
+// Returns how many fixed steps the next update() should cover, 0 when the
+// frame has been fully simulated.
+u32 tickClockNextStep(tick_clock *clock) {
+	if(clock->pendingSteps == 0) {
+		return 0;
+	}
+
+	u32 result = clock->sweep;
+	if(result > clock->pendingSteps) {
+		result = (u32)clock->pendingSteps;
+	}
+	if(result > 1) {
+		++clock->sweptUpdates;
+	}
+
+	tickClockConsume(clock, result);
+	clock->pendingSteps -= result;
+	clock->tick += result;
+
+	return result;
+}
+
+inline float tickClockSeconds(tick_clock *clock, u32 steps) {
+	float result = (float)steps / (float)clock->rate;
+	return result;
+}
+
+inline float tickClockOffset(tick_clock *clock) {
+	float result = (float)clock->accumulator / (float)tickClockSpan(clock, 1);
+	return result;
+}
+
+void recordFrameTime(frame_histogram *histogram, u64 microseconds) {
+	u64 bucket = microseconds / Frame_Histogram_Bucket_Microseconds;
+	if(bucket >= Frame_Histogram_Buckets) {
+		bucket = Frame_Histogram_Buckets - 1;
+	}
+
+	++histogram->buckets[bucket];
+	++histogram->count;
+
+	// Halve everything once the window fills so old frames fade out instead of
+	// dominating the percentiles forever.
+	if(histogram->count >= Frame_Histogram_Window) {
+		histogram->count = 0;
+		for(int i=0; i < Frame_Histogram_Buckets; ++i) {
+			histogram->buckets[i] >>= 1;
+			histogram->count += histogram->buckets[i];
+		}
+	}
+}
+
+// Level 0 is the base size, each one after it an eighth smaller on both
+// sides. Widths stay multiples of 4 for the 4-wide pixel loops.
+void resolutionLevelSize(resolution_controller *controller, u32 level, u32 *width, u32 *height) {
+	u32 eighths = 8 - level;
+	*width = ((controller->baseWidth*eighths / 8) + 3) & ~3u;
+	*height = controller->baseHeight*eighths / 8;
+}
+
+void initResolutionController(resolution_controller *controller, u32 baseWidth, u32 baseHeight,
+                              u64 budgetMicroseconds, bool enabled) {
+	*controller = {};
+	controller->enabled = enabled;
+	controller->baseWidth = baseWidth;
+	controller->baseHeight = baseHeight;
+	controller->budgetMicroseconds = budgetMicroseconds;
+}
+
+// Called with each frame's render time. Returns true when the internal
+// resolution should change to resolutionLevelSize(controller->level).
+// Decisions are only taken once per window of frames, and the window starts
+// over after a change so the new size is judged on its own frames.
+bool updateResolutionController(resolution_controller *controller, u64 renderMicroseconds) {
+	if(!controller->enabled) {
+		return false;
+	}
+
+	controller->windowMicroseconds += renderMicroseconds;
+	if(++controller->windowFrames < Resolution_Window_Frames) {
+		return false;
+	}
+
+	float average = (float)controller->windowMicroseconds / (float)controller->windowFrames;
+	float budget = (float)controller->budgetMicroseconds;
+	controller->windowMicroseconds = 0;
+	controller->windowFrames = 0;
+
+	u32 level = controller->level;
+	u32 width, height;
+	resolutionLevelSize(controller, level, &width, &height);
+
+	u32 newLevel = level;
+	if(average > budget && level + 1 < Resolution_Levels) {
+		newLevel = level + 1;
+	}
+	else if(level > 0) {
+		// Render time goes roughly with the pixel count.
+		u32 upWidth, upHeight;
+		resolutionLevelSize(controller, level - 1, &upWidth, &upHeight);
+		float predicted = average * (float)(upWidth*upHeight) / (float)(width*height);
+		if(predicted < Resolution_Raise_Headroom*budget) {
+			newLevel = level - 1;
+		}
+	}
+
+	if(newLevel == level) {
+		return false;
+	}
+
+	u32 newWidth, newHeight;
+	resolutionLevelSize(controller, newLevel, &newWidth, &newHeight);
+
+	char text[160];
+	formatText(text, "Dynamic resolution: %.2fms average against a %.2fms budget, %ux%u -> %ux%u\n",
+	         average / 1000.0f, budget / 1000.0f, width, height, newWidth, newHeight);
+	platformLog(text);
+
+	controller->level = newLevel;
+	++controller->changes;
+	return true;
+}
+
+inline button_state *getButton(game_state *gameState, u32 player, u32 button) {
+	program_input *input = &gameState->input[player];
+	button_state *result = (button == ButtonUp) ? &input->up : &input->down;
+	return result;
+}
+
+// Applies every queued event that falls inside [start, end) and works out, per
+// button, how many transitions happened and for what fraction of the step it
+// was held. Events that arrived late (stamped before start) count as
+// happening at start.
+void integrateInput(simulation_context *sim, u64 start, u64 end) {
+	game_state *gameState = sim->gameState;
+	// Indexed [player][button]
+	u64 heldTime[2][2] = {};
+	u64 downSince[2][2];
+
+	for(u32 player=0; player < 2; ++player) {
+		for(u32 button=0; button < 2; ++button) {
+			getButton(gameState, player, button)->halfTransitionCount = 0;
+			downSince[player][button] = start;
+		}
+	}
+
+	input_event event;
+	while(popInputEventBefore(&sim->input, end, &event)) {
+		button_state *state = getButton(gameState, event.player, event.button);
+		bool isDown = (event.isDown != 0);
+		if(state->endedDown == isDown) {
+			continue;
+		}
+
+		u64 time = (event.time < start) ? start : event.time;
+		if(state->endedDown) {
+			heldTime[event.player][event.button] += time - downSince[event.player][event.button];
+		}
+		else {
+			downSince[event.player][event.button] = time;
+		}
+
+		state->endedDown = isDown;
+		++state->halfTransitionCount;
+	}
+
+	float span = (float)(end - start);
+	for(u32 player=0; player < 2; ++player) {
+		for(u32 button=0; button < 2; ++button) {
+			button_state *state = getButton(gameState, player, button);
+			if(state->endedDown) {
+				heldTime[player][button] += end - downSince[player][button];
+			}
+			state->heldFraction = (span > 0.0f) ? ((float)heldTime[player][button] / span) : 0.0f;
+		}
+	}
+}
+
+// What a persisted field holds, so retyping one changes the layout hash
+// even when its size and offset stay the same.
+enum layout_kind {
+	LayoutStruct,
+	LayoutBool,
+	LayoutChar,
+	LayoutU32,
+	LayoutU64,
+	LayoutFloat,
+	LayoutPointer,
+};
+
+template<typename T> inline u64 layoutKind(T *) { return LayoutStruct; }
+template<typename T> inline u64 layoutKind(T **) { return LayoutPointer; }
+template<typename T, size_t N> inline u64 layoutKind(T (*)[N]) { return layoutKind((T *)0); }
+inline u64 layoutKind(bool *) { return LayoutBool; }
+inline u64 layoutKind(char *) { return LayoutChar; }
+inline u64 layoutKind(u32 *) { return LayoutU32; }
+inline u64 layoutKind(u64 *) { return LayoutU64; }
+inline u64 layoutKind(float *) { return LayoutFloat; }
+
+#define Layout_Field(type, field) \
+	offsetof(type, field), sizeof(((type *)0)->field), layoutKind((decltype(((type *)0)->field) *)0)
+
+// Changes whenever anything stored in permanent storage changes size or
+// shape, so a build never maps a file laid out by a different one. Every
+// field of every struct in there is listed; a field added without being
+// listed here still changes its struct's size, but not a reordering.
+u64 persistentLayoutHash(u64 size) {
+	u64 layout[] = {
+		Bot_History_Size, Max_Pool_Balls, Simulation_Hz, size,
+
+		sizeof(persistent_header),
+		Layout_Field(persistent_header, magic),
+		Layout_Field(persistent_header, version),
+		Layout_Field(persistent_header, layoutHash),
+		Layout_Field(persistent_header, baseAddress),
+		Layout_Field(persistent_header, size),
+		Layout_Field(persistent_header, initialized),
+
+		sizeof(persistent_state),
+		Layout_Field(persistent_state, gameState),
+		Layout_Field(persistent_state, bots),
+		Layout_Field(persistent_state, tick),
+		Layout_Field(persistent_state, balls),
+
+		sizeof(v2),
+		Layout_Field(v2, x),
+		Layout_Field(v2, y),
+
+		sizeof(game_state),
+		Layout_Field(game_state, players),
+		Layout_Field(game_state, input),
+		Layout_Field(game_state, ball),
+		Layout_Field(game_state, arenaWidth),
+		Layout_Field(game_state, arenaHeight),
+		Layout_Field(game_state, paddleSpeed),
+		Layout_Field(game_state, ballServeVelocity),
+		Layout_Field(game_state, ballAcceleration),
+		Layout_Field(game_state, preset),
+		Layout_Field(game_state, events),
+		Layout_Field(game_state, programRunning),
+
+		sizeof(player),
+		Layout_Field(player, pos),
+		Layout_Field(player, prevPos),
+		Layout_Field(player, size),
+		Layout_Field(player, score),
+
+		sizeof(ball),
+		Layout_Field(ball, pos),
+		Layout_Field(ball, prevPos),
+		Layout_Field(ball, size),
+		Layout_Field(ball, velocity),
+
+		sizeof(program_input),
+		Layout_Field(program_input, up),
+		Layout_Field(program_input, down),
+
+		sizeof(button_state),
+		Layout_Field(button_state, endedDown),
+		Layout_Field(button_state, halfTransitionCount),
+		Layout_Field(button_state, heldFraction),
+
+		sizeof(bot_state),
+		Layout_Field(bot_state, active),
+		Layout_Field(bot_state, difficulty),
+		Layout_Field(bot_state, random),
+		Layout_Field(bot_state, ticksUntilReplan),
+		Layout_Field(bot_state, targetY),
+		Layout_Field(bot_state, observed),
+		Layout_Field(bot_state, history),
+
+		sizeof(bot_difficulty),
+		Layout_Field(bot_difficulty, reactionTicks),
+		Layout_Field(bot_difficulty, noise),
+		Layout_Field(bot_difficulty, deadZone),
+
+		sizeof(bot_observation),
+		Layout_Field(bot_observation, pos),
+		Layout_Field(bot_observation, velocity),
+
+		sizeof(ball_pool),
+		Layout_Field(ball_pool, count),
+		Layout_Field(ball_pool, capacity),
+		Layout_Field(ball_pool, size),
+		Layout_Field(ball_pool, x),
+		Layout_Field(ball_pool, y),
+		Layout_Field(ball_pool, prevX),
+		Layout_Field(ball_pool, prevY),
+		Layout_Field(ball_pool, velocityX),
+		Layout_Field(ball_pool, velocityY),
+		Layout_Field(ball_pool, cellSize),
+		Layout_Field(ball_pool, cellsX),
+		Layout_Field(ball_pool, cellsY),
+		Layout_Field(ball_pool, cellStart),
+		Layout_Field(ball_pool, ballCell),
+		Layout_Field(ball_pool, order),
+		Layout_Field(ball_pool, scratch),
+		Layout_Field(ball_pool, pairTests),
+		Layout_Field(ball_pool, contacts),
+	};
+
+	// FNV-1a
+	u64 hash = 0xCBF29CE484222325ULL;
+	u8 *bytes = (u8 *)layout;
+	for(u32 i=0; i < sizeof(layout); ++i) {
+		hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+inline void writePersistentHeader(persistent_header *header, u64 size) {
+	memcpy(header->magic, "PMEM", 4);
+	header->version = Persistent_Version;
+	header->layoutHash = persistentLayoutHash(size);
+	header->baseAddress = Persistent_Base_Address;
+	header->size = size;
+	header->initialized = 0;
+}
+
+// Copies the path after "-persist=" (up to the next space) into path; false
+// if the option isn't there.
+bool parsePersistOption(const char *commandLine, char *path, u32 pathSize) {
+	const char *at = strstr(commandLine, "-persist=");
+	if(!at) {
+		return false;
+	}
+
+	at += 9;
+	u32 length = 0;
+	while(at[length] && at[length] != ' ' && length + 1 < pathSize) {
+		path[length] = at[length];
+		++length;
+	}
+	path[length] = 0;
+	return length > 0;
+}
+
+// Maps path as permanent storage, creating it if it doesn't exist. A file
+// written by an incompatible build is left alone and nothing is mapped, as
+// is everything else that goes wrong; the caller falls back to plain memory.
+persistent_result openPersistentMemory(platform_mapped_file *file, const char *path, game_memory *memory) {
+	u64 size = memory->permanentStorageSize;
+	platform_map_result mapped = platformMapFile(file, path, size, Persistent_Base_Address);
+	if(mapped == PlatformMapWrongSize) {
+		platformLog("Persistent memory file is from an incompatible build; not mapping it\n");
+		return PersistentNone;
+	}
+	if(mapped == PlatformMapFailed) {
+		platformLog("Couldn't map persistent memory at its base address\n");
+		return PersistentNone;
+	}
+
+	persistent_header expected;
+	writePersistentHeader(&expected, size);
+
+	persistent_header *header = (persistent_header *)file->memory;
+	if(mapped == PlatformMapOpened) {
+		if(memcmp(header->magic, expected.magic, 4) != 0 || header->version != expected.version ||
+		   header->layoutHash != expected.layoutHash || header->baseAddress != expected.baseAddress ||
+		   header->size != expected.size) {
+			platformLog("Persistent memory file is from an incompatible build; not mapping it\n");
+			platformUnmapFile(file);
+			return PersistentNone;
+		}
+
+		if(header->initialized) {
+			memory->permanentStorage = file->memory;
+			return PersistentResumed;
+		}
+	}
+
+	// A file that was just created is already zero; only an old one that
+	// never finished initializing needs clearing.
+	if(mapped == PlatformMapOpened) {
+		memset(file->memory, 0, (size_t)size);
+	}
+	*header = expected;
+	memory->permanentStorage = file->memory;
+	return PersistentFresh;
+}
+
+// Permanent storage from the -persist file if there is one and it fits,
+// plain memory otherwise; transient storage is always plain memory. The
+// permanent layout has to come out the same every run: the header, the
+// state, then whatever the game pushes after them (the ball pool's arrays).
+void initHostMemory(host_memory *host, const char *commandLine, u64 permanentSize, u64 transientSize) {
+	*host = {};
+	game_memory *memory = &host->memory;
+	memory->permanentStorageSize = permanentSize;
+	memory->transientStorageSize = transientSize;
+
+	char path[Max_Persistent_Path];
+	if(parsePersistOption(commandLine, path, sizeof(path))) {
+		host->persistence = openPersistentMemory(&host->persistentFile, path, memory);
+	}
+	if(host->persistence == PersistentNone) {
+		memory->permanentStorage = platformAllocateMemory((size_t)permanentSize);
+	}
+	memory->transientStorage = platformAllocateMemory((size_t)transientSize);
+
+	initArena(&host->permanentArena, memory->permanentStorage, (size_t)permanentSize);
+	host->header = pushStruct(&host->permanentArena, persistent_header);
+	host->persistent = pushStruct(&host->permanentArena, persistent_state);
+	initArena(&host->transientArena, memory->transientStorage, (size_t)transientSize);
+}
+
+// Once a fresh state is completely built, a later run may resume it.
+void markPersistentMemoryInitialized(host_memory *host) {
+	if(host->persistence != PersistentNone) {
+		host->header->initialized = 1;
+	}
+}
+
+void releaseHostMemory(host_memory *host) {
+	game_memory *memory = &host->memory;
+	if(host->persistence != PersistentNone) {
+		platformUnmapFile(&host->persistentFile);
+	}
+	else {
+		platformFreeMemory(memory->permanentStorage, (size_t)memory->permanentStorageSize);
+	}
+	platformFreeMemory(memory->transientStorage, (size_t)memory->transientStorageSize);
+}
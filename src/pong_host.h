@@ -0,0 +1,268 @@
+#ifndef PONG_HOST_H
+#define PONG_HOST_H
+
+// The parts of a host that don't depend on the operating system: the fixed
+// step clock, input queue, snapshots and persistent memory. Everything
+// platform specific goes through pong_platform.h.
+
+#include "pong_game.h"
+#include "pong_threads.h"
+#include "pong_rollout.h"
+#include "pong_particles.h"
+#include "pong_module.h"
+#include "pong_platform.h"
+
+#define SWEPT_CATCH_UP 1
+
+// printf into a char array, with whichever bounded sprintf this compiler has
+#if defined(_WIN32)
+#define formatText(array, ...) sprintf_s(array, __VA_ARGS__)
+#else
+#define formatText(array, ...) snprintf(array, sizeof(array), __VA_ARGS__)
+#endif
+
+#define Max_Steps_Per_Frame 8
+#define Max_Sweep_Factor 4
+
+// Must be a power of two
+#define Input_Queue_Size 256
+
+// Frame times are bucketed in 0.1ms steps; the last bucket catches everything
+// slower than that.
+#define Frame_Histogram_Buckets 500
+#define Frame_Histogram_Bucket_Microseconds 100
+#define Frame_Histogram_Window 600
+
+// Dynamic resolution: internal resolution steps in eighths of the base size
+// (8/8 down to 4/8), decided on the average render time of each window of
+// frames against the budget. Stepping back up also has to leave headroom
+// below the budget at the larger size, so it doesn't flip straight back.
+#define Resolution_Levels 5
+#define Resolution_Window_Frames 30
+#define Resolution_Raise_Headroom 0.8f
+#define Default_Render_Budget_Microseconds 10000
+
+// Win-probability rollouts are relaunched at most this often and get this
+// long on the worker threads before they give up.
+#define Rollout_Interval_Ticks 15
+#define Rollout_Budget_Microseconds 4000
+#define Rollout_Max_Ticks (Simulation_Hz * 30)
+
+// Effect events are kept in a ring this long (a power of two). The render
+// thread only misses some if it falls this many events behind.
+#define Max_Effect_Events 32
+
+// Fixed-step clock kept entirely in performance counter units. The step is
+// frequency / rate counts plus a Bresenham-style error term, so the average
+// step is exact and nothing drifts no matter how long the session runs.
+struct tick_clock {
+	u64 frequency;
+	u32 rate;
+
+	u64 step;
+	u64 stepRemainder;
+	u64 stepError;
+
+	u64 last;
+	u64 accumulator;
+	u64 tick;
+
+	// Catch-up control. When more steps are pending than maxStepsPerFrame,
+	// several steps get merged into one update (up to maxSweepFactor) and
+	// whatever is still left over gets dropped.
+	u32 maxStepsPerFrame;
+	u32 maxSweepFactor;
+	u32 sweep;
+	u64 pendingSteps;
+
+	// Dropped time statistics
+	u64 droppedTime;
+	u64 droppedSteps;
+	u32 droppedFrames;
+	u64 sweptUpdates;
+};
+
+enum button {
+	ButtonUp,
+	ButtonDown,
+};
+
+struct input_event {
+	// Performance counter value at which the event was seen
+	u64 time;
+
+	u8 player;
+	u8 button;
+	u8 isDown;
+};
+
+// Single producer (window thread), single consumer (simulation thread).
+// The indices only ever increase; they're masked on access.
+struct input_queue {
+	input_event events[Input_Queue_Size];
+	u32 volatile writeIndex;
+	u32 volatile readIndex;
+};
+
+// Everything the render thread needs from one simulation step.
+struct render_snapshot {
+	u32 arenaWidth, arenaHeight;
+	player players[2];
+	struct ball ball;
+
+	// Counter value the newest state corresponds to and the length of the step
+	// that produced it, so the renderer can work out its own blend offset.
+	u64 stateTime;
+	u64 stepTime;
+
+	u64 tick;
+	u64 droppedTime;
+	u32 droppedFrames;
+	u64 sweptUpdates;
+
+	// Stress-mode balls; the arrays belong to this slot.
+	u32 poolCount;
+	float poolSize;
+	u32 poolContacts;
+	float *poolX;
+	float *poolY;
+	float *poolPrevX;
+	float *poolPrevY;
+
+	// From the latest finished batch of rollouts
+	float winProbability;
+	u32 rolloutsDecided;
+	u32 rolloutsLaunched;
+	float rolloutMs;
+
+	// The last Max_Effect_Events effect events; effectCount is the total
+	// ever recorded, so the renderer spawns everything past what it has seen.
+	effect_event effects[Max_Effect_Events];
+	u32 effectCount;
+};
+
+#define Triple_Buffer_Fresh 0x4
+
+// Lock-free triple buffer. The writer owns slots[back], the reader owns
+// slots[front], and `middle` holds the index of the spare slot plus a flag
+// saying whether it holds something the reader hasn't seen yet.
+struct triple_buffer {
+	render_snapshot slots[3];
+	u32 volatile middle;
+	u32 back;
+	u32 front;
+};
+
+// With -persist=<file>, permanent storage is that file mapped at
+// Persistent_Base_Address, so the pointers inside it (the ball pool arrays)
+// are valid again in the next run without any fixing up.
+#define Persistent_Base_Address terabytes(2)
+#define Persistent_Version 1
+
+// First thing in permanent storage. A file is only mapped if its header is
+// exactly what this build would have written.
+struct persistent_header {
+	char magic[4];
+	u32 version;
+	u64 layoutHash;
+	u64 baseAddress;
+	u64 size;
+
+	// Cleared while a fresh state is being set up, so a run killed halfway
+	// through doesn't leave a half-built state behind to resume.
+	u32 initialized;
+};
+
+// Everything the simulation carries from one run to the next, right after
+// the header. Nothing is serialized; the sim thread updates it in place.
+struct persistent_state {
+	game_state gameState;
+
+	// Players with an active bot ignore their keyboard input.
+	bot_state bots[2];
+	u64 tick;
+
+	// Stress-mode balls; capacity is 0 unless started with -balls=N.
+	ball_pool balls;
+};
+
+enum persistent_result {
+	PersistentNone,
+	PersistentFresh,
+	PersistentResumed,
+};
+
+#define Max_Persistent_Path 260
+
+// Both storages and where they came from
+struct host_memory {
+	game_memory memory;
+	persistent_result persistence;
+	platform_mapped_file persistentFile;
+
+	memory_arena permanentArena;
+	memory_arena transientArena;
+	persistent_header *header;
+	persistent_state *persistent;
+};
+
+struct game_code;
+
+struct simulation_context {
+	game_state *gameState;
+	tick_clock clock;
+	persistent_state *persistent;
+	bot_state *bots;
+
+	input_queue input;
+	triple_buffer snapshots;
+
+	// 0 unless the pool has any capacity
+	ball_pool *balls;
+
+	// Filled in by the host for the game to build its rollout engine on
+	work_queue *workQueue;
+	rollout_clock *rolloutClock;
+
+	rollout_engine *rollouts;
+	u32 rolloutCount;
+	u64 nextRolloutTick;
+	rollout_result rolloutResult;
+
+	effect_event effects[Max_Effect_Events];
+	u32 effectCount;
+
+	// The simulation thread runs game code, so while the host swaps it the
+	// thread parks itself between frames: the host raises pauseRequested and
+	// waits for paused.
+	game_code *code;
+	u32 volatile pauseRequested;
+	u32 volatile paused;
+
+	// Whether the game's initialize has run. Until the first valid library
+	// loads the host runs on stubs, and initialize waits for that load.
+	bool initialized;
+
+	u32 volatile running;
+};
+
+struct frame_histogram {
+	u32 buckets[Frame_Histogram_Buckets];
+	u32 count;
+};
+
+struct resolution_controller {
+	bool enabled;
+	u32 baseWidth;
+	u32 baseHeight;
+	u64 budgetMicroseconds;
+
+	// 0 is the base size
+	u32 level;
+	u32 changes;
+
+	u64 windowMicroseconds;
+	u32 windowFrames;
+};
+
+#endif
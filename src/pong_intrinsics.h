@@ -0,0 +1,79 @@
+#ifndef PONG_INTRINSICS_H
+#define PONG_INTRINSICS_H
+
+// Just enough atomics for the structures that pass data between threads. On
+// x64 plain aligned loads and stores already have acquire/release semantics,
+// so only the compiler needs to be kept from reordering around them.
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+inline u32 atomicLoadU32(u32 volatile *value) {
+	u32 result = *value;
+	_ReadWriteBarrier();
+	return result;
+}
+
+inline void atomicStoreU32(u32 volatile *value, u32 newValue) {
+	_ReadWriteBarrier();
+	*value = newValue;
+}
+
+inline u32 atomicExchangeU32(u32 volatile *value, u32 newValue) {
+	u32 result = (u32)_InterlockedExchange((long volatile *)value, (long)newValue);
+	return result;
+}
+
+// Returns the value before the add
+inline u32 atomicAddU32(u32 volatile *value, u32 addend) {
+	u32 result = (u32)_InterlockedExchangeAdd((long volatile *)value, (long)addend);
+	return result;
+}
+
+inline u64 atomicAddU64(u64 volatile *value, u64 addend) {
+	u64 result = (u64)_InterlockedExchangeAdd64((__int64 volatile *)value, (__int64)addend);
+	return result;
+}
+
+// Returns the value that was there; the exchange happened if that equals expected.
+inline u32 atomicCompareExchangeU32(u32 volatile *value, u32 newValue, u32 expected) {
+	u32 result = (u32)_InterlockedCompareExchange((long volatile *)value, (long)newValue, (long)expected);
+	return result;
+}
+
+#else
+
+inline u32 atomicLoadU32(u32 volatile *value) {
+	u32 result = __atomic_load_n(value, __ATOMIC_ACQUIRE);
+	return result;
+}
+
+inline void atomicStoreU32(u32 volatile *value, u32 newValue) {
+	__atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+}
+
+inline u32 atomicExchangeU32(u32 volatile *value, u32 newValue) {
+	u32 result = __atomic_exchange_n(value, newValue, __ATOMIC_ACQ_REL);
+	return result;
+}
+
+// Returns the value before the add
+inline u32 atomicAddU32(u32 volatile *value, u32 addend) {
+	u32 result = __atomic_fetch_add(value, addend, __ATOMIC_ACQ_REL);
+	return result;
+}
+
+inline u64 atomicAddU64(u64 volatile *value, u64 addend) {
+	u64 result = __atomic_fetch_add(value, addend, __ATOMIC_ACQ_REL);
+	return result;
+}
+
+// Returns the value that was there; the exchange happened if that equals expected.
+inline u32 atomicCompareExchangeU32(u32 volatile *value, u32 newValue, u32 expected) {
+	__atomic_compare_exchange_n(value, &expected, newValue, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+	return expected;
+}
+
+#endif
+
+#endif
@@ -71,12 +71,33 @@ inline v2 operator*(float s, v2 a) {
 	return result;
 }
 
+inline float lerp(float a, float t, float b) {
+	float result = (1.0f - t)*a + t*b;
+
+	return result;
+}
+
+inline v2 lerp(v2 a, float t, v2 b) {
+	v2 result = ((1.0f - t) * a) + (t * b);
+
+	return result;
+}
+
 inline float inner(v2 a, v2 b) {
 	float result = a.x*b.x + a.y*b.y;
 
 	return result;
 }
 
+inline v2 hadamard(v2 a, v2 b) {
+	v2 result;
+
+	result.x = a.x * b.x;
+	result.y = a.y * b.y;
+
+	return result;
+}
+
 inline rectangle2i Rect(int minX, int minY, int maxX, int maxY) {
 	rectangle2i result;
 
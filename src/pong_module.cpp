@@ -0,0 +1,430 @@
+// The game code the host loads as pong_module.dll: the simulation, the
+// rollouts and everything drawn, behind the entry points in pong_module.h.
+
+#include "pong.h"
+#include "pong_game.cpp"
+#include "pong_threads.cpp"
+#include "pong_rollout.cpp"
+#include "pong_particles.cpp"
+#include "pong_scale.cpp"
+#include "pong_sprite.cpp"
+#include "pong_draw.cpp"
+
+inline void quad(v2 vertices[], int n) {
+	assert(n % 4 == 0);
+	
+	glBegin(GL_QUADS);
+
+	for(int i=0; i < n; ++i) {
+		glVertex2f(vertices[i].x, vertices[i].y);
+	}
+
+	glEnd();
+}
+
+inline void line(float x0, float y0, float x1, float y1) {
+	glBegin(GL_LINES);
+
+	glVertex2f(x0, y0);
+	glVertex2f(x1, y1);
+
+	glEnd();
+}
+
+#include "pong_text.cpp"
+
+// Upper edge of the bucket holding the given percentile, in milliseconds.
+float frameTimePercentile(frame_histogram *histogram, u32 percent) {
+	u32 target = (histogram->count * percent + 99) / 100;
+	u32 seen = 0;
+	for(int i=0; i < Frame_Histogram_Buckets; ++i) {
+		seen += histogram->buckets[i];
+		if(seen >= target) {
+			return ((i + 1) * Frame_Histogram_Bucket_Microseconds) / 1000.0f;
+		}
+	}
+	return (Frame_Histogram_Buckets * Frame_Histogram_Bucket_Microseconds) / 1000.0f;
+}
+
+// Text is laid out in the pixels of whatever it ends up drawn on (width x
+// height), so glyphs stay the size they were designed at.
+void pushOverlay(render_context *renderer, render_snapshot *snapshot, float msPerFrame,
+                 s32 width, s32 height) {
+	text_batch *batch = renderer->textBatch;
+	frame_histogram *histogram = renderer->frameHistogram;
+	char text[128];
+
+	sprintf_s(text, "%u", snapshot->players[0].score);
+	pushText(batch, width / 4 - textWidth(text) / 2, 20, text, 0xFFFFFFFF);
+	sprintf_s(text, "%u", snapshot->players[1].score);
+	pushText(batch, (3 * width) / 4 - textWidth(text) / 2, 20, text, 0xFFFFFFFF);
+
+	if(renderer->showPerfHud) {
+		float msDropped = (float)((snapshot->droppedTime * 1000) / renderer->perfCountFrequency);
+		u32 hudColor = 0xFF40FF40;
+
+		sprintf_s(text, "FRAME %.2fMS  TICK %llu", msPerFrame, snapshot->tick);
+		pushText(batch, 8, height - 3 * Glyph_Cell_Height - 8, text, hudColor);
+		sprintf_s(text, "P50 %.1f  P90 %.1f  P99 %.1f MS",
+		          frameTimePercentile(histogram, 50), frameTimePercentile(histogram, 90),
+		          frameTimePercentile(histogram, 99));
+		pushText(batch, 8, height - 2 * Glyph_Cell_Height - 8, text, hudColor);
+		sprintf_s(text, "DROPPED %.0fMS (%u FRAMES)  SWEPT %llu  BALLS %u (%u CONTACTS)",
+		          msDropped, snapshot->droppedFrames, snapshot->sweptUpdates,
+		          snapshot->poolCount, snapshot->poolContacts);
+		pushText(batch, 8, height - Glyph_Cell_Height - 8, text, hudColor);
+
+		float p = snapshot->winProbability;
+		sprintf_s(text, "NEXT POINT L %.0f%% R %.0f%%  (%u/%u ROLLOUTS %.1fMS)",
+		          100.0f*p, 100.0f*(1.0f - p), snapshot->rolloutsDecided,
+		          snapshot->rolloutsLaunched, snapshot->rolloutMs);
+		pushText(batch, 8, height - 4 * Glyph_Cell_Height - 8, text, hudColor);
+	}
+}
+
+// All the stress-mode balls in one glDrawArrays. vertices needs room for
+// four per ball.
+void drawBallPoolGL(render_snapshot *snapshot, v2 *vertices, float offset) {
+	if(snapshot->poolCount == 0) {
+		return;
+	}
+
+	v2 size = V2(snapshot->poolSize, snapshot->poolSize);
+	for(u32 i=0; i < snapshot->poolCount; ++i) {
+		v2 center = lerp(V2(snapshot->poolPrevX[i], snapshot->poolPrevY[i]), offset,
+		                 V2(snapshot->poolX[i], snapshot->poolY[i]));
+		makeRectFromCenterPoint(vertices + 4*i, center, size);
+	}
+
+	glColor3f(0.5f, 0.5f, 1.0f);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(v2), &vertices[0].x);
+	glDrawArrays(GL_QUADS, 0, 4 * snapshot->poolCount);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// Only needed by the OpenGL path, and again whenever the sprites are
+// redrawn. Linear filtering is safe at the edges because the atlas is
+// premultiplied and every sprite has a transparent border.
+void uploadSpriteAtlas(sprite_atlas *atlas) {
+	if(atlas->texture == 0) {
+		GLuint texture;
+		glGenTextures(1, &texture);
+		atlas->texture = texture;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, atlas->texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, Sprite_Atlas_Width, Sprite_Atlas_Height, 0,
+	             GL_BGRA_EXT, GL_UNSIGNED_BYTE, atlas->pixels);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	atlas->uploadedVersion = atlas->version;
+}
+
+// corners as makeRectFromCenterPoint() lays them out
+inline sprite_vertex *pushSpriteQuad(sprite_vertex *vertex, sprite_atlas *atlas, sprite_id id, v2 *corners) {
+	rectangle2i rect = atlas->sprites[id];
+	float u0 = (float)rect.minX / (float)Sprite_Atlas_Width;
+	float v0 = (float)rect.minY / (float)Sprite_Atlas_Height;
+	float u1 = (float)rect.maxX / (float)Sprite_Atlas_Width;
+	float v1 = (float)rect.maxY / (float)Sprite_Atlas_Height;
+
+	sprite_vertex quad[4] = {
+		{corners[0].x, corners[0].y, u0, v0},
+		{corners[1].x, corners[1].y, u1, v0},
+		{corners[2].x, corners[2].y, u1, v1},
+		{corners[3].x, corners[3].y, u0, v1},
+	};
+	for(int i=0; i < 4; ++i) {
+		*vertex++ = quad[i];
+	}
+	return vertex;
+}
+
+// The paddles, the ball and all the stress-mode balls in one glDrawArrays
+// from the sprite atlas, blended with GL_ONE since it's premultiplied.
+void drawSpritesGL(render_snapshot *snapshot, frame_geometry *geometry, sprite_atlas *atlas,
+                   sprite_vertex *vertices, float offset) {
+	sprite_vertex *vertex = vertices;
+	for(u32 i=0; i < Entity_Quad_Count; ++i) {
+		vertex = pushSpriteQuad(vertex, atlas, (i == QuadBall) ? SpriteBall : SpritePaddle,
+		                        geometry->vertices + 4*i);
+	}
+
+	v2 size = V2(snapshot->poolSize, snapshot->poolSize);
+	for(u32 i=0; i < snapshot->poolCount; ++i) {
+		v2 center = lerp(V2(snapshot->poolPrevX[i], snapshot->poolPrevY[i]), offset,
+		                 V2(snapshot->poolX[i], snapshot->poolY[i]));
+		v2 corners[4];
+		makeRectFromCenterPoint(corners, center, size);
+		vertex = pushSpriteQuad(vertex, atlas, SpritePoolBall, corners);
+	}
+
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, atlas->texture);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(sprite_vertex), &vertices[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(sprite_vertex), &vertices[0].u);
+	glDrawArrays(GL_QUADS, 0, (GLsizei)(vertex - vertices));
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glDisable(GL_TEXTURE_2D);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+// Spawns particles for every effect event in snapshot past effectsSeen.
+// Events that already fell out of the ring are skipped.
+void spawnNewEffects(particle_system *particles, render_snapshot *snapshot, u32 *effectsSeen) {
+	u32 seen = *effectsSeen;
+	if(snapshot->effectCount - seen > Max_Effect_Events) {
+		seen = snapshot->effectCount - Max_Effect_Events;
+	}
+
+	for(; seen != snapshot->effectCount; ++seen) {
+		spawnEffect(particles, snapshot->effects + (seen & (Max_Effect_Events - 1)));
+	}
+	*effectsSeen = seen;
+}
+
+// Every live particle in one glDrawArrays, the same way flushTextGL() draws
+// glyphs.
+void drawParticlesGL(particle_system *particles) {
+	u32 vertexCount = buildParticleVertices(particles);
+	if(vertexCount == 0) {
+		return;
+	}
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(particle_vertex), &particles->vertices[0].x);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(particle_vertex), &particles->vertices[0].r);
+	glDrawArrays(GL_QUADS, 0, vertexCount);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void renderSoftware(render_snapshot *snapshot, text_batch *textBatch, particle_system *particles,
+                    sprite_atlas *sprites, offscreen_buffer *buffer, float offset) {
+	pixel_image image = pixelImage(buffer);
+	drawSceneSoftware(snapshot, particles, sprites, &image, offset);
+	flushTextSoftware(textBatch, buffer);
+}
+
+// The arena goes in the largest rectangle of the window with its aspect
+// (viewport); the bars around it are left clear. sprites may be 0 for
+// solid quads.
+void render(render_snapshot *snapshot, text_batch *textBatch, particle_system *particles,
+            v2 *poolVertices, sprite_atlas *sprites, sprite_vertex *spriteVertices, float offset,
+            window_dimension window, rectangle2i viewport) {
+	glViewport(0, 0, window.width, window.height);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	s32 viewportWidth = viewport.maxX - viewport.minX;
+	s32 viewportHeight = viewport.maxY - viewport.minY;
+	glViewport(viewport.minX, window.height - viewport.maxY, viewportWidth, viewportHeight);
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0.0f, snapshot->arenaWidth, snapshot->arenaHeight, 0.0f, 1.0f, -1.0f);
+	glMatrixMode(GL_MODELVIEW);
+
+	frame_geometry geometry;
+	buildFrameGeometry(&geometry, snapshot, offset);
+
+	glColor3f(1.0f, 1.0f, 1.0f);
+
+	float midX = snapshot->arenaWidth / 2.0f;
+	line(midX, 0.0f, midX, (float)snapshot->arenaHeight);
+
+	// Sprites drawn at the size they cover in the viewport, so GL's filtering
+	// only ever has sub-pixel work to do
+	bool themed = false;
+	if(sprites) {
+		v2 scale = V2((float)viewportWidth / snapshot->arenaWidth, (float)viewportHeight / snapshot->arenaHeight);
+		updateSpriteAtlas(sprites, snapshot->players[0].size, snapshot->ball.size,
+		                  snapshot->poolCount ? snapshot->poolSize : 0.0f, scale);
+		if(sprites->uploadedVersion != sprites->version) {
+			uploadSpriteAtlas(sprites);
+		}
+		themed = spriteReady(sprites, SpritePaddle) && spriteReady(sprites, SpriteBall) &&
+		         (snapshot->poolCount == 0 || spriteReady(sprites, SpritePoolBall));
+	}
+	if(themed) {
+		drawSpritesGL(snapshot, &geometry, sprites, spriteVertices, offset);
+	}
+	else {
+		quad(geometry.vertices, arrayCount(geometry.vertices));
+		drawBallPoolGL(snapshot, poolVertices, offset);
+	}
+	drawParticlesGL(particles);
+
+	// Text in viewport pixels
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0.0f, viewportWidth, viewportHeight, 0.0f, 1.0f, -1.0f);
+	glMatrixMode(GL_MODELVIEW);
+	flushTextGL(textBatch);
+
+	glFlush();
+}
+
+// Logs whatever update() just reported for the render thread's particles.
+// Wall bounces and points happen where the ball was before the step (a point
+// has already re-served it); paddle hits where it ended up.
+void recordEffects(simulation_context *sim, v2 ballBefore) {
+	game_state *gameState = sim->gameState;
+	if(gameState->events == 0) {
+		return;
+	}
+
+	effect_event *effect = sim->effects + (sim->effectCount & (Max_Effect_Events - 1));
+	effect->events = gameState->events;
+	effect->pos = (gameState->events & EventPaddleHit) ? gameState->ball.pos : ballBefore;
+	effect->velocity = gameState->ball.velocity;
+	++sim->effectCount;
+}
+
+// Collects the previous batch of rollouts if it has finished and forks the
+// current state into a new one. Never waits on the workers.
+void updateRollouts(simulation_context *sim) {
+	rollout_engine *engine = sim->rollouts;
+	if(!rolloutsComplete(engine) || sim->clock.tick < sim->nextRolloutTick) {
+		return;
+	}
+
+	if(engine->launched) {
+		sim->rolloutResult = getRolloutResult(engine);
+		sim->rolloutCount = nextRolloutCount(&sim->rolloutResult, Rollout_Budget_Microseconds);
+	}
+
+	launchRollouts(engine, sim->gameState, sim->rolloutCount, 1.0f / (float)sim->clock.rate,
+	               Rollout_Max_Ticks, Rollout_Budget_Microseconds, (u32)sim->clock.tick);
+	sim->nextRolloutTick = sim->clock.tick + Rollout_Interval_Ticks;
+}
+
+// The game's half of a snapshot; the host adds the clock fields.
+void writeSnapshot(simulation_context *sim, render_snapshot *snapshot) {
+	game_state *gameState = sim->gameState;
+
+	snapshot->arenaWidth = gameState->arenaWidth;
+	snapshot->arenaHeight = gameState->arenaHeight;
+	snapshot->players[0] = gameState->players[0];
+	snapshot->players[1] = gameState->players[1];
+	snapshot->ball = gameState->ball;
+
+	ball_pool *balls = sim->balls;
+	if(balls) {
+		snapshot->poolCount = balls->count;
+		snapshot->poolSize = balls->size;
+		snapshot->poolContacts = balls->contacts;
+		memcpy(snapshot->poolX, balls->x, balls->count*sizeof(float));
+		memcpy(snapshot->poolY, balls->y, balls->count*sizeof(float));
+		memcpy(snapshot->poolPrevX, balls->prevX, balls->count*sizeof(float));
+		memcpy(snapshot->poolPrevY, balls->prevY, balls->count*sizeof(float));
+	}
+
+	memcpy(snapshot->effects, sim->effects, sizeof(sim->effects));
+	snapshot->effectCount = sim->effectCount;
+
+	rollout_result *rollouts = &sim->rolloutResult;
+	snapshot->winProbability = rolloutWinProbability(rollouts);
+	snapshot->rolloutsDecided = rollouts->wins[0] + rollouts->wins[1];
+	snapshot->rolloutsLaunched = rollouts->launched;
+	snapshot->rolloutMs = rollouts->elapsed / 1000.0f;
+
+}
+
+extern "C" __declspec(dllexport) GAME_INITIALIZE(gameInitialize) {
+	persistent_state *persistent = sim->persistent;
+	initMatch(sim->gameState, persistent->bots, &persistent->balls, permanentArena, commandLine, resumed, false);
+
+	// Stress mode: a copy of the pool's positions in every snapshot slot and
+	// the vertices to draw them from.
+	u32 poolCount = persistent->balls.capacity;
+	if(poolCount) {
+		sim->balls = &persistent->balls;
+
+		for(u32 i=0; i < arrayCount(sim->snapshots.slots); ++i) {
+			render_snapshot *slot = sim->snapshots.slots + i;
+			slot->poolX = pushArray(transientArena, poolCount, float);
+			slot->poolY = pushArray(transientArena, poolCount, float);
+			slot->poolPrevX = pushArray(transientArena, poolCount, float);
+			slot->poolPrevY = pushArray(transientArena, poolCount, float);
+		}
+		renderer->poolVertices = pushArray(transientArena, 4*poolCount, v2);
+	}
+
+	sim->rollouts = pushStruct(transientArena, rollout_engine);
+	initRolloutEngine(sim->rollouts, transientArena, sim->workQueue, sim->rolloutClock);
+	sim->rolloutCount = Rollouts_Per_Job;
+
+	glyph_atlas *glyphAtlas = pushStruct(transientArena, glyph_atlas);
+	initGlyphAtlas(glyphAtlas, transientArena);
+#if !SOFTWARE_RENDERER
+	uploadGlyphAtlas(glyphAtlas);
+#endif
+
+#if THEMED_SPRITES
+	renderer->sprites = pushStruct(transientArena, sprite_atlas);
+	initSpriteAtlas(renderer->sprites, transientArena);
+	renderer->spriteVertices = pushArray(transientArena, 4*(Entity_Quad_Count + poolCount), sprite_vertex);
+#else
+	renderer->sprites = 0;
+	renderer->spriteVertices = 0;
+#endif
+
+	renderer->textBatch = pushStruct(transientArena, text_batch);
+	renderer->textBatch->atlas = glyphAtlas;
+	renderer->textBatch->count = 0;
+
+	// Effects belong to the render thread alone; the simulation only hands
+	// over events.
+	renderer->particles = pushStruct(transientArena, particle_system);
+	initParticleSystem(renderer->particles, transientArena, Max_Particles, 0xFACE);
+}
+
+extern "C" __declspec(dllexport) GAME_SIMULATE(gameSimulate) {
+	persistent_state *persistent = sim->persistent;
+	v2 ballBefore = sim->gameState->ball.pos;
+	stepMatch(&persistent->gameState, persistent->bots, &persistent->balls, dt);
+	recordEffects(sim, ballBefore);
+}
+
+extern "C" __declspec(dllexport) GAME_PUBLISH(gamePublish) {
+	updateRollouts(sim);
+	writeSnapshot(sim, snapshot);
+}
+
+extern "C" __declspec(dllexport) GAME_RENDER(gameRender) {
+#if SOFTWARE_RENDERER
+	pushOverlay(renderer, snapshot, msPerFrame, renderer->buffer->width, renderer->buffer->height);
+#else
+	window_dimension window = renderer->window;
+	rectangle2i viewport = letterboxRect((s32)snapshot->arenaWidth, (s32)snapshot->arenaHeight,
+	                                     window.width, window.height, false);
+	pushOverlay(renderer, snapshot, msPerFrame, viewport.maxX - viewport.minX, viewport.maxY - viewport.minY);
+#endif
+
+	// A long stall shouldn't fling every particle across the screen.
+	spawnNewEffects(renderer->particles, snapshot, &renderer->effectsSeen);
+	updateParticles(renderer->particles, (msPerFrame < 100.0f) ? (msPerFrame / 1000.0f) : 0.1f);
+
+#if SOFTWARE_RENDERER
+	renderSoftware(snapshot, renderer->textBatch, renderer->particles, renderer->sprites, renderer->buffer,
+	               offset);
+#else
+	render(snapshot, renderer->textBatch, renderer->particles, renderer->poolVertices, renderer->sprites,
+	       renderer->spriteVertices, offset, window, viewport);
+#endif
+}
@@ -0,0 +1,37 @@
+#ifndef PONG_MODULE_H
+#define PONG_MODULE_H
+
+// The game code lives in pong_module.dll, which the host loads at startup
+// and reloads whenever a rebuild replaces it. Everything the game keeps
+// between calls is in game_memory, so nothing is lost across a reload.
+//
+// Function pointers the game hands out (work queue callbacks) must not
+// outlive a call into it: the host drains the work queue before unloading.
+
+struct simulation_context;
+struct render_snapshot;
+struct render_context;
+struct memory_arena;
+
+// Builds everything that isn't in a resumed permanent state: sets up a fresh
+// game (unless resumed) and fills in the transient parts of sim and renderer.
+#define GAME_INITIALIZE(name) void name(simulation_context *sim, render_context *renderer, \
+                                        memory_arena *permanentArena, memory_arena *transientArena, \
+                                        const char *commandLine, bool resumed)
+typedef GAME_INITIALIZE(game_initialize);
+
+// One fixed step: bots, update() and anything else that moves.
+#define GAME_SIMULATE(name) void name(simulation_context *sim, float dt)
+typedef GAME_SIMULATE(game_simulate);
+
+// After the steps of a frame: the game's half of the snapshot.
+#define GAME_PUBLISH(name) void name(simulation_context *sim, render_snapshot *snapshot)
+typedef GAME_PUBLISH(game_publish);
+
+// One frame from the latest snapshot, offset being how far the renderer is
+// between the snapshot's previous and current state.
+#define GAME_RENDER(name) void name(render_context *renderer, render_snapshot *snapshot, float offset, \
+                                    float msPerFrame)
+typedef GAME_RENDER(game_render);
+
+#endif
@@ -0,0 +1,131 @@
+#include <emmintrin.h>
+
+// Low resolution grayscale frames for pixel-based agents. Everything in the
+// arena is an axis-aligned rectangle, so a pixel's area coverage is just
+// (horizontal overlap) * (vertical overlap). A frame is cleared with wide
+// stores, then each rectangle adds its column coverage scaled by the row's
+// vertical coverage into the rows it touches.
+
+#define Max_Observation_Width 512
+#define Observation_Objects 4
+
+struct observation_rect {
+	rectangle2i pixels;
+	float minX, minY;
+	float maxX, maxY;
+};
+
+// Column coverage in 0..255, only valid over each rectangle's pixel span.
+struct observation_columns {
+	u16 coverage[Observation_Objects][Max_Observation_Width + 8];
+};
+
+inline float coverage1D(float min, float max, int pixel) {
+	float low = (min > (float)pixel) ? min : (float)pixel;
+	float high = (max < (float)(pixel + 1)) ? max : (float)(pixel + 1);
+	float result = high - low;
+	return (result > 0.0f) ? result : 0.0f;
+}
+
+static observation_rect makeObservationRect(v2 center, v2 size, float scaleX, float scaleY, int width, int height) {
+	observation_rect result;
+
+	result.minX = (center.x - 0.5f*size.x) * scaleX;
+	result.maxX = (center.x + 0.5f*size.x) * scaleX;
+	result.minY = (center.y - 0.5f*size.y) * scaleY;
+	result.maxY = (center.y + 0.5f*size.y) * scaleY;
+
+	// Same clip drawRectangle uses, just widened to every pixel the rectangle
+	// touches at all.
+	rectangle2i touched = Rect((int)floorf(result.minX), (int)floorf(result.minY),
+	                           (int)ceilf(result.maxX), (int)ceilf(result.maxY));
+	result.pixels = clipRect(touched, Rect(0, 0, width, height));
+
+	return result;
+}
+
+void renderObservation(game_state *gameState, u8 *frame, int width, int height, observation_columns *columns) {
+	assert(width <= Max_Observation_Width);
+
+	float scaleX = (float)width / gameState->arenaWidth;
+	float scaleY = (float)height / gameState->arenaHeight;
+
+	observation_rect rects[Observation_Objects];
+	rects[0] = makeObservationRect(V2(0.5f*gameState->arenaWidth, 0.5f*gameState->arenaHeight),
+	                               V2(1.0f, (float)gameState->arenaHeight), scaleX, scaleY, width, height);
+	rects[1] = makeObservationRect(gameState->players[0].pos, gameState->players[0].size, scaleX, scaleY, width, height);
+	rects[2] = makeObservationRect(gameState->players[1].pos, gameState->players[1].size, scaleX, scaleY, width, height);
+	rects[3] = makeObservationRect(gameState->ball.pos, gameState->ball.size, scaleX, scaleY, width, height);
+
+	for(int i=0; i < Observation_Objects; ++i) {
+		observation_rect *rect = rects + i;
+		u16 *coverage = columns->coverage[i];
+		for(int x=rect->pixels.minX; x < rect->pixels.maxX; ++x) {
+			coverage[x] = (u16)(255.0f*coverage1D(rect->minX, rect->maxX, x) + 0.5f);
+		}
+	}
+
+	size_t frameSize = (size_t)width*height;
+	size_t x16 = frameSize & ~(size_t)15;
+	__m128i zero = _mm_setzero_si128();
+	for(size_t i=0; i < x16; i += 16) {
+		_mm_storeu_si128((__m128i *)(frame + i), zero);
+	}
+	memset(frame + x16, 0, frameSize - x16);
+
+	for(int i=0; i < Observation_Objects; ++i) {
+		observation_rect *rect = rects + i;
+		u16 *coverage = columns->coverage[i];
+		int minX = rect->pixels.minX;
+		int maxX = rect->pixels.maxX;
+
+		for(int y=rect->pixels.minY; y < rect->pixels.maxY; ++y) {
+			u16 rowCoverage = (u16)(256.0f*coverage1D(rect->minY, rect->maxY, y) + 0.5f);
+			__m128i rowScale = _mm_set1_epi16((short)rowCoverage);
+			u8 *row = frame + y*width;
+
+			// 8 pixels at a time: widen to 16 bits, add the scaled coverage
+			// with saturation, narrow back.
+			int x = minX;
+			for(; x + 8 <= maxX; x += 8) {
+				__m128i dest = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *)(row + x)), zero);
+				__m128i source = _mm_loadu_si128((__m128i *)(coverage + x));
+				source = _mm_srli_epi16(_mm_mullo_epi16(source, rowScale), 8);
+				_mm_storel_epi64((__m128i *)(row + x), _mm_packus_epi16(_mm_adds_epu16(dest, source), zero));
+			}
+			for(; x < maxX; ++x) {
+				u32 value = row[x] + ((coverage[x]*rowCoverage) >> 8);
+				row[x] = (u8)((value > 255) ? 255 : value);
+			}
+		}
+	}
+}
+
+// Writes one observation per game into `pixels`, laid out
+// [game][stack][height][width] with the newest frame last. Older frames are
+// shifted down in place; games flagged in `restarted` (or all of them when
+// it is null) get every stacked frame filled with the current one.
+void renderObservationBatch(game_state *games, u32 count, u8 *pixels, int width, int height, u32 stack,
+                            const u8 *restarted) {
+	observation_columns columns;
+	size_t frameSize = (size_t)width*height;
+	size_t observationSize = frameSize*stack;
+
+	for(u32 i=0; i < count; ++i) {
+		u8 *observation = pixels + i*observationSize;
+		u8 *newest = observation + (stack - 1)*frameSize;
+		bool fill = !restarted || restarted[i];
+
+		if(stack > 1 && !fill) {
+			memmove(observation, observation + frameSize, (stack - 1)*frameSize);
+		}
+
+		renderObservation(games + i, newest, width, height, &columns);
+
+		if(stack > 1 && fill) {
+			for(u32 frame=0; frame < stack - 1; ++frame) {
+				memcpy(observation + frame*frameSize, newest, frameSize);
+			}
+		}
+	}
+}
@@ -0,0 +1,140 @@
+#include <emmintrin.h>
+
+#define Particle_Gravity 600.0f
+#define Particle_Drag 1.5f
+
+void initParticleSystem(particle_system *system, memory_arena *arena, u32 capacity, u32 seed) {
+	*system = {};
+	capacity = (capacity < Max_Particles) ? capacity : Max_Particles;
+	capacity = (capacity + 3) & ~3;
+
+	system->capacity = capacity;
+	system->random = seed ? seed : 1;
+	system->x = pushArray(arena, capacity, float);
+	system->y = pushArray(arena, capacity, float);
+	system->velocityX = pushArray(arena, capacity, float);
+	system->velocityY = pushArray(arena, capacity, float);
+	system->life = pushArray(arena, capacity, float);
+	system->fade = pushArray(arena, capacity, float);
+	system->color = pushArray(arena, capacity, u32);
+	system->vertices = pushArray(arena, 4*capacity, particle_vertex);
+}
+
+// Sprays up to count particles from pos in a cone of `spread` radians around
+// direction (any length; zero sprays in every direction). Whatever doesn't
+// fit in the pool is dropped.
+void emitParticles(particle_system *system, v2 pos, v2 direction, float spread, u32 count,
+                   float speed, float lifetime, u32 color) {
+	u32 room = system->capacity - system->count;
+	count = (count < room) ? count : room;
+
+	float heading = (direction.x != 0.0f || direction.y != 0.0f) ? atan2f(direction.y, direction.x) : 0.0f;
+	if(direction.x == 0.0f && direction.y == 0.0f) {
+		spread = 6.2831853f;
+	}
+
+	u32 *random = &system->random;
+	for(u32 n=0; n < count; ++n) {
+		u32 i = system->count++;
+		float angle = heading + spread*(randomUnilateral(random) - 0.5f);
+		float particleSpeed = speed*(0.25f + 0.75f*randomUnilateral(random));
+		float particleLife = lifetime*(0.5f + 0.5f*randomUnilateral(random));
+
+		system->x[i] = pos.x;
+		system->y[i] = pos.y;
+		system->velocityX[i] = particleSpeed*cosf(angle);
+		system->velocityY[i] = particleSpeed*sinf(angle);
+		system->life[i] = particleLife;
+		system->fade[i] = 1.0f / particleLife;
+		system->color[i] = color;
+	}
+}
+
+void spawnEffect(particle_system *system, effect_event *effect) {
+	if(effect->events & EventPaddleHit) {
+		emitParticles(system, effect->pos, effect->velocity, 1.2f, 192, 500.0f, 0.6f, 0xFFE060);
+	}
+	if(effect->events & EventWallBounce) {
+		emitParticles(system, effect->pos, effect->velocity, 2.0f, 48, 250.0f, 0.4f, 0xA0C0FF);
+	}
+	if(effect->events & EventPointPlayer0) {
+		emitParticles(system, effect->pos, V2(0, 0), 0.0f, 4096, 900.0f, 1.5f, 0x60FF60);
+	}
+	if(effect->events & EventPointPlayer1) {
+		emitParticles(system, effect->pos, V2(0, 0), 0.0f, 4096, 900.0f, 1.5f, 0xFF6060);
+	}
+}
+
+// Four particles at a time. The arrays are padded to a multiple of 4, and
+// lanes past count just compute garbage nobody reads.
+void updateParticles(particle_system *system, float dt) {
+	__m128 dtWide = _mm_set1_ps(dt);
+	__m128 gravity = _mm_set1_ps(Particle_Gravity*dt);
+	__m128 drag = _mm_set1_ps((Particle_Drag*dt < 1.0f) ? (1.0f - Particle_Drag*dt) : 0.0f);
+
+	for(u32 i=0; i < system->count; i += 4) {
+		__m128 vx = _mm_mul_ps(_mm_load_ps(system->velocityX + i), drag);
+		__m128 vy = _mm_add_ps(_mm_mul_ps(_mm_load_ps(system->velocityY + i), drag), gravity);
+		_mm_store_ps(system->velocityX + i, vx);
+		_mm_store_ps(system->velocityY + i, vy);
+		_mm_store_ps(system->x + i, _mm_add_ps(_mm_load_ps(system->x + i), _mm_mul_ps(vx, dtWide)));
+		_mm_store_ps(system->y + i, _mm_add_ps(_mm_load_ps(system->y + i), _mm_mul_ps(vy, dtWide)));
+		_mm_store_ps(system->life + i, _mm_sub_ps(_mm_load_ps(system->life + i), dtWide));
+	}
+
+	// Swap-remove the dead. Whole groups of four still alive are skipped
+	// with one compare; only groups with a death drop to scalar.
+	__m128 zero = _mm_setzero_ps();
+	u32 i = 0;
+	while(i < system->count) {
+		if(_mm_movemask_ps(_mm_cmple_ps(_mm_load_ps(system->life + i), zero)) == 0) {
+			i += 4;
+			continue;
+		}
+
+		u32 end = i + 4;
+		while(i < end && i < system->count) {
+			if(system->life[i] <= 0.0f) {
+				u32 last = --system->count;
+				system->x[i] = system->x[last];
+				system->y[i] = system->y[last];
+				system->velocityX[i] = system->velocityX[last];
+				system->velocityY[i] = system->velocityY[last];
+				system->life[i] = system->life[last];
+				system->fade[i] = system->fade[last];
+				system->color[i] = system->color[last];
+			}
+			else {
+				++i;
+			}
+		}
+	}
+}
+
+// Fills system->vertices with one quad per live particle, fading out over
+// its lifetime. Returns the number of vertices.
+u32 buildParticleVertices(particle_system *system) {
+	float half = 0.5f*Particle_Size;
+	particle_vertex *vertex = system->vertices;
+	for(u32 i=0; i < system->count; ++i) {
+		float x0 = system->x[i] - half;
+		float y0 = system->y[i] - half;
+		float x1 = x0 + Particle_Size;
+		float y1 = y0 + Particle_Size;
+
+		float alpha = 255.0f*system->life[i]*system->fade[i];
+		u32 color = system->color[i];
+		u8 r = (u8)(color >> 16);
+		u8 g = (u8)(color >> 8);
+		u8 b = (u8)color;
+		u8 a = (u8)((alpha < 255.0f) ? alpha : 255.0f);
+
+		vertex[0] = {x0, y0, r, g, b, a};
+		vertex[1] = {x1, y0, r, g, b, a};
+		vertex[2] = {x1, y1, r, g, b, a};
+		vertex[3] = {x0, y1, r, g, b, a};
+		vertex += 4;
+	}
+
+	return 4*system->count;
+}
@@ -0,0 +1,48 @@
+#ifndef PONG_PARTICLES_H
+#define PONG_PARTICLES_H
+
+// Hit and score effects. Particles are purely visual: they live on the
+// render thread, are spawned from the events update() reports, and never
+// feed back into the simulation.
+
+// A multiple of 4 so the SIMD update never needs a scalar tail
+#define Max_Particles (512*1024)
+#define Particle_Size 3.0f
+
+struct particle_vertex {
+	float x, y;
+	u8 r, g, b, a;
+};
+
+// Structure-of-arrays, fixed capacity. Live particles are always packed
+// into [0, count); dead ones are swap-removed with the last live one.
+struct particle_system {
+	u32 count;
+	u32 capacity;
+	u32 random;
+
+	float *x;
+	float *y;
+	float *velocityX;
+	float *velocityY;
+
+	// Seconds left, and 1 / the lifetime it started with for fading out
+	float *life;
+	float *fade;
+
+	// 0x00RRGGBB; alpha comes from life * fade
+	u32 *color;
+
+	// Four per live particle, rebuilt every frame
+	particle_vertex *vertices;
+};
+
+// One event update() reported, in the form the render thread spawns
+// particles from.
+struct effect_event {
+	u32 events;
+	v2 pos;
+	v2 velocity;
+};
+
+#endif
@@ -0,0 +1,71 @@
+// Milliseconds per 60Hz frame of the particle system against live particle
+// count: the SIMD update (including removing the dead), topping the pool back
+// up, and building the vertex stream. Lifetimes are short enough that a few
+// percent of the particles die and respawn every frame.
+//
+//   pong_particles_bench [max particles] [frames per count]
+
+#include "pong_game.h"
+#include "pong_particles.h"
+#include "pong_bench.h"
+#include "pong_game.cpp"
+#include "pong_particles.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+	u32 maxParticles = (argc > 1) ? (u32)atoi(argv[1]) : 500000;
+	u32 frames = (argc > 2) ? (u32)atoi(argv[2]) : 240;
+	if(maxParticles > Max_Particles) {
+		maxParticles = Max_Particles;
+	}
+
+	size_t size = megabytes(64);
+	void *memory = calloc(1, size);
+	memory_arena arena;
+
+	float dt = 1.0f / 60.0f;
+	v2 center = V2(640.0f, 360.0f);
+
+	u32 counts[] = {1000, 10000, 100000, 250000, 500000};
+	printf("%8s %10s %10s %10s %10s %10s\n", "LIVE", "UPDATE MS", "EMIT MS", "VERTS MS", "FRAME MS", "DIED/FRM");
+	for(u32 c=0; c < arrayCount(counts) && counts[c] <= maxParticles; ++c) {
+		u32 count = counts[c];
+
+		initArena(&arena, memory, size);
+		particle_system *particles = pushStruct(&arena, particle_system);
+		initParticleSystem(particles, &arena, count, 1234);
+		emitParticles(particles, center, V2(0, 0), 0.0f, count, 900.0f, 2.0f, 0xFFFFFF);
+
+		double updateSeconds = 0.0;
+		double emitSeconds = 0.0;
+		double vertexSeconds = 0.0;
+		u64 died = 0;
+		for(u32 frame=0; frame < frames; ++frame) {
+			double start = benchSeconds();
+			updateParticles(particles, dt);
+			double updated = benchSeconds();
+
+			died += particles->capacity - particles->count;
+			emitParticles(particles, center, V2(0, 0), 0.0f, particles->capacity - particles->count,
+			              900.0f, 2.0f, 0xFFFFFF);
+			double emitted = benchSeconds();
+
+			u32 vertexCount = buildParticleVertices(particles);
+			double built = benchSeconds();
+			assert(vertexCount == 4*particles->count);
+
+			updateSeconds += updated - start;
+			emitSeconds += emitted - updated;
+			vertexSeconds += built - emitted;
+		}
+
+		double scale = 1000.0 / frames;
+		printf("%8u %10.3f %10.3f %10.3f %10.3f %10.0f\n", particles->count, updateSeconds*scale,
+		       emitSeconds*scale, vertexSeconds*scale, (updateSeconds + emitSeconds + vertexSeconds)*scale,
+		       (double)died / frames);
+	}
+
+	return 0;
+}
@@ -0,0 +1,73 @@
+#ifndef PONG_PLATFORM_H
+#define PONG_PLATFORM_H
+
+// What the hosts need from the operating system. pong_platform_win32.cpp
+// implements it for the windowed Win32 host, pong_platform_linux.cpp for
+// the headless Linux one; host code above this line never calls the OS
+// directly.
+
+// Clock: a monotonic counter and its ticks per second
+u64 platformGetCounter(void);
+u64 platformCounterFrequency(void);
+void platformSleep(u32 milliseconds);
+
+// Memory: zeroed, page aligned, reserved and committed up front
+void *platformAllocateMemory(size_t size);
+void platformFreeMemory(void *memory, size_t size);
+
+// File I/O. Whole-file reads come back in memory from
+// platformAllocateMemory; contents is 0 if the read failed.
+struct platform_file {
+	void *contents;
+	u32 size;
+};
+
+platform_file platformReadEntireFile(const char *path);
+void platformFreeFileMemory(platform_file *file);
+bool platformWriteEntireFile(const char *path, void *memory, u32 size);
+
+// A file written front to back in pieces, for output too big to hold in
+// memory at once. Creating one replaces whatever was at path.
+struct platform_output_file {
+	u64 handle;
+	bool valid;
+};
+
+platform_output_file platformCreateOutputFile(const char *path);
+bool platformWriteOutputFile(platform_output_file *file, void *memory, u32 size);
+void platformCloseOutputFile(platform_output_file *file);
+
+enum platform_map_result {
+	PlatformMapFailed,
+	PlatformMapCreated,
+	PlatformMapOpened,
+	PlatformMapWrongSize,
+};
+
+// A file mapped read-write at a fixed address, so pointers stored inside it
+// stay valid from one run to the next.
+struct platform_mapped_file {
+	void *memory;
+	u64 size;
+
+	// Whatever the platform needs to unmap it again
+	u64 handles[2];
+};
+
+// Opens path (creating it if it doesn't exist) and maps size bytes of it at
+// baseAddress. A file that exists with a different size is left untouched.
+platform_map_result platformMapFile(platform_mapped_file *file, const char *path, u64 size, u64 baseAddress);
+void platformUnmapFile(platform_mapped_file *file);
+
+// Diagnostics: one line of text wherever this platform's debug output goes
+void platformLog(const char *text);
+
+// Input and presentation belong to each host: the Win32 one pumps window
+// messages into the input queue and swaps a rendered frame; the headless one
+// only watches for a request to stop and has nothing to show. Input returns
+// false once the host should quit.
+struct input_queue;
+bool platformProcessInput(input_queue *queue);
+void platformPresent(void);
+
+#endif
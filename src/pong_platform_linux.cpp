@@ -0,0 +1,178 @@
+// pong_platform.h for Linux. Input and presentation are in the host that
+// uses it (pong_headless.cpp).
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+u64 platformGetCounter(void) {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (u64)now.tv_sec*1000000000ull + (u64)now.tv_nsec;
+}
+
+u64 platformCounterFrequency(void) {
+	return 1000000000ull;
+}
+
+void platformSleep(u32 milliseconds) {
+	timespec duration;
+	duration.tv_sec = milliseconds / 1000;
+	duration.tv_nsec = (long)(milliseconds % 1000) * 1000000;
+	nanosleep(&duration, 0);
+}
+
+void *platformAllocateMemory(size_t size) {
+	void *result = mmap(0, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	return (result != MAP_FAILED) ? result : 0;
+}
+
+void platformFreeMemory(void *memory, size_t size) {
+	if(memory) {
+		munmap(memory, size);
+	}
+}
+
+platform_file platformReadEntireFile(const char *path) {
+	platform_file result = {};
+
+	int file = open(path, O_RDONLY);
+	if(file < 0) {
+		return result;
+	}
+
+	struct stat info;
+	if(fstat(file, &info) == 0 && info.st_size > 0 && (u64)info.st_size <= 0xFFFFFFFF) {
+		u32 size = (u32)info.st_size;
+		result.contents = platformAllocateMemory(size);
+		u32 bytesRead = 0;
+		while(result.contents && bytesRead < size) {
+			ssize_t bytes = read(file, (u8 *)result.contents + bytesRead, size - bytesRead);
+			if(bytes <= 0) {
+				break;
+			}
+			bytesRead += (u32)bytes;
+		}
+		if(bytesRead == size) {
+			result.size = size;
+		}
+		else {
+			platformFreeMemory(result.contents, size);
+			result.contents = 0;
+		}
+	}
+
+	close(file);
+	return result;
+}
+
+void platformFreeFileMemory(platform_file *file) {
+	platformFreeMemory(file->contents, file->size);
+	file->contents = 0;
+	file->size = 0;
+}
+
+bool platformWriteEntireFile(const char *path, void *memory, u32 size) {
+	int file = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	if(file < 0) {
+		return false;
+	}
+
+	u32 bytesWritten = 0;
+	while(bytesWritten < size) {
+		ssize_t written = write(file, (u8 *)memory + bytesWritten, size - bytesWritten);
+		if(written <= 0) {
+			break;
+		}
+		bytesWritten += (u32)written;
+	}
+	close(file);
+	return bytesWritten == size;
+}
+
+platform_output_file platformCreateOutputFile(const char *path) {
+	platform_output_file result = {};
+	int file = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	if(file >= 0) {
+		result.handle = (u64)file;
+		result.valid = true;
+	}
+	return result;
+}
+
+bool platformWriteOutputFile(platform_output_file *file, void *memory, u32 size) {
+	u32 bytesWritten = 0;
+	while(bytesWritten < size) {
+		ssize_t written = write((int)file->handle, (u8 *)memory + bytesWritten, size - bytesWritten);
+		if(written <= 0) {
+			break;
+		}
+		bytesWritten += (u32)written;
+	}
+	return bytesWritten == size;
+}
+
+void platformCloseOutputFile(platform_output_file *file) {
+	if(file->valid) {
+		close((int)file->handle);
+	}
+	*file = {};
+}
+
+platform_map_result platformMapFile(platform_mapped_file *mapped, const char *path, u64 size, u64 baseAddress) {
+	*mapped = {};
+
+	int file = open(path, O_RDWR|O_CREAT, 0644);
+	if(file < 0) {
+		return PlatformMapFailed;
+	}
+
+	struct stat info;
+	if(fstat(file, &info) != 0) {
+		close(file);
+		return PlatformMapFailed;
+	}
+	if(info.st_size != 0 && (u64)info.st_size != size) {
+		close(file);
+		return PlatformMapWrongSize;
+	}
+	if(info.st_size == 0 && ftruncate(file, (off_t)size) != 0) {
+		close(file);
+		return PlatformMapFailed;
+	}
+
+	// Kernels without MAP_FIXED_NOREPLACE treat it as a hint, so the address
+	// is checked either way rather than clobbering whatever is already there.
+	void *memory = mmap((void *)baseAddress, (size_t)size, PROT_READ|PROT_WRITE,
+	                    MAP_SHARED|MAP_FIXED_NOREPLACE, file, 0);
+	if(memory == MAP_FAILED) {
+		close(file);
+		return PlatformMapFailed;
+	}
+	if((u64)memory != baseAddress) {
+		munmap(memory, (size_t)size);
+		close(file);
+		return PlatformMapFailed;
+	}
+
+	mapped->memory = memory;
+	mapped->size = size;
+	mapped->handles[0] = (u64)file;
+	return (info.st_size != 0) ? PlatformMapOpened : PlatformMapCreated;
+}
+
+void platformUnmapFile(platform_mapped_file *mapped) {
+	munmap(mapped->memory, (size_t)mapped->size);
+	close((int)mapped->handles[0]);
+	*mapped = {};
+}
+
+void platformLog(const char *text) {
+	fputs(text, stderr);
+}
@@ -0,0 +1,141 @@
+// pong_platform.h for Win32. Input and presentation are in pong.cpp with
+// the window they need.
+
+u64 platformGetCounter(void) {
+	LARGE_INTEGER result;
+	QueryPerformanceCounter(&result);
+	return (u64)result.QuadPart;
+}
+
+u64 platformCounterFrequency(void) {
+	LARGE_INTEGER result;
+	QueryPerformanceFrequency(&result);
+	return (u64)result.QuadPart;
+}
+
+void platformSleep(u32 milliseconds) {
+	Sleep(milliseconds);
+}
+
+void *platformAllocateMemory(size_t size) {
+	return VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+}
+
+void platformFreeMemory(void *memory, size_t size) {
+	if(memory) {
+		VirtualFree(memory, 0, MEM_RELEASE);
+	}
+}
+
+platform_file platformReadEntireFile(const char *path) {
+	platform_file result = {};
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+	if(file == INVALID_HANDLE_VALUE) {
+		return result;
+	}
+
+	LARGE_INTEGER fileSize;
+	if(GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 && fileSize.QuadPart <= 0xFFFFFFFF) {
+		u32 size = (u32)fileSize.QuadPart;
+		result.contents = platformAllocateMemory(size);
+		DWORD bytesRead = 0;
+		if(result.contents && ReadFile(file, result.contents, size, &bytesRead, 0) && bytesRead == size) {
+			result.size = size;
+		}
+		else {
+			platformFreeFileMemory(&result);
+		}
+	}
+
+	CloseHandle(file);
+	return result;
+}
+
+void platformFreeFileMemory(platform_file *file) {
+	platformFreeMemory(file->contents, file->size);
+	file->contents = 0;
+	file->size = 0;
+}
+
+bool platformWriteEntireFile(const char *path, void *memory, u32 size) {
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0);
+	if(file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	DWORD bytesWritten = 0;
+	bool result = (WriteFile(file, memory, size, &bytesWritten, 0) && bytesWritten == size);
+	CloseHandle(file);
+	return result;
+}
+
+platform_output_file platformCreateOutputFile(const char *path) {
+	platform_output_file result = {};
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if(file != INVALID_HANDLE_VALUE) {
+		result.handle = (u64)file;
+		result.valid = true;
+	}
+	return result;
+}
+
+bool platformWriteOutputFile(platform_output_file *file, void *memory, u32 size) {
+	DWORD bytesWritten = 0;
+	bool result = (WriteFile((HANDLE)file->handle, memory, size, &bytesWritten, 0) && bytesWritten == size);
+	return result;
+}
+
+void platformCloseOutputFile(platform_output_file *file) {
+	if(file->valid) {
+		CloseHandle((HANDLE)file->handle);
+	}
+	*file = {};
+}
+
+platform_map_result platformMapFile(platform_mapped_file *mapped, const char *path, u64 size, u64 baseAddress) {
+	*mapped = {};
+
+	HANDLE file = CreateFileA(path, GENERIC_READ|GENERIC_WRITE, 0, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	if(file == INVALID_HANDLE_VALUE) {
+		return PlatformMapFailed;
+	}
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		return PlatformMapFailed;
+	}
+	if(fileSize.QuadPart != 0 && (u64)fileSize.QuadPart != size) {
+		CloseHandle(file);
+		return PlatformMapWrongSize;
+	}
+
+	// Sizing the mapping grows a new, empty file to size.
+	HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, 0);
+	void *memory = mapping ? MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size, (void *)baseAddress) : 0;
+	if(!memory) {
+		if(mapping) {
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return PlatformMapFailed;
+	}
+
+	mapped->memory = memory;
+	mapped->size = size;
+	mapped->handles[0] = (u64)file;
+	mapped->handles[1] = (u64)mapping;
+	return (fileSize.QuadPart != 0) ? PlatformMapOpened : PlatformMapCreated;
+}
+
+void platformUnmapFile(platform_mapped_file *mapped) {
+	UnmapViewOfFile(mapped->memory);
+	CloseHandle((HANDLE)mapped->handles[1]);
+	CloseHandle((HANDLE)mapped->handles[0]);
+	*mapped = {};
+}
+
+void platformLog(const char *text) {
+	OutputDebugStringA(text);
+}
@@ -0,0 +1,195 @@
+// Monte Carlo rollouts: copies of a live game_state played forward headless
+// under randomly sampled bot policies until somebody scores. Nothing is
+// allocated after initRolloutEngine(); launching copies the root state into
+// preallocated slots and queues one work entry per Rollouts_Per_Job.
+
+void initRolloutEngine(rollout_engine *engine, memory_arena *arena, work_queue *queue, rollout_clock *clock) {
+	*engine = {};
+	engine->queue = queue;
+	engine->clock = clock;
+	engine->games = pushArray(arena, Max_Rollouts, game_state);
+	engine->bots = pushArray(arena, 2 * Max_Rollouts, bot_state);
+}
+
+// A policy somewhere between the easy and hard presets. Perfect is left out:
+// two perfect bots never concede, so those rollouts would never finish.
+static bot_difficulty sampleBotDifficulty(u32 *random) {
+	bot_difficulty worst = globalBotDifficulties[0];
+	bot_difficulty best = globalBotDifficulties[2];
+	float t = randomUnilateral(random);
+
+	bot_difficulty result;
+	result.reactionTicks = (u32)(lerp((float)worst.reactionTicks, t, (float)best.reactionTicks) + 0.5f);
+	result.noise = lerp(worst.noise, t, best.noise);
+	result.deadZone = lerp(worst.deadZone, t, best.deadZone);
+	return result;
+}
+
+static void swapRollouts(rollout_engine *engine, u32 a, u32 b) {
+	game_state game = engine->games[a];
+	engine->games[a] = engine->games[b];
+	engine->games[b] = game;
+
+	bot_state *bots = engine->bots;
+	for(u32 player=0; player < 2; ++player) {
+		bot_state bot = bots[2*a + player];
+		bots[2*a + player] = bots[2*b + player];
+		bots[2*b + player] = bot;
+	}
+}
+
+static void runRolloutJob(work_queue *queue, void *data) {
+	rollout_job *job = (rollout_job *)data;
+	rollout_engine *engine = job->engine;
+
+	u32 wins[2] = {};
+	u32 unfinished = 0;
+	u32 skipped = 0;
+	u64 ticks = 0;
+
+	if(engine->clock() >= engine->deadline) {
+		skipped = job->count;
+	}
+	else {
+		for(u32 i=job->first; i < job->first + job->count; ++i) {
+			engine->games[i] = engine->root;
+
+			u32 random = (u32)mixSeed(engine->seed ^ mixSeed(i));
+			for(u32 player=0; player < 2; ++player) {
+				initBot(engine->bots + 2*i + player, sampleBotDifficulty(&random), nextRandom(&random));
+			}
+		}
+
+		// Finished rollouts are swapped out of [first, first + live) so the
+		// batch update only ever sees games that are still playing.
+		u32 live = job->count;
+		for(u32 tick=0; tick < engine->maxTicks && live; ++tick) {
+			game_state *games = engine->games + job->first;
+			bot_state *bots = engine->bots + 2*job->first;
+			for(u32 i=0; i < live; ++i) {
+				botDecide(bots + 2*i + 0, games + i, 0, engine->dt);
+				botDecide(bots + 2*i + 1, games + i, 1, engine->dt);
+			}
+
+			updateBatch(games, live, engine->dt);
+			ticks += live;
+
+			for(u32 i=0; i < live;) {
+				u32 events = games[i].events;
+				if(events & (EventPointPlayer0 | EventPointPlayer1)) {
+					++wins[(events & EventPointPlayer0) ? 0 : 1];
+					--live;
+					swapRollouts(engine, job->first + i, job->first + live);
+				}
+				else {
+					++i;
+				}
+			}
+
+			if((tick % Rollout_Deadline_Check) == Rollout_Deadline_Check - 1 &&
+			   engine->clock() >= engine->deadline) {
+				break;
+			}
+		}
+		unfinished = live;
+	}
+
+	atomicAddU32(&engine->wins[0], wins[0]);
+	atomicAddU32(&engine->wins[1], wins[1]);
+	atomicAddU32(&engine->unfinished, unfinished);
+	atomicAddU32(&engine->skipped, skipped);
+	atomicAddU64(&engine->ticks, ticks);
+
+	// The decrement releases this store, so whoever sees jobsRemaining reach
+	// 0 sees every job's finish time.
+	job->finished = engine->clock();
+	atomicAddU32(&engine->jobsRemaining, (u32)-1);
+}
+
+// Starts `count` rollouts (rounded up to whole jobs) from a copy of root and
+// returns immediately. Each runs for at most maxTicks steps of dt; whatever
+// is still running at start + budget microseconds gives up.
+void launchRollouts(rollout_engine *engine, game_state *root, u32 count, float dt, u32 maxTicks,
+                    u64 budget, u32 seed) {
+	u32 jobCount = (count + Rollouts_Per_Job - 1) / Rollouts_Per_Job;
+	if(jobCount < 1) {
+		jobCount = 1;
+	}
+	if(jobCount > Max_Rollout_Jobs) {
+		jobCount = Max_Rollout_Jobs;
+	}
+
+	engine->root = *root;
+	engine->dt = dt;
+	engine->maxTicks = maxTicks;
+	engine->seed = seed;
+	engine->start = engine->clock();
+	engine->deadline = engine->start + budget;
+	engine->launched = jobCount * Rollouts_Per_Job;
+	engine->jobCount = jobCount;
+
+	engine->wins[0] = 0;
+	engine->wins[1] = 0;
+	engine->unfinished = 0;
+	engine->skipped = 0;
+	engine->ticks = 0;
+	atomicStoreU32(&engine->jobsRemaining, jobCount);
+
+	for(u32 i=0; i < jobCount; ++i) {
+		rollout_job *job = engine->jobs + i;
+		job->engine = engine;
+		job->first = i * Rollouts_Per_Job;
+		job->count = Rollouts_Per_Job;
+		addWorkEntry(engine->queue, runRolloutJob, job);
+	}
+}
+
+inline bool rolloutsComplete(rollout_engine *engine) {
+	bool result = (atomicLoadU32(&engine->jobsRemaining) == 0);
+	return result;
+}
+
+// Only valid once rolloutsComplete() is true.
+rollout_result getRolloutResult(rollout_engine *engine) {
+	rollout_result result = {};
+	result.wins[0] = engine->wins[0];
+	result.wins[1] = engine->wins[1];
+	result.unfinished = engine->unfinished;
+	result.skipped = engine->skipped;
+	result.ticks = engine->ticks;
+	result.launched = engine->launched;
+
+	// The batch finished when its last job did
+	u64 finished = engine->start;
+	for(u32 i=0; i < engine->jobCount; ++i) {
+		if(engine->jobs[i].finished > finished) {
+			finished = engine->jobs[i].finished;
+		}
+	}
+	result.elapsed = finished - engine->start;
+	return result;
+}
+
+// Probability that player 0 wins the next point, counting only rollouts that
+// reached one. 0.5 when none did.
+inline float rolloutWinProbability(rollout_result *result) {
+	u32 decided = result->wins[0] + result->wins[1];
+	float p = decided ? ((float)result->wins[0] / (float)decided) : 0.5f;
+	return p;
+}
+
+// Scales the number of rollouts so the next batch should just fit the budget.
+u32 nextRolloutCount(rollout_result *result, u64 budget) {
+	u32 count = result->launched - result->skipped;
+	if(result->elapsed > 0) {
+		u64 scaled = ((u64)count * budget * 7) / (result->elapsed * 8);
+		count = (scaled > Max_Rollouts) ? Max_Rollouts : (u32)scaled;
+	}
+	else {
+		count = Max_Rollouts;
+	}
+	if(count < Rollouts_Per_Job) {
+		count = Rollouts_Per_Job;
+	}
+	return count;
+}
@@ -0,0 +1,69 @@
+#ifndef PONG_ROLLOUT_H
+#define PONG_ROLLOUT_H
+
+// Rollouts are stepped in lockstep in groups of Rollouts_Per_Job, one group
+// per work queue entry.
+#define Rollouts_Per_Job 64
+#define Max_Rollout_Jobs 64
+#define Max_Rollouts (Rollouts_Per_Job * Max_Rollout_Jobs)
+
+// How often (in ticks) a job checks the clock against the deadline
+#define Rollout_Deadline_Check 16
+
+// Microseconds from any fixed point; injected so the engine stays
+// platform-free.
+typedef u64 rollout_clock(void);
+
+struct rollout_engine;
+
+struct rollout_job {
+	rollout_engine *engine;
+	u32 first;
+	u32 count;
+
+	// Clock reading when the job was done, written before it counts itself
+	// off jobsRemaining
+	u64 finished;
+};
+
+struct rollout_result {
+	// Points won by each player, rollouts that hit maxTicks or the deadline
+	// before anyone scored, and rollouts skipped because their job started
+	// after the deadline.
+	u32 wins[2];
+	u32 unfinished;
+	u32 skipped;
+	u64 ticks;
+
+	u32 launched;
+	u64 elapsed;
+};
+
+struct rollout_engine {
+	work_queue *queue;
+	rollout_clock *clock;
+
+	// Preallocated for Max_Rollouts; a launch only copies into them.
+	game_state *games;
+	bot_state *bots;
+	rollout_job jobs[Max_Rollout_Jobs];
+
+	game_state root;
+	float dt;
+	u32 maxTicks;
+	u32 seed;
+	u64 start;
+	u64 deadline;
+	u32 launched;
+	u32 jobCount;
+
+	// Accumulated by the jobs with one atomic add per job
+	u32 volatile wins[2];
+	u32 volatile unfinished;
+	u32 volatile skipped;
+	u64 volatile ticks;
+
+	u32 volatile jobsRemaining;
+};
+
+#endif
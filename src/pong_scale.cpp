@@ -0,0 +1,208 @@
+// See pong_scale.h.
+
+#include <emmintrin.h>
+
+// Where a sourceWidth x sourceHeight image goes in a destWidth x destHeight
+// window: as large as fits with its aspect kept, centered. integerOnly
+// rounds the scale down to a whole number (at least 1), for pixel-exact
+// output at the cost of wider bars.
+rectangle2i letterboxRect(s32 sourceWidth, s32 sourceHeight, s32 destWidth, s32 destHeight,
+                          bool integerOnly) {
+	if(sourceWidth <= 0 || sourceHeight <= 0 || destWidth <= 0 || destHeight <= 0) {
+		return Rect(0, 0, 0, 0);
+	}
+
+	s32 width = destWidth;
+	s32 height = (s32)(((s64)destWidth*sourceHeight) / sourceWidth);
+	if(height > destHeight) {
+		height = destHeight;
+		width = (s32)(((s64)destHeight*sourceWidth) / sourceHeight);
+	}
+
+	if(integerOnly) {
+		s32 factor = width / sourceWidth;
+		if(factor < 1) {
+			factor = 1;
+		}
+		width = factor*sourceWidth;
+		height = factor*sourceHeight;
+	}
+
+	s32 x = (destWidth - width) / 2;
+	s32 y = (destHeight - height) / 2;
+	return Rect(x, y, x + width, y + height);
+}
+
+// dest is exactly factor times the size of source. Each source row is
+// expanded once and the result copied down the other factor - 1 rows.
+void upscaleInteger(pixel_image *source, pixel_image *dest, s32 factor) {
+	u8 *sourceRow = (u8 *)source->memory;
+	u8 *destRow = (u8 *)dest->memory;
+	size_t rowBytes = (size_t)dest->width*sizeof(u32);
+
+	for(s32 y=0; y < source->height; ++y) {
+		u32 *from = (u32 *)sourceRow;
+		u32 *to = (u32 *)destRow;
+
+		if(factor == 1) {
+			memcpy(to, from, rowBytes);
+		}
+		else if(factor == 2) {
+			s32 x = 0;
+			for(; x + 4 <= source->width; x += 4) {
+				__m128i pixels = _mm_loadu_si128((__m128i *)(from + x));
+				_mm_storeu_si128((__m128i *)(to + 2*x), _mm_unpacklo_epi32(pixels, pixels));
+				_mm_storeu_si128((__m128i *)(to + 2*x + 4), _mm_unpackhi_epi32(pixels, pixels));
+			}
+			for(; x < source->width; ++x) {
+				to[2*x] = to[2*x + 1] = from[x];
+			}
+		}
+		else {
+			// Whole 4-pixel stores, each pixel's overrun covered by the next
+			// one; only the last pixel in the row has to stop exactly.
+			s32 last = source->width - 1;
+			for(s32 x=0; x < last; ++x) {
+				__m128i pixel = _mm_set1_epi32((int)from[x]);
+				u32 *out = to + x*factor;
+				for(s32 i=0; i < factor; i += 4) {
+					_mm_storeu_si128((__m128i *)(out + i), pixel);
+				}
+			}
+			u32 *out = to + last*factor;
+			for(s32 i=0; i < factor; ++i) {
+				out[i] = from[last];
+			}
+		}
+
+		for(s32 copy=1; copy < factor; ++copy) {
+			memcpy(destRow + copy*dest->pitch, destRow, rowBytes);
+		}
+
+		sourceRow += source->pitch;
+		destRow += factor*dest->pitch;
+	}
+}
+
+// One source row stretched to the destination width: two destination pixels
+// per step, each a blend of the source pixel pair columns[x] points at.
+static void scaleRowBilinear(u32 *from, u32 *to, u32 *columns, __m128i *weights, s32 count) {
+	__m128i zero = _mm_setzero_si128();
+	for(s32 x=0; x < count; x += 2) {
+		__m128i pair0 = _mm_loadl_epi64((__m128i *)(from + columns[x]));
+		__m128i pair1 = _mm_loadl_epi64((__m128i *)(from + columns[x + 1]));
+
+		// [left0 left1 right0 right1]
+		__m128i pairs = _mm_shuffle_epi32(_mm_unpacklo_epi64(pair0, pair1), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i left = _mm_unpacklo_epi8(pairs, zero);
+		__m128i right = _mm_unpackhi_epi8(pairs, zero);
+
+		__m128i blended = _mm_add_epi16(left, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(right, left),
+		                                                                     weights[x/2]), 7));
+		_mm_storel_epi64((__m128i *)(to + x), _mm_packus_epi16(blended, blended));
+	}
+}
+
+// Pixel centers are mapped onto each other in 16.16 fixed point, and weights
+// are cut to 7 bits so a channel difference times a weight fits a signed
+// 16-bit lane. Source rows are stretched horizontally once each (the two
+// most recent are kept in scratch) and every destination row is a vertical
+// blend of two of them, four pixels at a time. The horizontal sample
+// positions are the same for every row, so they're worked out up front.
+void upscaleBilinear(pixel_image *source, pixel_image *dest, void *scratch) {
+	s32 count = (dest->width + 3) & ~3;
+	size_t rowBytes = Align16((size_t)count*sizeof(u32));
+	u32 *rows[2] = {(u32 *)scratch, (u32 *)((u8 *)scratch + rowBytes)};
+	u32 *columns = (u32 *)((u8 *)scratch + 2*rowBytes);
+	__m128i *weights = (__m128i *)((u8 *)columns + rowBytes);
+
+	// Every pair read stays inside the row: the last column blends all the
+	// way into its left neighbour's right-hand partner instead.
+	s32 stepX = (s32)(((s64)source->width << 16) / dest->width);
+	s32 maxX = (source->width - 1) << 16;
+	s32 sx = stepX/2 - 0x8000;
+	s16 pairWeights[2];
+	for(s32 x=0; x < count; ++x, sx += stepX) {
+		s32 clamped = (sx < 0) ? 0 : ((sx > maxX) ? maxX : sx);
+		s32 index = clamped >> 16;
+		s16 weight = (s16)((clamped & 0xFFFF) >> 9);
+		if(index >= source->width - 1) {
+			index = (source->width >= 2) ? (source->width - 2) : 0;
+			weight = 128;
+		}
+		columns[x] = (u32)index;
+		pairWeights[x & 1] = weight;
+		if(x & 1) {
+			weights[x/2] = _mm_set_epi16(pairWeights[1], pairWeights[1], pairWeights[1], pairWeights[1],
+			                             pairWeights[0], pairWeights[0], pairWeights[0], pairWeights[0]);
+		}
+	}
+
+	s32 cached[2] = {-1, -1};
+	s32 stepY = (s32)(((s64)source->height << 16) / dest->height);
+	s32 maxY = (source->height - 1) << 16;
+	s32 sy = stepY/2 - 0x8000;
+
+	u8 *destRow = (u8 *)dest->memory;
+	for(s32 y=0; y < dest->height; ++y, sy += stepY) {
+		s32 clampedY = (sy < 0) ? 0 : ((sy > maxY) ? maxY : sy);
+		s32 y0 = clampedY >> 16;
+		s32 y1 = (y0 + 1 < source->height) ? (y0 + 1) : y0;
+
+		// Moving down a row usually turns the old lower row into the new
+		// upper one.
+		if(cached[0] != y0 && cached[1] == y0) {
+			u32 *swapRow = rows[0];
+			rows[0] = rows[1];
+			rows[1] = swapRow;
+			cached[0] = y0;
+			cached[1] = -1;
+		}
+		if(cached[0] != y0) {
+			scaleRowBilinear((u32 *)((u8 *)source->memory + y0*source->pitch), rows[0], columns, weights, count);
+			cached[0] = y0;
+		}
+		if(cached[1] != y1) {
+			scaleRowBilinear((u32 *)((u8 *)source->memory + y1*source->pitch), rows[1], columns, weights, count);
+			cached[1] = y1;
+		}
+
+		u32 *to = (u32 *)destRow;
+		s16 fraction = (s16)((clampedY & 0xFFFF) >> 9);
+		if(fraction == 0) {
+			memcpy(to, rows[0], (size_t)dest->width*sizeof(u32));
+		}
+		else {
+			__m128i zero = _mm_setzero_si128();
+			__m128i weightY = _mm_set1_epi16(fraction);
+			for(s32 x=0; x < count; x += 4) {
+				__m128i a = _mm_load_si128((__m128i *)(rows[0] + x));
+				__m128i b = _mm_load_si128((__m128i *)(rows[1] + x));
+
+				__m128i aLo = _mm_unpacklo_epi8(a, zero);
+				__m128i bLo = _mm_unpacklo_epi8(b, zero);
+				__m128i aHi = _mm_unpackhi_epi8(a, zero);
+				__m128i bHi = _mm_unpackhi_epi8(b, zero);
+
+				__m128i lo = _mm_add_epi16(aLo, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(bLo, aLo), weightY), 7));
+				__m128i hi = _mm_add_epi16(aHi, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(bHi, aHi), weightY), 7));
+				_mm_storeu_si128((__m128i *)(to + x), _mm_packus_epi16(lo, hi));
+			}
+		}
+
+		destRow += dest->pitch;
+	}
+}
+
+// Fills all of dest from all of source, by pixel replication when dest is an
+// exact multiple of source and bilinearly otherwise. scratch needs
+// scaleScratchSize(dest->width) bytes, 16-byte aligned.
+void scaleImage(pixel_image *source, pixel_image *dest, void *scratch) {
+	s32 factor = dest->width / source->width;
+	if(factor >= 1 && dest->width == factor*source->width && dest->height == factor*source->height) {
+		upscaleInteger(source, dest, factor);
+	}
+	else {
+		upscaleBilinear(source, dest, scratch);
+	}
+}
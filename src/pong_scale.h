@@ -0,0 +1,23 @@
+#ifndef PONG_SCALE_H
+#define PONG_SCALE_H
+
+// Frames are drawn at a fixed internal resolution and fitted to whatever the
+// window is: the largest aspect-correct rectangle, with black bars around
+// it, filled by one of two SSE2 upscalers. An exact integer ratio replicates
+// pixels; anything else is bilinear.
+
+// 32-bit pixels, pitch in bytes. Destinations are written in blocks of 4
+// pixels, so their pitch has to cover the width rounded up to 4 (Align16
+// does).
+struct pixel_image {
+	void *memory;
+	s32 width;
+	s32 height;
+	s32 pitch;
+};
+
+// Bytes of scratch scaleImage() needs for a destination this wide: two
+// stretched rows, their source columns and the blend weights (two rows' worth).
+#define scaleScratchSize(destWidth) (5*Align16(4*(((destWidth) + 3) & ~3)))
+
+#endif
@@ -0,0 +1,84 @@
+// Milliseconds per frame for the present upscalers, from the internal
+// resolutions we render at to common window sizes.
+//
+//   pong_scale_bench [frames]
+
+#include "pong_game.h"
+#include "pong_scale.h"
+#include "pong_bench.h"
+#include "pong_scale.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static pixel_image makeImage(s32 width, s32 height) {
+	pixel_image result;
+	result.width = width;
+	result.height = height;
+	result.pitch = Align16(width*4);
+	result.memory = calloc(1, (size_t)result.pitch*height);
+	return result;
+}
+
+// Something with edges in it, so nothing is trivially constant
+static void fillPattern(pixel_image *image) {
+	for(s32 y=0; y < image->height; ++y) {
+		u32 *row = (u32 *)((u8 *)image->memory + y*image->pitch);
+		for(s32 x=0; x < image->width; ++x) {
+			row[x] = 0xFF000000 | ((x*7) & 0xFF) << 16 | ((y*3) & 0xFF) << 8 | (((x ^ y) & 8) ? 0xFF : 0);
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	u32 frames = (argc > 1) ? (u32)atoi(argv[1]) : 60;
+
+	struct scale_case {
+		s32 sourceWidth, sourceHeight;
+		s32 destWidth, destHeight;
+	};
+	scale_case cases[] = {
+		{640, 360, 1280, 720},
+		{640, 360, 1920, 1080},
+		{640, 360, 3840, 2160},
+		{1280, 720, 1920, 1080},
+		{1280, 720, 2560, 1440},
+		{1280, 720, 3840, 2160},
+		{1280, 720, 3440, 1440},
+		{1600, 900, 3840, 2160},
+	};
+
+	printf("%10s %10s %10s %10s %10s\n", "FROM", "TO", "PATH", "MS/FRAME", "MPIX/S");
+	for(u32 c=0; c < arrayCount(cases); ++c) {
+		scale_case *test = cases + c;
+		pixel_image source = makeImage(test->sourceWidth, test->sourceHeight);
+		fillPattern(&source);
+
+		// The window's letterbox, as the host would present it
+		rectangle2i fit = letterboxRect(test->sourceWidth, test->sourceHeight,
+		                                test->destWidth, test->destHeight, false);
+		pixel_image dest = makeImage(fit.maxX - fit.minX, fit.maxY - fit.minY);
+		void *scratch = malloc(scaleScratchSize(dest.width));
+
+		bool integer = (dest.width % source.width == 0 && dest.height == (dest.width / source.width)*source.height);
+
+		scaleImage(&source, &dest, scratch);
+		double start = benchSeconds();
+		for(u32 frame=0; frame < frames; ++frame) {
+			scaleImage(&source, &dest, scratch);
+		}
+		double seconds = (benchSeconds() - start) / frames;
+
+		char from[32], to[32];
+		sprintf(from, "%dx%d", source.width, source.height);
+		sprintf(to, "%dx%d", dest.width, dest.height);
+		printf("%10s %10s %10s %10.3f %10.0f\n", from, to, integer ? "integer" : "bilinear",
+		       1000.0*seconds, (double)dest.width*dest.height / (seconds*1e6));
+
+		free(scratch);
+		free(dest.memory);
+		free(source.memory);
+	}
+
+	return 0;
+}
@@ -0,0 +1,404 @@
+// See pong_sprite.h.
+
+#include <emmintrin.h>
+
+void initSpriteAtlas(sprite_atlas *atlas, memory_arena *arena) {
+	atlas->pitch = Sprite_Atlas_Width;
+	atlas->pixels = pushArray(arena, Sprite_Atlas_Width*Sprite_Atlas_Height, u32);
+	atlas->scratch = pushArray(arena, Sprite_Atlas_Width*Sprite_Atlas_Height, u32);
+	for(u32 i=0; i < Sprite_Count; ++i) {
+		atlas->sprites[i] = Rect(0, 0, 0, 0);
+		atlas->sizes[i].x = atlas->sizes[i].y = 0;
+	}
+	atlas->version = 0;
+	atlas->texture = 0;
+	atlas->uploadedVersion = 0;
+}
+
+inline bool spriteReady(sprite_atlas *atlas, sprite_id id) {
+	rectangle2i rect = atlas->sprites[id];
+	return rect.minX < rect.maxX && rect.minY < rect.maxY;
+}
+
+inline float clamp01(float value) {
+	return (value < 0.0f) ? 0.0f : ((value > 1.0f) ? 1.0f : value);
+}
+
+// Straight alpha, channels in [0, 1]
+inline u32 packColor(float r, float g, float b, float a) {
+	return ((u32)(255.0f*clamp01(a) + 0.5f) << 24) | ((u32)(255.0f*clamp01(r) + 0.5f) << 16) |
+	       ((u32)(255.0f*clamp01(g) + 0.5f) << 8) | (u32)(255.0f*clamp01(b) + 0.5f);
+}
+
+// A rounded bar, lit down the middle like a cylinder. Coverage comes from
+// the distance to the rounded outline, so the edge is one pixel of falloff.
+static void drawPaddleImage(pixel_image *image) {
+	float halfWidth = 0.5f*image->width;
+	float halfHeight = 0.5f*image->height;
+	float radius = 0.4f*((halfWidth < halfHeight) ? halfWidth : halfHeight);
+
+	u8 *row = (u8 *)image->memory;
+	for(s32 y=0; y < image->height; ++y) {
+		u32 *pixel = (u32 *)row;
+		for(s32 x=0; x < image->width; ++x) {
+			float dx = fabsf(x + 0.5f - halfWidth);
+			float dy = fabsf(y + 0.5f - halfHeight);
+			float cornerX = dx - (halfWidth - radius);
+			float cornerY = dy - (halfHeight - radius);
+			float outsideX = (cornerX > 0.0f) ? cornerX : 0.0f;
+			float outsideY = (cornerY > 0.0f) ? cornerY : 0.0f;
+			float inside = (cornerX > cornerY) ? cornerX : cornerY;
+			float distance = sqrtf(outsideX*outsideX + outsideY*outsideY) + ((inside < 0.0f) ? inside : 0.0f) - radius;
+
+			float across = dx / halfWidth;
+			float light = 1.0f - 0.45f*across*across;
+			pixel[x] = packColor(0.85f*light, 0.91f*light, light, 0.5f - distance);
+		}
+		row += image->pitch;
+	}
+}
+
+// A disc in color (0xRRGGBB), lit from the top left.
+static void drawBallImage(pixel_image *image, u32 color) {
+	float halfWidth = 0.5f*image->width;
+	float halfHeight = 0.5f*image->height;
+	float radius = (halfWidth < halfHeight) ? halfWidth : halfHeight;
+	float r = ((color >> 16) & 0xFF) / 255.0f;
+	float g = ((color >> 8) & 0xFF) / 255.0f;
+	float b = (color & 0xFF) / 255.0f;
+
+	u8 *row = (u8 *)image->memory;
+	for(s32 y=0; y < image->height; ++y) {
+		u32 *pixel = (u32 *)row;
+		for(s32 x=0; x < image->width; ++x) {
+			float dx = x + 0.5f - halfWidth;
+			float dy = y + 0.5f - halfHeight;
+			float distance = sqrtf(dx*dx + dy*dy) - radius;
+
+			float hx = dx + 0.35f*radius;
+			float hy = dy + 0.35f*radius;
+			float light = 1.15f - 0.55f*sqrtf(hx*hx + hy*hy) / radius;
+			pixel[x] = packColor(r*light, g*light, b*light, 0.5f - distance);
+		}
+		row += image->pitch;
+	}
+}
+
+// Shelf packing, tallest first: sprites go left to right along a shelf as
+// tall as its first one, and a new shelf starts when the row is full.
+// Pixels are premultiplied on the way in. Images with no pixels, or that
+// don't fit, get an empty rectangle.
+static void packSpriteAtlas(sprite_atlas *atlas, pixel_image *images) {
+	u32 order[Sprite_Count];
+	for(u32 i=0; i < Sprite_Count; ++i) {
+		u32 j = i;
+		for(; j > 0 && images[order[j - 1]].height < images[i].height; --j) {
+			order[j] = order[j - 1];
+		}
+		order[j] = i;
+	}
+
+	memset(atlas->pixels, 0, (size_t)atlas->pitch*Sprite_Atlas_Height*sizeof(u32));
+
+	s32 shelfX = 0;
+	s32 shelfY = 0;
+	s32 shelfHeight = 0;
+	for(u32 i=0; i < Sprite_Count; ++i) {
+		pixel_image *image = images + order[i];
+		rectangle2i *rect = atlas->sprites + order[i];
+		*rect = Rect(0, 0, 0, 0);
+		if(image->width <= 0 || image->height <= 0) {
+			continue;
+		}
+
+		s32 width = image->width + 2*Sprite_Padding;
+		s32 height = image->height + 2*Sprite_Padding;
+		if(shelfX + width > Sprite_Atlas_Width) {
+			shelfX = 0;
+			shelfY += shelfHeight;
+			shelfHeight = 0;
+		}
+		if(shelfX + width > Sprite_Atlas_Width || shelfY + height > Sprite_Atlas_Height) {
+			continue;
+		}
+
+		s32 minX = shelfX + Sprite_Padding;
+		s32 minY = shelfY + Sprite_Padding;
+		for(s32 y=0; y < image->height; ++y) {
+			u32 *from = (u32 *)((u8 *)image->memory + y*image->pitch);
+			u32 *to = atlas->pixels + (minY + y)*atlas->pitch + minX;
+			for(s32 x=0; x < image->width; ++x) {
+				u32 pixel = from[x];
+				u32 a = pixel >> 24;
+				u32 r = (((pixel >> 16) & 0xFF)*a + 127) / 255;
+				u32 g = (((pixel >> 8) & 0xFF)*a + 127) / 255;
+				u32 b = ((pixel & 0xFF)*a + 127) / 255;
+				to[x] = (a << 24) | (r << 16) | (g << 8) | b;
+			}
+		}
+		*rect = Rect(minX, minY, minX + image->width, minY + image->height);
+
+		shelfX += width;
+		if(height > shelfHeight) {
+			shelfHeight = height;
+		}
+	}
+}
+
+// Sizes are in arena units (poolSize 0 without stress-mode balls) and scale
+// takes them to pixels. Redraws and repacks the sprites if any of them
+// changed size in pixels; returns whether it did.
+bool updateSpriteAtlas(sprite_atlas *atlas, v2 paddleSize, v2 ballSize, float poolSize, v2 scale) {
+	v2 sizes[Sprite_Count] = {paddleSize, ballSize, V2(poolSize, poolSize)};
+	v2i pixelSizes[Sprite_Count];
+	bool changed = (atlas->version == 0);
+	for(u32 i=0; i < Sprite_Count; ++i) {
+		v2i size = {0, 0};
+		if(sizes[i].x > 0.0f && sizes[i].y > 0.0f) {
+			size.x = (s32)(sizes[i].x*scale.x + 0.5f);
+			size.y = (s32)(sizes[i].y*scale.y + 0.5f);
+			size.x = (size.x > 1) ? size.x : 1;
+			size.y = (size.y > 1) ? size.y : 1;
+		}
+		pixelSizes[i] = size;
+		changed = changed || (size.x != atlas->sizes[i].x || size.y != atlas->sizes[i].y);
+	}
+	if(!changed) {
+		return false;
+	}
+
+	// Every image goes in scratch one after another; one too big for what's
+	// left would never fit the atlas anyway.
+	pixel_image images[Sprite_Count];
+	u32 *at = atlas->scratch;
+	s64 remaining = (s64)Sprite_Atlas_Width*Sprite_Atlas_Height;
+	for(u32 i=0; i < Sprite_Count; ++i) {
+		s64 area = (s64)pixelSizes[i].x*pixelSizes[i].y;
+		images[i].memory = at;
+		images[i].width = (area <= remaining) ? pixelSizes[i].x : 0;
+		images[i].height = (area <= remaining) ? pixelSizes[i].y : 0;
+		images[i].pitch = images[i].width*(s32)sizeof(u32);
+		at += (s64)images[i].width*images[i].height;
+		remaining -= (s64)images[i].width*images[i].height;
+		atlas->sizes[i] = pixelSizes[i];
+	}
+
+	drawPaddleImage(images + SpritePaddle);
+	drawBallImage(images + SpriteBall, 0xFFFFFF);
+	drawBallImage(images + SpritePoolBall, 0x8080FF);
+	packSpriteAtlas(atlas, images);
+
+	++atlas->version;
+	return true;
+}
+
+// Premultiplied "over": color + dest*(255 - alpha)/255 per channel.
+inline u32 overPixel(u32 dest, u32 color) {
+	u32 inverse = 255 - (color >> 24);
+	u32 result = 0;
+	for(u32 shift=0; shift < 32; shift += 8) {
+		u32 t = ((dest >> shift) & 0xFF)*inverse + 128;
+		u32 channel = ((color >> shift) & 0xFF) + ((t + (t >> 8)) >> 8);
+		result |= ((channel < 255) ? channel : 255) << shift;
+	}
+	return result;
+}
+
+// overPixel() for four pixels at once
+inline __m128i overPixels(__m128i dest, __m128i color) {
+	__m128i zero = _mm_setzero_si128();
+	__m128i max = _mm_set1_epi16(255);
+	__m128i half = _mm_set1_epi16(128);
+
+	// 255 - alpha in every 16-bit lane of its pixel
+	__m128i colorLo = _mm_unpacklo_epi8(color, zero);
+	__m128i colorHi = _mm_unpackhi_epi8(color, zero);
+	__m128i inverseLo = _mm_sub_epi16(max, _mm_shufflehi_epi16(_mm_shufflelo_epi16(colorLo, 0xFF), 0xFF));
+	__m128i inverseHi = _mm_sub_epi16(max, _mm_shufflehi_epi16(_mm_shufflelo_epi16(colorHi, 0xFF), 0xFF));
+
+	__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dest, zero), inverseLo), half);
+	__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dest, zero), inverseHi), half);
+	lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+	hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+	return _mm_adds_epu8(color, _mm_packus_epi16(lo, hi));
+}
+
+// The sprite's top left corner goes at (x, y); whatever hangs off the image
+// is clipped away. Four pixels at a time, and groups that are all opaque or
+// all transparent skip the blend, so a solid sprite's interior costs about
+// what a plain fill does. A row that isn't a multiple of 4 ends with a group
+// overlapping the one before, blended from the row as it was and stored
+// last, so the overlap gets the same values twice.
+void blitSprite(pixel_image *image, sprite_atlas *atlas, sprite_id id, s32 x, s32 y) {
+	rectangle2i source = atlas->sprites[id];
+	rectangle2i dest = Rect(x, y, x + (source.maxX - source.minX), y + (source.maxY - source.minY));
+	rectangle2i clip = clipRect(dest, Rect(0, 0, image->width, image->height));
+	if(clip.minX >= clip.maxX || clip.minY >= clip.maxY) {
+		return;
+	}
+
+	s32 width = clip.maxX - clip.minX;
+	s32 tail = width & 3;
+	u32 *fromRow = atlas->pixels + (source.minY + clip.minY - dest.minY)*atlas->pitch +
+	               (source.minX + clip.minX - dest.minX);
+	u8 *toRow = (u8 *)image->memory + clip.minX*sizeof(u32) + clip.minY*image->pitch;
+
+	__m128i zero = _mm_setzero_si128();
+	__m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+	for(s32 row=clip.minY; row < clip.maxY; ++row) {
+		u32 *from = fromRow;
+		u32 *to = (u32 *)toRow;
+
+		__m128i last = zero;
+		if(tail && width > 4) {
+			last = overPixels(_mm_loadu_si128((__m128i *)(to + width - 4)), _mm_loadu_si128((__m128i *)(from + width - 4)));
+		}
+
+		s32 i = 0;
+		for(; i + 4 <= width; i += 4) {
+			__m128i color = _mm_loadu_si128((__m128i *)(from + i));
+			__m128i alpha = _mm_and_si128(color, alphaMask);
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xFFFF) {
+				_mm_storeu_si128((__m128i *)(to + i), color);
+			}
+			else if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) != 0xFFFF) {
+				__m128i blended = overPixels(_mm_loadu_si128((__m128i *)(to + i)), color);
+				_mm_storeu_si128((__m128i *)(to + i), blended);
+			}
+		}
+
+		if(tail && width > 4) {
+			_mm_storeu_si128((__m128i *)(to + width - 4), last);
+		}
+		else {
+			for(; i < width; ++i) {
+				to[i] = overPixel(to[i], from[i]);
+			}
+		}
+
+		fromRow += atlas->pitch;
+		toRow += image->pitch;
+	}
+}
+
+// Four pixels of a sprite shifted right and down by a fraction of a pixel:
+// each is the four atlas pixels around it, weighted by how much of them it
+// covers. top and bottom are the rows above and at the output row, and the
+// weights add up to 256 so every channel stays within 16 bits.
+inline __m128i filterSpritePixels(u32 *top, u32 *bottom, __m128i *weights) {
+	__m128i zero = _mm_setzero_si128();
+	__m128i topLeft = _mm_loadu_si128((__m128i *)(top - 1));
+	__m128i topRight = _mm_loadu_si128((__m128i *)top);
+	__m128i bottomLeft = _mm_loadu_si128((__m128i *)(bottom - 1));
+	__m128i bottomRight = _mm_loadu_si128((__m128i *)bottom);
+
+	__m128i lo = _mm_set1_epi16(128);
+	lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(topLeft, zero), weights[0]));
+	lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(topRight, zero), weights[1]));
+	lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(bottomLeft, zero), weights[2]));
+	lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(bottomRight, zero), weights[3]));
+
+	__m128i hi = _mm_set1_epi16(128);
+	hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(topLeft, zero), weights[0]));
+	hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(topRight, zero), weights[1]));
+	hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(bottomLeft, zero), weights[2]));
+	hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(bottomRight, zero), weights[3]));
+
+	return _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+}
+
+inline u32 filterSpritePixel(u32 *top, u32 *bottom, s32 *weights) {
+	u32 result = 0;
+	for(u32 shift=0; shift < 32; shift += 8) {
+		u32 channel = ((top[-1] >> shift) & 0xFF)*weights[0] + ((top[0] >> shift) & 0xFF)*weights[1] +
+		              ((bottom[-1] >> shift) & 0xFF)*weights[2] + ((bottom[0] >> shift) & 0xFF)*weights[3];
+		result |= ((channel + 128) >> 8) << shift;
+	}
+	return result;
+}
+
+// blitSprite() with the top left corner at a fractional (x, y), to a
+// sixteenth of a pixel, so a moving sprite glides instead of stepping a
+// whole pixel at a time. The sprite comes out one pixel wider and taller,
+// each pixel filtered from the 2x2 atlas pixels under it; the padding
+// around every sprite is what's read past its edges. Whole-pixel positions
+// go straight to blitSprite().
+void blitSpriteSubpixel(pixel_image *image, sprite_atlas *atlas, sprite_id id, float x, float y) {
+	s32 minX = (s32)floorf(x);
+	s32 minY = (s32)floorf(y);
+	s32 fractionX = (s32)(16.0f*(x - (float)minX) + 0.5f);
+	s32 fractionY = (s32)(16.0f*(y - (float)minY) + 0.5f);
+	if(fractionX == 16) {
+		++minX;
+		fractionX = 0;
+	}
+	if(fractionY == 16) {
+		++minY;
+		fractionY = 0;
+	}
+	if(fractionX == 0 && fractionY == 0) {
+		blitSprite(image, atlas, id, minX, minY);
+		return;
+	}
+
+	rectangle2i source = atlas->sprites[id];
+	rectangle2i dest = Rect(minX, minY, minX + (source.maxX - source.minX) + 1,
+	                        minY + (source.maxY - source.minY) + 1);
+	rectangle2i clip = clipRect(dest, Rect(0, 0, image->width, image->height));
+	if(clip.minX >= clip.maxX || clip.minY >= clip.maxY) {
+		return;
+	}
+
+	// Output pixel (i, j) takes atlas pixels i - 1 and i of rows j - 1 and j.
+	s32 weights[4] = {fractionX*fractionY, (16 - fractionX)*fractionY,
+	                  fractionX*(16 - fractionY), (16 - fractionX)*(16 - fractionY)};
+	__m128i wideWeights[4];
+	for(u32 i=0; i < arrayCount(weights); ++i) {
+		wideWeights[i] = _mm_set1_epi16((short)weights[i]);
+	}
+
+	s32 width = clip.maxX - clip.minX;
+	s32 tail = width & 3;
+	u32 *fromRow = atlas->pixels + (source.minY + clip.minY - dest.minY)*atlas->pitch +
+	               (source.minX + clip.minX - dest.minX);
+	u8 *toRow = (u8 *)image->memory + clip.minX*sizeof(u32) + clip.minY*image->pitch;
+
+	__m128i zero = _mm_setzero_si128();
+	__m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+	for(s32 row=clip.minY; row < clip.maxY; ++row) {
+		u32 *top = fromRow - atlas->pitch;
+		u32 *bottom = fromRow;
+		u32 *to = (u32 *)toRow;
+
+		__m128i last = zero;
+		if(tail && width > 4) {
+			__m128i color = filterSpritePixels(top + width - 4, bottom + width - 4, wideWeights);
+			last = overPixels(_mm_loadu_si128((__m128i *)(to + width - 4)), color);
+		}
+
+		s32 i = 0;
+		for(; i + 4 <= width; i += 4) {
+			__m128i color = filterSpritePixels(top + i, bottom + i, wideWeights);
+			__m128i alpha = _mm_and_si128(color, alphaMask);
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xFFFF) {
+				_mm_storeu_si128((__m128i *)(to + i), color);
+			}
+			else if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) != 0xFFFF) {
+				__m128i blended = overPixels(_mm_loadu_si128((__m128i *)(to + i)), color);
+				_mm_storeu_si128((__m128i *)(to + i), blended);
+			}
+		}
+
+		if(tail && width > 4) {
+			_mm_storeu_si128((__m128i *)(to + width - 4), last);
+		}
+		else {
+			for(; i < width; ++i) {
+				to[i] = overPixel(to[i], filterSpritePixel(top + i, bottom + i, weights));
+			}
+		}
+
+		fromRow += atlas->pitch;
+		toRow += image->pitch;
+	}
+}
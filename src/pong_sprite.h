@@ -0,0 +1,54 @@
+#ifndef PONG_SPRITE_H
+#define PONG_SPRITE_H
+
+// Themed paddles and balls. Each is a small image drawn procedurally at the
+// size it appears on screen and packed into one premultiplied-alpha atlas.
+// The software renderer blits sprites 1:1 out of the atlas, shifted by a
+// fraction of a pixel where they land between pixels (blitSpriteSubpixel);
+// GL uploads the same pixels as a texture and draws textured quads from it.
+// They're only redrawn when the render scale or the arena changes.
+
+#define Sprite_Atlas_Width 512
+#define Sprite_Atlas_Height 512
+
+// Transparent pixels around every sprite, so bilinear filtering (GL's, and
+// blitSpriteSubpixel's) never pulls in a neighbour.
+#define Sprite_Padding 1
+
+enum sprite_id {
+	SpritePaddle,
+	SpriteBall,
+	SpritePoolBall,
+
+	Sprite_Count
+};
+
+struct sprite_atlas {
+	// 0xAARRGGBB, color already multiplied by alpha. pitch is in pixels.
+	u32 *pixels;
+	s32 pitch;
+
+	// Where each sprite is in the atlas, empty if it isn't needed or didn't
+	// fit (that one is drawn as a solid fill instead).
+	rectangle2i sprites[Sprite_Count];
+
+	// The pixel sizes the sprites were drawn for. version goes up every time
+	// they're redrawn, so GL knows to upload again.
+	v2i sizes[Sprite_Count];
+	u32 version;
+
+	// Straight-alpha images before packing, the same size as the atlas
+	u32 *scratch;
+
+	// GLuint, u32 here so the software side doesn't need gl.h. 0 until
+	// uploaded.
+	u32 texture;
+	u32 uploadedVersion;
+};
+
+struct sprite_vertex {
+	float x, y;
+	float u, v;
+};
+
+#endif
@@ -0,0 +1,279 @@
+// See pong_stream.h.
+
+#include <emmintrin.h>
+
+// Frames are at most 65535 pixels and tiles a side, and a tile index fits a
+// u16.
+void initFrameEncoder(frame_encoder *encoder, memory_arena *arena, u32 width, u32 height) {
+	encoder->width = width;
+	encoder->height = height;
+	encoder->tilesX = (width + Stream_Tile_Size - 1) / Stream_Tile_Size;
+	encoder->tilesY = (height + Stream_Tile_Size - 1) / Stream_Tile_Size;
+	assert(width <= 0xFFFF && height <= 0xFFFF && encoder->tilesX*encoder->tilesY <= 0xFFFF);
+
+	encoder->previous = pushArray(arena, width*height, u32);
+	encoder->sendKeyframe = true;
+	encoder->changedTiles = 0;
+}
+
+// A spectator joining mid-stream needs one of these before it can decode
+// anything.
+inline void requestKeyframe(frame_encoder *encoder) {
+	encoder->sendKeyframe = true;
+}
+
+// Rows of the tile against the same rows of the last frame, four pixels at
+// a time, stopping at the first difference.
+static bool tileChanged(u32 *current, s32 currentPitch, u32 *previous, u32 previousPitch,
+                        u32 width, u32 height) {
+	u32 wide = width & ~3u;
+	for(u32 y=0; y < height; ++y) {
+		__m128i differences = _mm_setzero_si128();
+		for(u32 x=0; x < wide; x += 4) {
+			__m128i a = _mm_loadu_si128((__m128i *)(current + x));
+			__m128i b = _mm_loadu_si128((__m128i *)(previous + x));
+			differences = _mm_or_si128(differences, _mm_xor_si128(a, b));
+		}
+		if(_mm_movemask_epi8(_mm_cmpeq_epi32(differences, _mm_setzero_si128())) != 0xFFFF) {
+			return true;
+		}
+		for(u32 x=wide; x < width; ++x) {
+			if(current[x] != previous[x]) {
+				return true;
+			}
+		}
+
+		current = (u32 *)((u8 *)current + currentPitch);
+		previous += previousPitch;
+	}
+	return false;
+}
+
+inline u8 *writeRun(u8 *at, u32 op, u32 count) {
+	*at++ = (u8)(op | (count - 1));
+	return at;
+}
+
+inline u8 *writePixel(u8 *at, u32 pixel) {
+	memcpy(at, &pixel, sizeof(pixel));
+	return at + sizeof(pixel);
+}
+
+// Greedy, over the tile's pixels in row order: unchanged pixels are skipped,
+// two or more of the same color are a fill, and anything else is gathered
+// into a literal until the next skip or fill would start. keyframe treats
+// every pixel as changed.
+static u8 *encodeTilePixels(u32 *current, u32 *previous, u32 count, bool keyframe, u8 *at) {
+	u32 i = 0;
+	while(i < count) {
+		u32 limit = (count - i < Stream_Max_Run) ? (count - i) : Stream_Max_Run;
+
+		if(!keyframe && current[i] == previous[i]) {
+			u32 run = 1;
+			while(run < limit && current[i + run] == previous[i + run]) {
+				++run;
+			}
+			at = writeRun(at, StreamSkip, run);
+			i += run;
+			continue;
+		}
+
+		u32 run = 1;
+		while(run < limit && current[i + run] == current[i]) {
+			++run;
+		}
+		if(run >= 2) {
+			at = writeRun(at, StreamFill, run);
+			at = writePixel(at, current[i]);
+			i += run;
+			continue;
+		}
+
+		u32 literal = 1;
+		while(literal < limit &&
+		      (keyframe || current[i + literal] != previous[i + literal]) &&
+		      (literal + 1 >= limit || current[i + literal + 1] != current[i + literal])) {
+			++literal;
+		}
+		at = writeRun(at, StreamLiteral, literal);
+		memcpy(at, current + i, literal*sizeof(u32));
+		at += literal*sizeof(u32);
+		i += literal;
+	}
+	return at;
+}
+
+// Writes frame, which must be the encoder's size, to output (room for
+// streamMaxFrameBytes) and returns the bytes written. Every changed tile is
+// also copied into the encoder's previous frame.
+u32 encodeFrame(frame_encoder *encoder, pixel_image *frame, u8 *output) {
+	assert((u32)frame->width == encoder->width && (u32)frame->height == encoder->height);
+	bool keyframe = encoder->sendKeyframe;
+	encoder->sendKeyframe = false;
+
+	u8 *at = output + sizeof(stream_frame_header);
+	u32 tileCount = 0;
+
+	u32 tileCurrent[Stream_Tile_Size*Stream_Tile_Size];
+	u32 tilePrevious[Stream_Tile_Size*Stream_Tile_Size];
+	for(u32 tileY=0; tileY < encoder->tilesY; ++tileY) {
+		u32 minY = tileY*Stream_Tile_Size;
+		u32 height = (encoder->height - minY < Stream_Tile_Size) ? (encoder->height - minY) : Stream_Tile_Size;
+		for(u32 tileX=0; tileX < encoder->tilesX; ++tileX) {
+			u32 minX = tileX*Stream_Tile_Size;
+			u32 width = (encoder->width - minX < Stream_Tile_Size) ? (encoder->width - minX) : Stream_Tile_Size;
+
+			u32 *current = (u32 *)((u8 *)frame->memory + minY*frame->pitch) + minX;
+			u32 *previous = encoder->previous + minY*encoder->width + minX;
+			if(!keyframe && !tileChanged(current, frame->pitch, previous, encoder->width, width, height)) {
+				continue;
+			}
+
+			// Gathered into one run of pixels, so runs carry on across rows,
+			// and the new pixels become what the decoders have.
+			u32 *row = current;
+			for(u32 y=0; y < height; ++y) {
+				memcpy(tileCurrent + y*width, row, width*sizeof(u32));
+				memcpy(tilePrevious + y*width, previous + y*encoder->width, width*sizeof(u32));
+				memcpy(previous + y*encoder->width, row, width*sizeof(u32));
+				row = (u32 *)((u8 *)row + frame->pitch);
+			}
+
+			u16 tileIndex = (u16)(tileY*encoder->tilesX + tileX);
+			u8 *runs = at + 4;
+			u8 *end = encodeTilePixels(tileCurrent, tilePrevious, width*height, keyframe, runs);
+			u16 runBytes = (u16)(end - runs);
+			memcpy(at, &tileIndex, sizeof(tileIndex));
+			memcpy(at + 2, &runBytes, sizeof(runBytes));
+			at = end;
+			++tileCount;
+		}
+	}
+
+	stream_frame_header header;
+	header.size = (u32)(at - output);
+	header.width = (u16)encoder->width;
+	header.height = (u16)encoder->height;
+	header.tileCount = (u16)tileCount;
+	header.flags = keyframe ? Stream_Keyframe : 0;
+	memcpy(output, &header, sizeof(header));
+
+	encoder->changedTiles = tileCount;
+	return header.size;
+}
+
+void initFrameDecoder(frame_decoder *decoder, memory_arena *arena, u32 width, u32 height) {
+	decoder->image.width = (s32)width;
+	decoder->image.height = (s32)height;
+	decoder->image.pitch = (s32)(width*sizeof(u32));
+	decoder->image.memory = pushArray(arena, width*height, u32);
+	decoder->tilesX = (width + Stream_Tile_Size - 1) / Stream_Tile_Size;
+	decoder->tilesY = (height + Stream_Tile_Size - 1) / Stream_Tile_Size;
+	decoder->haveKeyframe = false;
+}
+
+// Applies one tile's runs. false if they don't cover the tile exactly or run
+// past end.
+static bool decodeTile(u8 *at, u8 *end, u32 *tile, u32 pitch, u32 width, u32 height) {
+	u32 x = 0;
+	u32 y = 0;
+	while(at < end) {
+		u32 op = *at & 0xC0;
+		u32 count = (*at & 0x3F) + 1;
+		++at;
+
+		u8 *pixels = at;
+		if(op == StreamFill) {
+			at += sizeof(u32);
+		}
+		else if(op == StreamLiteral) {
+			at += count*sizeof(u32);
+		}
+		else if(op != StreamSkip) {
+			return false;
+		}
+		if(at > end || y >= height || count > (height - y)*width - x) {
+			return false;
+		}
+
+		u32 fill = 0;
+		if(op == StreamFill) {
+			memcpy(&fill, pixels, sizeof(fill));
+		}
+		while(count) {
+			u32 span = (width - x < count) ? (width - x) : count;
+			u32 *to = tile + y*pitch + x;
+			if(op == StreamFill) {
+				for(u32 i=0; i < span; ++i) {
+					to[i] = fill;
+				}
+			}
+			else if(op == StreamLiteral) {
+				memcpy(to, pixels, span*sizeof(u32));
+				pixels += span*sizeof(u32);
+			}
+
+			count -= span;
+			x += span;
+			if(x == width) {
+				x = 0;
+				++y;
+			}
+		}
+	}
+	return (y == height && x == 0);
+}
+
+// Applies an encoded frame to decoder->image. Anything malformed, or a delta
+// before the first keyframe, is rejected with false; the image may have been
+// partly updated by then and needs a keyframe to be trusted again.
+bool decodeFrame(frame_decoder *decoder, u8 *data, u32 size) {
+	stream_frame_header header;
+	if(size < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if(header.size != size || header.width != (u32)decoder->image.width ||
+	   header.height != (u32)decoder->image.height) {
+		return false;
+	}
+	if(!(header.flags & Stream_Keyframe) && !decoder->haveKeyframe) {
+		return false;
+	}
+
+	u8 *at = data + sizeof(header);
+	u8 *end = data + size;
+	u32 tileTotal = decoder->tilesX*decoder->tilesY;
+	u32 *pixels = (u32 *)decoder->image.memory;
+	u32 imageWidth = (u32)decoder->image.width;
+	u32 imageHeight = (u32)decoder->image.height;
+	for(u32 i=0; i < header.tileCount; ++i) {
+		u16 tileIndex, runBytes;
+		if(end - at < 4) {
+			decoder->haveKeyframe = false;
+			return false;
+		}
+		memcpy(&tileIndex, at, sizeof(tileIndex));
+		memcpy(&runBytes, at + 2, sizeof(runBytes));
+		at += 4;
+		if(tileIndex >= tileTotal || runBytes > end - at) {
+			decoder->haveKeyframe = false;
+			return false;
+		}
+
+		u32 minX = (tileIndex % decoder->tilesX)*Stream_Tile_Size;
+		u32 minY = (tileIndex / decoder->tilesX)*Stream_Tile_Size;
+		u32 width = (imageWidth - minX < Stream_Tile_Size) ? (imageWidth - minX) : Stream_Tile_Size;
+		u32 height = (imageHeight - minY < Stream_Tile_Size) ? (imageHeight - minY) : Stream_Tile_Size;
+		if(!decodeTile(at, at + runBytes, pixels + minY*imageWidth + minX, imageWidth, width, height)) {
+			decoder->haveKeyframe = false;
+			return false;
+		}
+		at += runBytes;
+	}
+
+	if(header.flags & Stream_Keyframe) {
+		decoder->haveKeyframe = true;
+	}
+	return (at == end);
+}
@@ -0,0 +1,75 @@
+#ifndef PONG_STREAM_H
+#define PONG_STREAM_H
+
+// Frame codec for streaming the software renderer's output to spectators.
+// Each frame is compared with the last one in square tiles; only tiles that
+// changed are sent, each as a run-length coded list of what happened to its
+// pixels in row order: skipped (unchanged), filled with one color, or given
+// literally. A Pong frame is a few moving rectangles on black, so most
+// frames are a handful of tiles and a few hundred bytes.
+//
+// An encoded frame:
+//   stream_frame_header
+//   per changed tile: u16 tile index, u16 bytes of runs, the runs
+// A run is one op byte, the op in the top two bits and the pixel count - 1
+// in the low six, followed by one pixel (fill), count pixels (literal) or
+// nothing (skip). Pixels are the frame's own 32-bit values, little endian.
+
+#include "pong_scale.h"
+
+#define Stream_Tile_Size 32
+#define Stream_Max_Run 64
+
+enum stream_op {
+	StreamSkip = 0x00,
+	StreamFill = 0x40,
+	StreamLiteral = 0x80,
+};
+
+// A keyframe sends every tile with no skips, so it decodes without any
+// previous frame; the first frame is always one.
+#define Stream_Keyframe 0x1
+
+// size counts the header and everything after it.
+struct stream_frame_header {
+	u32 size;
+	u16 width;
+	u16 height;
+	u16 tileCount;
+	u16 flags;
+};
+static_assert(sizeof(stream_frame_header) == 12, "stream_frame_header is sent as is; it can't have padding");
+
+// Most a tile's runs can take: all literal, one op byte per Stream_Max_Run
+// pixels.
+#define streamMaxTileBytes ((Stream_Tile_Size*Stream_Tile_Size/Stream_Max_Run)*(1 + 4*Stream_Max_Run))
+
+// Output room encodeFrame() needs for a frame this size
+#define streamMaxFrameBytes(width, height) \
+	(sizeof(stream_frame_header) + \
+	 (((width) + Stream_Tile_Size - 1)/Stream_Tile_Size)*(((height) + Stream_Tile_Size - 1)/Stream_Tile_Size)* \
+	 (4 + streamMaxTileBytes))
+
+struct frame_encoder {
+	u32 width;
+	u32 height;
+	u32 tilesX;
+	u32 tilesY;
+
+	// What the decoders have: the last frame sent, packed (pitch width*4)
+	u32 *previous;
+	bool sendKeyframe;
+
+	// From the last encodeFrame()
+	u32 changedTiles;
+};
+
+struct frame_decoder {
+	// Packed, and updated in place by each frame decoded
+	pixel_image image;
+	u32 tilesX;
+	u32 tilesY;
+	bool haveKeyframe;
+};
+
+#endif
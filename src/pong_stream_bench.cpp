@@ -0,0 +1,146 @@
+// Size and speed of the spectator stream codec over real frames: a match
+// between two bots, drawn by the software renderer every tick, encoded
+// against the frame before and decoded again. Every decoded frame is
+// checked against what was drawn.
+//
+//   pong_stream_bench [frames]
+
+#include "pong_game.h"
+#include "pong_host.h"
+#include "pong_draw.h"
+#include "pong_stream.h"
+#include "pong_bench.h"
+#include "pong_game.cpp"
+#include "pong_particles.cpp"
+#include "pong_scale.cpp"
+#include "pong_sprite.cpp"
+#include "pong_draw.cpp"
+#include "pong_stream.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct stream_case {
+	s32 width, height;
+	u32 balls;
+};
+
+int main(int argc, char **argv) {
+	u32 frames = (argc > 1) ? (u32)atoi(argv[1]) : 600;
+	if(frames == 0) {
+		frames = 1;
+	}
+
+	stream_case cases[] = {
+		{1280, 720, 0},
+		{1920, 1080, 0},
+		{1280, 720, 64},
+		{1280, 720, 1024},
+	};
+
+	printf("%10s %6s %9s %9s %9s %7s %9s %9s %6s\n", "SIZE", "BALLS", "KEY KB", "AVG B", "MAX B",
+	       "TILES", "ENC FPS", "DEC FPS", "OK");
+	for(u32 c=0; c < arrayCount(cases); ++c) {
+		stream_case *test = cases + c;
+		size_t arenaSize = megabytes(64) + 3*(size_t)test->width*test->height*sizeof(u32);
+		memory_arena arena;
+		initArena(&arena, calloc(1, arenaSize), arenaSize);
+
+		game_state gameState = {};
+		initGameState(&gameState, globalArenaPresets + ArenaStandard);
+		bot_state bots[2];
+		initBot(bots + 0, globalBotDifficulties[1], 0x1234567);
+		initBot(bots + 1, globalBotDifficulties[1], 0x1234568);
+
+		ball_pool balls = {};
+		if(test->balls) {
+			initBallPool(&balls, &arena, test->balls, ballPoolSize(test->balls, &gameState),
+			             gameState.arenaWidth, gameState.arenaHeight);
+			spawnBalls(&balls, test->balls, gameState.arenaWidth, gameState.arenaHeight, 0x5EED);
+		}
+
+		pixel_image image;
+		image.width = test->width;
+		image.height = test->height;
+		image.pitch = Align16(test->width*4);
+		image.memory = pushSize(&arena, (size_t)image.pitch*image.height);
+
+		frame_encoder encoder;
+		frame_decoder decoder;
+		initFrameEncoder(&encoder, &arena, test->width, test->height);
+		initFrameDecoder(&decoder, &arena, test->width, test->height);
+		u32 maxBytes = (u32)streamMaxFrameBytes(test->width, test->height);
+		u8 *encoded = (u8 *)malloc(maxBytes);
+
+		double encodeSeconds = 0.0;
+		double decodeSeconds = 0.0;
+		u32 keyframeBytes = 0;
+		u64 deltaBytes = 0;
+		u32 largestDelta = 0;
+		u64 changedTiles = 0;
+		bool matched = true;
+
+		float dt = 1.0f / Simulation_Hz;
+		for(u32 frame=0; frame < frames; ++frame) {
+			for(u32 player=0; player < 2; ++player) {
+				botDecide(bots + player, &gameState, player, dt);
+			}
+			update(&gameState, dt);
+			if(test->balls) {
+				updateBallPool(&balls, &gameState, dt);
+			}
+
+			render_snapshot snapshot = {};
+			snapshot.arenaWidth = gameState.arenaWidth;
+			snapshot.arenaHeight = gameState.arenaHeight;
+			snapshot.players[0] = gameState.players[0];
+			snapshot.players[1] = gameState.players[1];
+			snapshot.ball = gameState.ball;
+			snapshot.poolCount = balls.count;
+			snapshot.poolSize = balls.size;
+			snapshot.poolX = balls.x;
+			snapshot.poolY = balls.y;
+			snapshot.poolPrevX = balls.prevX;
+			snapshot.poolPrevY = balls.prevY;
+			drawSceneSoftware(&snapshot, 0, 0, &image, 1.0f);
+
+			double start = benchSeconds();
+			u32 size = encodeFrame(&encoder, &image, encoded);
+			double encodeEnd = benchSeconds();
+			bool decoded = decodeFrame(&decoder, encoded, size);
+			double end = benchSeconds();
+
+			encodeSeconds += encodeEnd - start;
+			decodeSeconds += end - encodeEnd;
+			if(frame == 0) {
+				keyframeBytes = size;
+			}
+			else {
+				deltaBytes += size;
+				changedTiles += encoder.changedTiles;
+				if(size > largestDelta) {
+					largestDelta = size;
+				}
+			}
+
+			for(s32 y=0; y < image.height && matched; ++y) {
+				matched = decoded &&
+					(memcmp((u8 *)image.memory + y*image.pitch, (u8 *)decoder.image.memory + y*decoder.image.pitch,
+					        image.width*sizeof(u32)) == 0);
+			}
+		}
+
+		u32 deltas = (frames > 1) ? (frames - 1) : 1;
+		char size[32];
+		sprintf(size, "%dx%d", test->width, test->height);
+		printf("%10s %6u %9.1f %9.0f %9u %7.1f %9.0f %9.0f %6s\n", size, test->balls,
+		       keyframeBytes / 1024.0, (double)deltaBytes / deltas, largestDelta,
+		       (double)changedTiles / deltas, frames / encodeSeconds, frames / decodeSeconds,
+		       matched ? "yes" : "NO");
+
+		free(encoded);
+		free(arena.base);
+	}
+
+	return 0;
+}
@@ -0,0 +1,242 @@
+#include <emmintrin.h>
+
+// Rows top to bottom, bit 4 is the leftmost pixel.
+static u8 globalGlyphBitmaps[Glyph_Count][Glyph_Height] = {
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+	{0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, // '!'
+	{0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"'
+	{0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A}, // '#'
+	{0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04}, // '$'
+	{0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, // '%'
+	{0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D}, // '&'
+	{0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00}, // '''
+	{0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, // '('
+	{0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, // ')'
+	{0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00}, // '*'
+	{0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}, // '+'
+	{0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}, // ','
+	{0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // '-'
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // '.'
+	{0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // '/'
+	{0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // '0'
+	{0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // '1'
+	{0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // '2'
+	{0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // '3'
+	{0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // '4'
+	{0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // '5'
+	{0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // '6'
+	{0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // '7'
+	{0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // '8'
+	{0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // '9'
+	{0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // ':'
+	{0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08}, // ';'
+	{0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}, // '<'
+	{0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}, // '='
+	{0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}, // '>'
+	{0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}, // '?'
+	{0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E}, // '@'
+	{0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'A'
+	{0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // 'B'
+	{0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // 'C'
+	{0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // 'D'
+	{0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // 'E'
+	{0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // 'F'
+	{0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // 'G'
+	{0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'H'
+	{0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 'I'
+	{0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // 'J'
+	{0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // 'K'
+	{0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // 'L'
+	{0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // 'M'
+	{0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // 'N'
+	{0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'O'
+	{0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // 'P'
+	{0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // 'Q'
+	{0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // 'R'
+	{0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // 'S'
+	{0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // 'T'
+	{0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'U'
+	{0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // 'V'
+	{0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // 'W'
+	{0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // 'X'
+	{0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04}, // 'Y'
+	{0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // 'Z'
+	{0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E}, // '['
+	{0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00}, // '\'
+	{0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E}, // ']'
+	{0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00}, // '^'
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F}, // '_'
+};
+
+void initGlyphAtlas(glyph_atlas *atlas, memory_arena *arena) {
+	atlas->pitch = Glyph_Atlas_Width;
+	atlas->mask = pushArray(arena, Glyph_Atlas_Width * Glyph_Atlas_Height, u32);
+
+	for(int glyph=0; glyph < Glyph_Count; ++glyph) {
+		int cellX = (glyph % Glyph_Atlas_Columns) * Glyph_Cell_Width;
+		int cellY = (glyph / Glyph_Atlas_Columns) * Glyph_Cell_Height;
+
+		for(int y=0; y < Glyph_Height * Glyph_Scale; ++y) {
+			u8 bits = globalGlyphBitmaps[glyph][y / Glyph_Scale];
+			u32 *pixel = atlas->mask + (cellY + y)*atlas->pitch + cellX;
+
+			for(int x=0; x < Glyph_Width * Glyph_Scale; ++x) {
+				bool set = ((bits >> (Glyph_Width - 1 - (x / Glyph_Scale))) & 1) != 0;
+				pixel[x] = set ? 0xFFFFFFFF : 0;
+			}
+		}
+	}
+}
+
+// Only needed by the OpenGL path; the software path reads atlas->mask directly.
+void uploadGlyphAtlas(glyph_atlas *atlas) {
+	static u8 alpha[Glyph_Atlas_Width * Glyph_Atlas_Height];
+	for(int i=0; i < Glyph_Atlas_Width * Glyph_Atlas_Height; ++i) {
+		alpha[i] = (u8)atlas->mask[i];
+	}
+
+	glGenTextures(1, &atlas->texture);
+	glBindTexture(GL_TEXTURE_2D, atlas->texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, Glyph_Atlas_Width, Glyph_Atlas_Height, 0,
+	             GL_ALPHA, GL_UNSIGNED_BYTE, alpha);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+inline int textWidth(const char *text) {
+	int result = 0;
+	while(*text++) {
+		result += Glyph_Cell_Width;
+	}
+	return result;
+}
+
+// Colors are 0xAARRGGBB, same as the software framebuffer.
+void pushText(text_batch *batch, int x, int y, const char *text, u32 color) {
+	for(const char *at = text; *at; ++at) {
+		u32 c = (u8)*at;
+		if(c >= 'a' && c <= 'z') {
+			c -= 'a' - 'A';
+		}
+
+		if(c > Glyph_First && c < Glyph_First + Glyph_Count && batch->count < Max_Glyphs_Per_Frame) {
+			glyph_quad *quad = batch->glyphs + batch->count++;
+			quad->x = x;
+			quad->y = y;
+			quad->glyph = c - Glyph_First;
+			quad->color = color;
+		}
+
+		x += Glyph_Cell_Width;
+	}
+}
+
+void flushTextGL(text_batch *batch) {
+	if(batch->count == 0) {
+		return;
+	}
+
+	float du = (float)Glyph_Cell_Width / (float)Glyph_Atlas_Width;
+	float dv = (float)Glyph_Cell_Height / (float)Glyph_Atlas_Height;
+
+	text_vertex *vertex = batch->vertices;
+	for(u32 i=0; i < batch->count; ++i) {
+		glyph_quad *quad = batch->glyphs + i;
+
+		float x0 = (float)quad->x;
+		float y0 = (float)quad->y;
+		float x1 = x0 + Glyph_Cell_Width;
+		float y1 = y0 + Glyph_Cell_Height;
+		float u0 = (float)(quad->glyph % Glyph_Atlas_Columns) * du;
+		float v0 = (float)(quad->glyph / Glyph_Atlas_Columns) * dv;
+		float u1 = u0 + du;
+		float v1 = v0 + dv;
+
+		u8 r = (u8)(quad->color >> 16);
+		u8 g = (u8)(quad->color >> 8);
+		u8 b = (u8)(quad->color >> 0);
+		u8 a = (u8)(quad->color >> 24);
+
+		text_vertex corners[4] = {
+			{x0, y0, u0, v0, r, g, b, a},
+			{x1, y0, u1, v0, r, g, b, a},
+			{x1, y1, u1, v1, r, g, b, a},
+			{x0, y1, u0, v1, r, g, b, a},
+		};
+		for(int c=0; c < 4; ++c) {
+			*vertex++ = corners[c];
+		}
+	}
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, batch->atlas->texture);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(text_vertex), &batch->vertices[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(text_vertex), &batch->vertices[0].u);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(text_vertex), &batch->vertices[0].r);
+
+	glDrawArrays(GL_QUADS, 0, 4 * batch->count);
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisable(GL_TEXTURE_2D);
+
+	batch->count = 0;
+}
+
+// Glyph cells are a multiple of 4 pixels wide, so a fully visible glyph row is
+// a handful of 4-wide mask selects. Glyphs hanging off the buffer edge take
+// the clipped scalar path.
+void flushTextSoftware(text_batch *batch, offscreen_buffer *buffer) {
+	glyph_atlas *atlas = batch->atlas;
+	rectangle2i bounds = Rect(0, 0, buffer->width, buffer->height);
+
+	for(u32 i=0; i < batch->count; ++i) {
+		glyph_quad *quad = batch->glyphs + i;
+		rectangle2i dest = Rect(quad->x, quad->y, quad->x + Glyph_Cell_Width, quad->y + Glyph_Cell_Height);
+		rectangle2i clip = clipRect(dest, bounds);
+		if(clip.minX >= clip.maxX || clip.minY >= clip.maxY) {
+			continue;
+		}
+
+		u32 *maskRow = atlas->mask +
+			((quad->glyph / Glyph_Atlas_Columns) * Glyph_Cell_Height + (clip.minY - dest.minY))*atlas->pitch +
+			((quad->glyph % Glyph_Atlas_Columns) * Glyph_Cell_Width + (clip.minX - dest.minX));
+		u8 *row = ((u8 *)buffer->memory + clip.minX*buffer->bytesPerPixel + clip.minY*buffer->pitch);
+
+		if(clip.minX == dest.minX && clip.maxX == dest.maxX) {
+			__m128i color = _mm_set1_epi32((int)quad->color);
+			for(int y=clip.minY; y < clip.maxY; ++y) {
+				for(int x=0; x < Glyph_Cell_Width; x += 4) {
+					__m128i mask = _mm_loadu_si128((__m128i *)(maskRow + x));
+					__m128i *pixel = (__m128i *)((u32 *)row + x);
+					__m128i dst = _mm_loadu_si128(pixel);
+					_mm_storeu_si128(pixel, _mm_or_si128(_mm_and_si128(mask, color), _mm_andnot_si128(mask, dst)));
+				}
+				maskRow += atlas->pitch;
+				row += buffer->pitch;
+			}
+		}
+		else {
+			for(int y=clip.minY; y < clip.maxY; ++y) {
+				u32 *pixel = (u32 *)row;
+				for(int x=0; x < clip.maxX - clip.minX; ++x) {
+					pixel[x] = (maskRow[x] & quad->color) | (~maskRow[x] & pixel[x]);
+				}
+				maskRow += atlas->pitch;
+				row += buffer->pitch;
+			}
+		}
+	}
+
+	batch->count = 0;
+}
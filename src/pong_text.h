@@ -0,0 +1,52 @@
+#ifndef PONG_TEXT_H
+#define PONG_TEXT_H
+
+// Glyphs are 5x7 bitmaps, pre-rasterized once into an atlas at Glyph_Scale
+// with one scaled pixel of spacing on the right and bottom of each cell.
+#define Glyph_Width 5
+#define Glyph_Height 7
+#define Glyph_Scale 2
+#define Glyph_Cell_Width ((Glyph_Width + 1) * Glyph_Scale)
+#define Glyph_Cell_Height ((Glyph_Height + 1) * Glyph_Scale)
+
+// The atlas covers ASCII ' ' through '_'; lowercase is drawn as uppercase.
+#define Glyph_First ' '
+#define Glyph_Count 64
+#define Glyph_Atlas_Columns 16
+#define Glyph_Atlas_Width (Glyph_Atlas_Columns * Glyph_Cell_Width)
+#define Glyph_Atlas_Height ((Glyph_Count / Glyph_Atlas_Columns) * Glyph_Cell_Height)
+
+#define Max_Glyphs_Per_Frame 1024
+
+struct glyph_atlas {
+	// One u32 per pixel, either 0 or 0xFFFFFFFF, so the software blit can use
+	// it directly as a select mask.
+	u32 *mask;
+	int pitch;
+
+	GLuint texture;
+};
+
+struct glyph_quad {
+	int x, y;
+	u32 glyph;
+	u32 color;
+};
+
+struct text_vertex {
+	float x, y;
+	float u, v;
+	u8 r, g, b, a;
+};
+
+// Every piece of text drawn in a frame is collected here and submitted in
+// one go at the end of the frame.
+struct text_batch {
+	glyph_atlas *atlas;
+
+	u32 count;
+	glyph_quad glyphs[Max_Glyphs_Per_Frame];
+	text_vertex vertices[4 * Max_Glyphs_Per_Frame];
+};
+
+#endif
@@ -0,0 +1,142 @@
+#if defined(_WIN32)
+static void initSemaphore(platform_semaphore *semaphore, u32 maxCount) {
+	*semaphore = CreateSemaphoreEx(0, 0, maxCount, 0, 0, SEMAPHORE_ALL_ACCESS);
+}
+
+inline void signalSemaphore(platform_semaphore *semaphore) {
+	ReleaseSemaphore(*semaphore, 1, 0);
+}
+
+inline void waitSemaphore(platform_semaphore *semaphore) {
+	WaitForSingleObjectEx(*semaphore, INFINITE, FALSE);
+}
+
+u32 getCoreCount() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+}
+#else
+#include <unistd.h>
+
+static void initSemaphore(platform_semaphore *semaphore, u32 maxCount) {
+	sem_init(semaphore, 0, 0);
+}
+
+inline void signalSemaphore(platform_semaphore *semaphore) {
+	sem_post(semaphore);
+}
+
+inline void waitSemaphore(platform_semaphore *semaphore) {
+	while(sem_wait(semaphore) != 0) {
+	}
+}
+
+u32 getCoreCount() {
+	return (u32)sysconf(_SC_NPROCESSORS_ONLN);
+}
+#endif
+
+void addWorkEntry(work_queue *queue, work_queue_callback *callback, void *data) {
+	u32 nextEntryToWrite = queue->nextEntryToWrite;
+	u32 newNextEntryToWrite = (nextEntryToWrite + 1) % Max_Work_Entries;
+	assert(newNextEntryToWrite != atomicLoadU32(&queue->nextEntryToRead));
+
+	work_queue_entry *entry = queue->entries + nextEntryToWrite;
+	entry->callback = callback;
+	entry->data = data;
+	++queue->completionGoal;
+
+	atomicStoreU32(&queue->nextEntryToWrite, newNextEntryToWrite);
+	signalSemaphore(&queue->semaphore);
+}
+
+// Returns true if there was nothing to do.
+static bool doNextWorkEntry(work_queue *queue) {
+	bool shouldSleep = false;
+
+	u32 originalNextEntryToRead = atomicLoadU32(&queue->nextEntryToRead);
+	u32 newNextEntryToRead = (originalNextEntryToRead + 1) % Max_Work_Entries;
+	if(originalNextEntryToRead != atomicLoadU32(&queue->nextEntryToWrite)) {
+		u32 index = atomicCompareExchangeU32(&queue->nextEntryToRead, newNextEntryToRead, originalNextEntryToRead);
+		if(index == originalNextEntryToRead) {
+			work_queue_entry entry = queue->entries[index];
+			entry.callback(queue, entry.data);
+			atomicAddU32(&queue->completionCount, 1);
+		}
+	}
+	else {
+		shouldSleep = true;
+	}
+
+	return shouldSleep;
+}
+
+inline bool isWorkComplete(work_queue *queue) {
+	bool result = (atomicLoadU32(&queue->completionCount) == queue->completionGoal);
+	return result;
+}
+
+// The calling thread helps out until everything queued so far is done.
+void completeAllWork(work_queue *queue) {
+	while(!isWorkComplete(queue)) {
+		doNextWorkEntry(queue);
+	}
+}
+
+static THREAD_PROC(workerThreadProc) {
+	work_queue *queue = (work_queue *)parameter;
+	for(;;) {
+		if(doNextWorkEntry(queue)) {
+			waitSemaphore(&queue->semaphore);
+		}
+	}
+}
+
+// Workers run for the life of the process.
+void initWorkQueue(work_queue *queue, u32 threadCount) {
+	if(threadCount > Max_Worker_Threads) {
+		threadCount = Max_Worker_Threads;
+	}
+
+	queue->completionGoal = 0;
+	queue->completionCount = 0;
+	queue->nextEntryToWrite = 0;
+	queue->nextEntryToRead = 0;
+	queue->threadCount = threadCount;
+	initSemaphore(&queue->semaphore, threadCount ? threadCount : 1);
+
+	for(u32 i=0; i < threadCount; ++i) {
+#if defined(_WIN32)
+		HANDLE thread = CreateThread(0, 0, workerThreadProc, queue, 0, 0);
+		CloseHandle(thread);
+#else
+		pthread_t thread;
+		pthread_create(&thread, 0, workerThreadProc, queue);
+		pthread_detach(thread);
+#endif
+	}
+}
+
+// A thread other than the workers, for something that has to be waited on
+// when it's done (unlike the workers, which never finish).
+#if defined(_WIN32)
+platform_thread startThread(LPTHREAD_START_ROUTINE proc, void *data) {
+	return CreateThread(0, 0, proc, data, 0, 0);
+}
+
+void joinThread(platform_thread thread) {
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+#else
+platform_thread startThread(void *(*proc)(void *), void *data) {
+	pthread_t thread;
+	pthread_create(&thread, 0, proc, data);
+	return thread;
+}
+
+void joinThread(platform_thread thread) {
+	pthread_join(thread, 0);
+}
+#endif
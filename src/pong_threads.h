@@ -0,0 +1,45 @@
+#ifndef PONG_THREADS_H
+#define PONG_THREADS_H
+
+// A fixed pool of worker threads pulling callbacks off a circular queue.
+// One thread adds work; any number of workers (and optionally the adding
+// thread itself) take it.
+
+#if defined(_WIN32)
+typedef void *platform_semaphore;
+typedef void *platform_thread;
+#define THREAD_PROC(name) DWORD WINAPI name(LPVOID parameter)
+#else
+#include <pthread.h>
+#include <semaphore.h>
+typedef sem_t platform_semaphore;
+typedef pthread_t platform_thread;
+#define THREAD_PROC(name) void *name(void *parameter)
+#endif
+
+#define Max_Work_Entries 256
+#define Max_Worker_Threads 64
+
+struct work_queue;
+typedef void work_queue_callback(work_queue *queue, void *data);
+
+struct work_queue_entry {
+	work_queue_callback *callback;
+	void *data;
+};
+
+struct work_queue {
+	// Both only ever increase; work is done when they're equal.
+	u32 volatile completionGoal;
+	u32 volatile completionCount;
+
+	u32 volatile nextEntryToWrite;
+	u32 volatile nextEntryToRead;
+
+	platform_semaphore semaphore;
+	u32 threadCount;
+
+	work_queue_entry entries[Max_Work_Entries];
+};
+
+#endif
@@ -0,0 +1,555 @@
+// Plays bot configurations against each other headless, on every core, and
+// estimates their Elo ratings.
+//
+//   pong_tournament [options] [bot ...]
+//
+//   -matches N    total matches to play (default 100000)
+//   -swiss R      play R Swiss rounds instead of a full round robin
+//   -points N     points needed to win a match (default 3)
+//   -threads N    worker threads (default: one per core)
+//   -seed N       base seed; the same seed replays the same tournament
+//   -out FILE     results file (default tournament.ptr)
+//
+// A bot is a preset name (easy, medium, hard, perfect) or
+// reactionTicks:noise:deadZone. With no bots given, ten are spread evenly
+// between easy and hard.
+//
+// Results file, all little-endian: a tournament_file_header, one
+// tournament_file_bot per bot, then any number of chunks. Each chunk is a
+// u32 row count followed by that many rows of each column in turn:
+//   u16 round, u16 left bot, u16 right bot, u8 left score, u8 right score,
+//   u32 ticks, u32 seed
+// so a reader can pull out one column without touching the others.
+
+#if defined(_WIN32)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "pong_game.h"
+#include "pong_threads.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+#include "pong_game.cpp"
+#include "pong_threads.cpp"
+#include "pong_bench.h"
+
+#define Max_Tournament_Bots 64
+#define Matches_Per_Job 256
+
+// Jobs are written out in the order they were queued, so only this many can
+// be outstanding; it has to fit in the work queue.
+#define Max_Jobs_In_Flight 128
+
+// A match nobody has won after this long is a draw.
+#define Max_Match_Ticks (Simulation_Hz * 60 * 5)
+
+#define Tournament_File_Version 1
+
+struct tournament_file_header {
+	char magic[4];
+	u32 version;
+	u32 botCount;
+	u32 pointsToWin;
+	u64 seed;
+};
+
+struct tournament_file_bot {
+	char name[32];
+	u32 reactionTicks;
+	float noise;
+	float deadZone;
+};
+
+struct tournament_bot {
+	char name[32];
+	bot_difficulty difficulty;
+};
+
+struct tournament;
+
+struct match_job {
+	tournament *owner;
+	u16 round;
+	u16 bots[2];
+	u32 count;
+	u64 seed;
+
+	u32 volatile done;
+
+	// One chunk of the results file
+	u16 roundColumn[Matches_Per_Job];
+	u16 leftColumn[Matches_Per_Job];
+	u16 rightColumn[Matches_Per_Job];
+	u8 leftScoreColumn[Matches_Per_Job];
+	u8 rightScoreColumn[Matches_Per_Job];
+	u32 ticksColumn[Matches_Per_Job];
+	u32 seedColumn[Matches_Per_Job];
+};
+
+struct tournament {
+	work_queue *queue;
+	FILE *file;
+
+	u32 botCount;
+	tournament_bot bots[Max_Tournament_Bots];
+	u32 pointsToWin;
+	u64 seed;
+
+	// Score is 1 per win and 0.5 per draw, from the row bot's point of view.
+	double score[Max_Tournament_Bots][Max_Tournament_Bots];
+	u32 games[Max_Tournament_Bots][Max_Tournament_Bots];
+	bool met[Max_Tournament_Bots][Max_Tournament_Bots];
+
+	match_job jobs[Max_Jobs_In_Flight];
+	u32 jobsQueued;
+	u32 jobsWritten;
+
+	u64 matches;
+	u64 ticks;
+};
+
+#if defined(_WIN32)
+inline void yieldThread() {
+	Sleep(0);
+}
+#else
+inline void yieldThread() {
+	sched_yield();
+}
+#endif
+
+// Plays one match to pointsToWin and returns the number of ticks it took.
+static u32 playMatch(tournament_bot *left, tournament_bot *right, u32 pointsToWin, u64 seed, u32 *scores) {
+	game_state gameState = {};
+	initGameState(&gameState, globalArenaPresets + ArenaStandard);
+
+	u32 random = (u32)mixSeed(seed);
+	random = random ? random : 1;
+	serveBall(&gameState, (random & 1) ? 1.0f : -1.0f);
+
+	bot_state bots[2];
+	initBot(bots + 0, left->difficulty, nextRandom(&random));
+	initBot(bots + 1, right->difficulty, nextRandom(&random));
+
+	float dt = 1.0f / Simulation_Hz;
+	u32 tick = 0;
+	while(tick < Max_Match_Ticks &&
+	      gameState.players[0].score < pointsToWin && gameState.players[1].score < pointsToWin) {
+		botDecide(bots + 0, &gameState, 0, dt);
+		botDecide(bots + 1, &gameState, 1, dt);
+		update(&gameState, dt);
+		++tick;
+	}
+
+	scores[0] = gameState.players[0].score;
+	scores[1] = gameState.players[1].score;
+	return tick;
+}
+
+static void runMatchJob(work_queue *queue, void *data) {
+	match_job *job = (match_job *)data;
+	tournament *t = job->owner;
+
+	for(u32 i=0; i < job->count; ++i) {
+		// Sides alternate so neither bot keeps the advantage of the ball
+		// accelerating towards the right.
+		u32 side = i & 1;
+		u16 left = job->bots[side];
+		u16 right = job->bots[side ^ 1];
+		u64 seed = mixSeed(job->seed + i);
+
+		u32 scores[2];
+		u32 ticks = playMatch(t->bots + left, t->bots + right, t->pointsToWin, seed, scores);
+
+		job->roundColumn[i] = job->round;
+		job->leftColumn[i] = left;
+		job->rightColumn[i] = right;
+		job->leftScoreColumn[i] = (u8)scores[0];
+		job->rightScoreColumn[i] = (u8)scores[1];
+		job->ticksColumn[i] = ticks;
+		job->seedColumn[i] = (u32)seed;
+	}
+
+	atomicStoreU32(&job->done, 1);
+}
+
+// Waits for the oldest outstanding job, helping the workers meanwhile, then
+// writes it out as one chunk and folds it into the standings.
+static void writeOldestJob(tournament *t) {
+	match_job *job = t->jobs + (t->jobsWritten % Max_Jobs_In_Flight);
+	while(!atomicLoadU32(&job->done)) {
+		if(doNextWorkEntry(t->queue)) {
+			yieldThread();
+		}
+	}
+
+	u32 count = job->count;
+	fwrite(&count, sizeof(count), 1, t->file);
+	fwrite(job->roundColumn, sizeof(job->roundColumn[0]), count, t->file);
+	fwrite(job->leftColumn, sizeof(job->leftColumn[0]), count, t->file);
+	fwrite(job->rightColumn, sizeof(job->rightColumn[0]), count, t->file);
+	fwrite(job->leftScoreColumn, sizeof(job->leftScoreColumn[0]), count, t->file);
+	fwrite(job->rightScoreColumn, sizeof(job->rightScoreColumn[0]), count, t->file);
+	fwrite(job->ticksColumn, sizeof(job->ticksColumn[0]), count, t->file);
+	fwrite(job->seedColumn, sizeof(job->seedColumn[0]), count, t->file);
+
+	for(u32 i=0; i < count; ++i) {
+		u32 left = job->leftColumn[i];
+		u32 right = job->rightColumn[i];
+		u32 leftScore = job->leftScoreColumn[i];
+		u32 rightScore = job->rightScoreColumn[i];
+
+		double result = (leftScore > rightScore) ? 1.0 : ((leftScore < rightScore) ? 0.0 : 0.5);
+		t->score[left][right] += result;
+		t->score[right][left] += 1.0 - result;
+		++t->games[left][right];
+		++t->games[right][left];
+		t->ticks += job->ticksColumn[i];
+	}
+	t->matches += count;
+
+	++t->jobsWritten;
+}
+
+static void queueMatches(tournament *t, u32 round, u32 a, u32 b, u32 count) {
+	t->met[a][b] = true;
+	t->met[b][a] = true;
+
+	u32 first = 0;
+	while(first < count) {
+		if(t->jobsQueued - t->jobsWritten == Max_Jobs_In_Flight) {
+			writeOldestJob(t);
+		}
+
+		match_job *job = t->jobs + (t->jobsQueued % Max_Jobs_In_Flight);
+		job->owner = t;
+		job->round = (u16)round;
+		job->bots[0] = (u16)a;
+		job->bots[1] = (u16)b;
+		job->count = (count - first < Matches_Per_Job) ? (count - first) : Matches_Per_Job;
+		job->seed = mixSeed(t->seed ^ mixSeed(((u64)round << 32) | (a << 16) | b)) + first;
+		job->done = 0;
+
+		addWorkEntry(t->queue, runMatchJob, job);
+		++t->jobsQueued;
+		first += job->count;
+	}
+}
+
+static void finishQueuedMatches(tournament *t) {
+	while(t->jobsWritten != t->jobsQueued) {
+		writeOldestJob(t);
+	}
+}
+
+static double totalScore(tournament *t, u32 bot) {
+	double result = 0.0;
+	for(u32 other=0; other < t->botCount; ++other) {
+		result += t->score[bot][other];
+	}
+	return result;
+}
+
+static u32 totalGames(tournament *t, u32 bot) {
+	u32 result = 0;
+	for(u32 other=0; other < t->botCount; ++other) {
+		result += t->games[bot][other];
+	}
+	return result;
+}
+
+// Splits matches as evenly as possible over pairings, the earlier ones
+// playing one more, so exactly that many get played.
+static u32 matchesForPairing(u64 matches, u64 pairings, u64 pairing) {
+	return (u32)(matches / pairings + ((pairing < matches % pairings) ? 1 : 0));
+}
+
+static void runRoundRobin(tournament *t, u64 matches) {
+	u32 pairings = t->botCount * (t->botCount - 1) / 2;
+
+	u32 pairing = 0;
+	for(u32 a=0; a < t->botCount; ++a) {
+		for(u32 b=a + 1; b < t->botCount; ++b) {
+			queueMatches(t, 0, a, b, matchesForPairing(matches, pairings, pairing++));
+		}
+	}
+	finishQueuedMatches(t);
+}
+
+// Each round pairs bots with similar scores so far, avoiding rematches where
+// it can. With an odd count the lowest unpaired bot sits the round out.
+static void runSwiss(tournament *t, u32 rounds, u64 matches) {
+	u64 pairings = (u64)rounds * (t->botCount / 2);
+	u32 pairing = 0;
+
+	for(u32 round=0; round < rounds; ++round) {
+		u32 order[Max_Tournament_Bots];
+		double fraction[Max_Tournament_Bots];
+		for(u32 i=0; i < t->botCount; ++i) {
+			u32 games = totalGames(t, i);
+			order[i] = i;
+			fraction[i] = games ? (totalScore(t, i) / games) : 0.5;
+		}
+
+		for(u32 i=1; i < t->botCount; ++i) {
+			u32 bot = order[i];
+			u32 j = i;
+			for(; j > 0 && fraction[order[j - 1]] < fraction[bot]; --j) {
+				order[j] = order[j - 1];
+			}
+			order[j] = bot;
+		}
+
+		bool paired[Max_Tournament_Bots] = {};
+		for(u32 i=0; i < t->botCount; ++i) {
+			u32 a = order[i];
+			if(paired[a]) {
+				continue;
+			}
+
+			u32 opponent = t->botCount;
+			for(u32 j=i + 1; j < t->botCount; ++j) {
+				u32 b = order[j];
+				if(!paired[b]) {
+					if(opponent == t->botCount) {
+						opponent = b;
+					}
+					if(!t->met[a][b]) {
+						opponent = b;
+						break;
+					}
+				}
+			}
+
+			if(opponent < t->botCount) {
+				paired[a] = true;
+				paired[opponent] = true;
+				queueMatches(t, round, a, opponent, matchesForPairing(matches, pairings, pairing++));
+			}
+		}
+
+		finishQueuedMatches(t);
+	}
+}
+
+// Bradley-Terry strengths by minorization-maximization, with a draw between
+// every pair of bots that met added as a prior so a bot that never lost
+// still gets a finite rating. Elo is 400*log10 of the strength, centered on
+// the field's mean, and the interval is 1.96 standard errors from the
+// diagonal of the Fisher information.
+static void estimateElo(tournament *t, double *elo, double *interval) {
+	u32 n = t->botCount;
+	double strength[Max_Tournament_Bots];
+	for(u32 i=0; i < n; ++i) {
+		strength[i] = 1.0;
+	}
+
+	for(u32 iteration=0; iteration < 10000; ++iteration) {
+		double change = 0.0;
+		for(u32 i=0; i < n; ++i) {
+			double wins = 0.0;
+			double denominator = 0.0;
+			for(u32 j=0; j < n; ++j) {
+				if(j != i && t->games[i][j]) {
+					double games = t->games[i][j] + 1.0;
+					wins += t->score[i][j] + 0.5;
+					denominator += games / (strength[i] + strength[j]);
+				}
+			}
+
+			double updated = (denominator > 0.0) ? (wins / denominator) : 1.0;
+			change += fabs(log(updated / strength[i]));
+			strength[i] = updated;
+		}
+
+		double logMean = 0.0;
+		for(u32 i=0; i < n; ++i) {
+			logMean += log(strength[i]);
+		}
+		logMean /= n;
+		for(u32 i=0; i < n; ++i) {
+			strength[i] /= exp(logMean);
+		}
+
+		if(change < 1e-10) {
+			break;
+		}
+	}
+
+	double eloPerLog = 400.0 / log(10.0);
+	for(u32 i=0; i < n; ++i) {
+		double information = 0.0;
+		for(u32 j=0; j < n; ++j) {
+			if(j != i && t->games[i][j]) {
+				double p = strength[i] / (strength[i] + strength[j]);
+				information += (t->games[i][j] + 1.0) * p * (1.0 - p);
+			}
+		}
+
+		elo[i] = eloPerLog * log(strength[i]);
+		interval[i] = (information > 0.0) ? (1.96 * eloPerLog / sqrt(information)) : 0.0;
+	}
+}
+
+static bool parseBot(const char *text, tournament_bot *bot) {
+	static const char *presetNames[] = {"easy", "medium", "hard", "perfect"};
+	for(u32 i=0; i < arrayCount(presetNames); ++i) {
+		if(strcmp(text, presetNames[i]) == 0) {
+			strcpy(bot->name, presetNames[i]);
+			bot->difficulty = globalBotDifficulties[i];
+			return true;
+		}
+	}
+
+	u32 reactionTicks;
+	float noise, deadZone;
+	if(sscanf(text, "%u:%f:%f", &reactionTicks, &noise, &deadZone) == 3 &&
+	   reactionTicks < Bot_History_Size) {
+		strncpy(bot->name, text, sizeof(bot->name) - 1);
+		bot->difficulty.reactionTicks = reactionTicks;
+		bot->difficulty.noise = noise;
+		bot->difficulty.deadZone = deadZone;
+		return true;
+	}
+
+	return false;
+}
+
+int main(int argc, char **argv) {
+	static tournament t;
+	u64 matches = 100000;
+	u32 swissRounds = 0;
+	u32 threadCount = getCoreCount();
+	const char *path = "tournament.ptr";
+	t.pointsToWin = 3;
+	t.seed = 1;
+
+	for(int i=1; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : 0;
+		if(strcmp(arg, "-matches") == 0 && value) {
+			matches = strtoull(value, 0, 10);
+			++i;
+		}
+		else if(strcmp(arg, "-swiss") == 0 && value) {
+			swissRounds = (u32)atoi(value);
+			++i;
+		}
+		else if(strcmp(arg, "-points") == 0 && value) {
+			t.pointsToWin = (u32)atoi(value);
+			++i;
+		}
+		else if(strcmp(arg, "-threads") == 0 && value) {
+			threadCount = (u32)atoi(value);
+			++i;
+		}
+		else if(strcmp(arg, "-seed") == 0 && value) {
+			t.seed = strtoull(value, 0, 10);
+			++i;
+		}
+		else if(strcmp(arg, "-out") == 0 && value) {
+			path = value;
+			++i;
+		}
+		else if(t.botCount < Max_Tournament_Bots && parseBot(arg, t.bots + t.botCount)) {
+			++t.botCount;
+		}
+		else {
+			fprintf(stderr, "pong_tournament: don't understand '%s'\n", arg);
+			return 1;
+		}
+	}
+
+	if(t.botCount == 0) {
+		bot_difficulty easy = globalBotDifficulties[0];
+		bot_difficulty hard = globalBotDifficulties[2];
+		for(u32 i=0; i < 10; ++i) {
+			float s = i / 9.0f;
+			tournament_bot *bot = t.bots + t.botCount++;
+			bot->difficulty.reactionTicks = (u32)(lerp((float)easy.reactionTicks, s, (float)hard.reactionTicks) + 0.5f);
+			bot->difficulty.noise = lerp(easy.noise, s, hard.noise);
+			bot->difficulty.deadZone = lerp(easy.deadZone, s, hard.deadZone);
+			sprintf(bot->name, "%u:%.1f:%.1f", bot->difficulty.reactionTicks,
+			        bot->difficulty.noise, bot->difficulty.deadZone);
+		}
+	}
+	if(t.botCount < 2) {
+		fprintf(stderr, "pong_tournament: need at least two bots\n");
+		return 1;
+	}
+	if(t.pointsToWin < 1 || t.pointsToWin > 255) {
+		t.pointsToWin = 3;
+	}
+
+	t.file = fopen(path, "wb");
+	if(!t.file) {
+		fprintf(stderr, "pong_tournament: can't write %s\n", path);
+		return 1;
+	}
+
+	tournament_file_header header = {};
+	memcpy(header.magic, "PTRN", 4);
+	header.version = Tournament_File_Version;
+	header.botCount = t.botCount;
+	header.pointsToWin = t.pointsToWin;
+	header.seed = t.seed;
+	fwrite(&header, sizeof(header), 1, t.file);
+	for(u32 i=0; i < t.botCount; ++i) {
+		tournament_file_bot bot = {};
+		memcpy(bot.name, t.bots[i].name, sizeof(bot.name));
+		bot.reactionTicks = t.bots[i].difficulty.reactionTicks;
+		bot.noise = t.bots[i].difficulty.noise;
+		bot.deadZone = t.bots[i].difficulty.deadZone;
+		fwrite(&bot, sizeof(bot), 1, t.file);
+	}
+
+	// The main thread works through the queue too whenever it is waiting, so
+	// it counts as one of the threads.
+	static work_queue queue;
+	t.queue = &queue;
+	initWorkQueue(&queue, (threadCount > 1) ? (threadCount - 1) : 0);
+
+	double start = benchSeconds();
+	if(swissRounds) {
+		runSwiss(&t, swissRounds, matches);
+	}
+	else {
+		runRoundRobin(&t, matches);
+	}
+	double seconds = benchSeconds() - start;
+
+	fclose(t.file);
+
+	double elo[Max_Tournament_Bots], interval[Max_Tournament_Bots];
+	estimateElo(&t, elo, interval);
+
+	u32 order[Max_Tournament_Bots];
+	for(u32 i=0; i < t.botCount; ++i) {
+		u32 j = i;
+		for(; j > 0 && elo[order[j - 1]] < elo[i]; --j) {
+			order[j] = order[j - 1];
+		}
+		order[j] = i;
+	}
+
+	printf("%llu matches (%s) on %u threads in %.1fs, %.2fM ticks/s, results in %s\n",
+	       (unsigned long long)t.matches, swissRounds ? "swiss" : "round robin", threadCount, seconds,
+	       (double)t.ticks / seconds / 1e6, path);
+	printf("%-4s %-20s %7s %8s %8s %7s\n", "RANK", "BOT", "ELO", "95%", "GAMES", "SCORE");
+	for(u32 rank=0; rank < t.botCount; ++rank) {
+		u32 i = order[rank];
+		u32 games = totalGames(&t, i);
+		printf("%-4u %-20s %7.0f %8.1f %8u %6.1f%%\n", rank + 1, t.bots[i].name, elo[i], interval[i],
+		       games, games ? (100.0 * totalScore(&t, i) / games) : 0.0);
+	}
+
+	return 0;
+}
@@ -0,0 +1,442 @@
+#include <emmintrin.h>
+
+// Streams per-step rows out of the headless simulation into column files.
+// The simulation thread only ever appends rows to the current chunk;
+// splitting them into columns, compressing and writing happen on a
+// background thread.
+
+#define Trajectory_Column(name, type, field) {name, type, sizeof(((trajectory_row *)0)->field), offsetof(trajectory_row, field)}
+#define Trajectory_Derived_Column(name, type, size) {name, type, size, Trajectory_Derived}
+
+// Rows are split into columns this many at a time, so each block comes in
+// from memory once and every column after the first finds it in cache.
+#define Trajectory_Gather_Rows 256
+
+static trajectory_column_info globalTrajectoryColumns[Trajectory_Column_Count] = {
+	Trajectory_Derived_Column("tick", TrajectoryU32, sizeof(u32)),
+	Trajectory_Derived_Column("environment", TrajectoryU32, sizeof(u32)),
+	Trajectory_Derived_Column("done", TrajectoryU8, sizeof(u8)),
+	Trajectory_Derived_Column("reward", TrajectoryF32, sizeof(float)),
+	Trajectory_Column("ball_x", TrajectoryF32, ballX),
+	Trajectory_Column("ball_y", TrajectoryF32, ballY),
+	Trajectory_Column("ball_velocity_x", TrajectoryF32, ballVelocityX),
+	Trajectory_Column("ball_velocity_y", TrajectoryF32, ballVelocityY),
+	Trajectory_Column("paddle0_y", TrajectoryF32, paddle0Y),
+	Trajectory_Column("paddle1_y", TrajectoryF32, paddle1Y),
+	Trajectory_Derived_Column("score0", TrajectoryU32, sizeof(u32)),
+	Trajectory_Derived_Column("score1", TrajectoryU32, sizeof(u32)),
+	Trajectory_Derived_Column("buttons", TrajectoryU8, sizeof(u8)),
+	Trajectory_Derived_Column("held0_up", TrajectoryF32, sizeof(float)),
+	Trajectory_Derived_Column("held0_down", TrajectoryF32, sizeof(float)),
+	Trajectory_Derived_Column("held1_up", TrajectoryF32, sizeof(float)),
+	Trajectory_Derived_Column("held1_down", TrajectoryF32, sizeof(float)),
+};
+
+// Worst case for packColumn(): all literals, one control byte per 128.
+#define Trajectory_Packed_Bound(size) ((size) + (size) / 128 + 16)
+
+// Packing: each element is XORed with the one before it, the result is split
+// into byte planes (all first bytes, then all second bytes, ...), and the
+// planes are run-length coded. Slowly changing values leave mostly zero
+// high bytes, which the runs then eat.
+//
+// Run-length code: a control byte c < 128 is followed by c + 1 literal
+// bytes; c >= 128 repeats the next byte c - 125 times.
+static u32 packColumn(u8 *raw, u32 count, u32 elementSize, u8 *transposed, u8 *packed) {
+	for(u32 b=0; b < elementSize; ++b) {
+		u8 *plane = transposed + b*count;
+		u8 previous = 0;
+		for(u32 i=0; i < count; ++i) {
+			u8 value = raw[i*elementSize + b];
+			plane[i] = value ^ previous;
+			previous = value;
+		}
+	}
+
+	u32 size = count * elementSize;
+	u8 *out = packed;
+	u32 at = 0;
+	while(at < size) {
+		u8 value = transposed[at];
+		u32 run = 1;
+		while(at + run < size && run < 130 && transposed[at + run] == value) {
+			++run;
+		}
+
+		if(run >= 3) {
+			*out++ = (u8)(run + 125);
+			*out++ = value;
+			at += run;
+		}
+		else {
+			u32 start = at;
+			while(at < size && at - start < 128) {
+				if(at + 2 < size && transposed[at] == transposed[at + 1] && transposed[at] == transposed[at + 2]) {
+					break;
+				}
+				++at;
+			}
+			*out++ = (u8)(at - start - 1);
+			memcpy(out, transposed + start, at - start);
+			out += at - start;
+		}
+	}
+
+	return (u32)(out - packed);
+}
+
+// Inverse of packColumn(); raw receives count elements.
+void unpackColumn(u8 *packed, u32 packedSize, u32 count, u32 elementSize, u8 *transposed, u8 *raw) {
+	u8 *in = packed;
+	u8 *end = packed + packedSize;
+	u8 *out = transposed;
+	while(in < end) {
+		u32 control = *in++;
+		if(control < 128) {
+			memcpy(out, in, control + 1);
+			in += control + 1;
+			out += control + 1;
+		}
+		else {
+			memset(out, *in++, control - 125);
+			out += control - 125;
+		}
+	}
+
+	for(u32 b=0; b < elementSize; ++b) {
+		u8 *plane = transposed + b*count;
+		u8 previous = 0;
+		for(u32 i=0; i < count; ++i) {
+			previous ^= plane[i];
+			raw[i*elementSize + b] = previous;
+		}
+	}
+}
+
+static void writeColumnHeader(trajectory_writer *writer, u32 column) {
+	trajectory_column_info *info = globalTrajectoryColumns + column;
+
+	trajectory_column_header header = {};
+	memcpy(header.magic, "PTRC", 4);
+	header.version = Trajectory_Column_Version;
+	header.type = info->type;
+	header.elementSize = info->elementSize;
+	header.compressed = writer->compress ? 1 : 0;
+	header.chunkRows = Trajectory_Chunk_Rows;
+	header.rowCount = writer->rowCount;
+	header.chunkCount = writer->chunkCount;
+	strncpy(header.name, info->name, sizeof(header.name) - 1);
+
+	u8 padded[64] = {};
+	memcpy(padded, &header, sizeof(header));
+	FILE *file = writer->files[column];
+	if(fseek(file, 0, SEEK_SET) != 0 || fwrite(padded, sizeof(padded), 1, file) != 1) {
+		writer->writeFailed = true;
+	}
+}
+
+// Pulls one field out of every row into a contiguous array.
+static void gatherColumn(trajectory_row *rows, u32 count, trajectory_column_info *info, u8 *column) {
+	u8 *field = (u8 *)rows + info->offset;
+	switch(info->elementSize) {
+		case 1: {
+			for(u32 i=0; i < count; ++i) {
+				column[i] = field[i*sizeof(trajectory_row)];
+			}
+		} break;
+
+		case 4: {
+			u32 *out = (u32 *)column;
+			for(u32 i=0; i < count; ++i) {
+				out[i] = *(u32 *)(field + i*sizeof(trajectory_row));
+			}
+		} break;
+
+		case 8: {
+			u64 *out = (u64 *)column;
+			for(u32 i=0; i < count; ++i) {
+				out[i] = *(u64 *)(field + i*sizeof(trajectory_row));
+			}
+		} break;
+
+		default: {
+			assert(!"unsupported column element size");
+		} break;
+	}
+}
+
+// The columns trajectory_row leaves out, rebuilt for count rows of a chunk
+// starting at start. Rows have to come through here in order, since the
+// scores carry over from one row of an environment to its next.
+static void deriveColumns(trajectory_writer *writer, trajectory_chunk *chunk, u32 start, u32 count) {
+	trajectory_row *rows = chunk->rows + start;
+	u32 *ticks = (u32 *)writer->columns[ColumnTick] + start;
+	u32 *environments = (u32 *)writer->columns[ColumnEnvironment] + start;
+	u8 *dones = writer->columns[ColumnDone] + start;
+	float *rewards = (float *)writer->columns[ColumnReward] + start;
+	u32 *scores0 = (u32 *)writer->columns[ColumnScore0] + start;
+	u32 *scores1 = (u32 *)writer->columns[ColumnScore1] + start;
+	u8 *buttons = writer->columns[ColumnButtons] + start;
+	float *held0Up = (float *)writer->columns[ColumnHeld0Up] + start;
+	float *held0Down = (float *)writer->columns[ColumnHeld0Down] + start;
+	float *held1Up = (float *)writer->columns[ColumnHeld1Up] + start;
+	float *held1Down = (float *)writer->columns[ColumnHeld1Down] + start;
+
+	u64 firstRow = chunk->firstRow + start;
+	u64 tick = writer->firstTick + firstRow / writer->environmentCount;
+	u32 environment = (u32)(firstRow % writer->environmentCount);
+	for(u32 i=0; i < count; ++i) {
+		trajectory_row *row = rows + i;
+		u32 *scores = writer->scores + 2*environment;
+		if(row->flags & TrajectoryRowFirst) {
+			scores[0] = 0;
+			scores[1] = 0;
+		}
+		scores[0] += row->points0;
+		scores[1] += row->points1;
+
+		ticks[i] = (u32)tick;
+		environments[i] = environment;
+		dones[i] = row->flags & TrajectoryRowDone;
+		rewards[i] = (float)row->points0 - (float)row->points1;
+		scores0[i] = scores[0];
+		scores1[i] = scores[1];
+		buttons[i] = (u8)(row->buttons0 | ((row->held1 < 0.0f) ? 4 : 0) | ((row->held1 > 0.0f) ? 8 : 0));
+		held0Up[i] = (row->buttons0 & 1) ? 1.0f : 0.0f;
+		held0Down[i] = (row->buttons0 & 2) ? 1.0f : 0.0f;
+		held1Up[i] = (row->held1 < 0.0f) ? -row->held1 : 0.0f;
+		held1Down[i] = (row->held1 > 0.0f) ? row->held1 : 0.0f;
+
+		if(++environment == writer->environmentCount) {
+			environment = 0;
+			++tick;
+		}
+	}
+	assert(tick <= Trajectory_Max_Tick + 1);
+}
+
+static void writeChunk(trajectory_writer *writer, trajectory_chunk *chunk) {
+	if(writer->writeFailed) {
+		return;
+	}
+
+	for(u32 start=0; start < chunk->rowCount; start += Trajectory_Gather_Rows) {
+		u32 count = chunk->rowCount - start;
+		if(count > Trajectory_Gather_Rows) {
+			count = Trajectory_Gather_Rows;
+		}
+		for(u32 column=0; column < Trajectory_Column_Count; ++column) {
+			trajectory_column_info *info = globalTrajectoryColumns + column;
+			if(info->offset != Trajectory_Derived) {
+				gatherColumn(chunk->rows + start, count, info, writer->columns[column] + start*info->elementSize);
+			}
+		}
+		deriveColumns(writer, chunk, start, count);
+	}
+
+	for(u32 column=0; column < Trajectory_Column_Count; ++column) {
+		trajectory_column_info *info = globalTrajectoryColumns + column;
+		FILE *file = writer->files[column];
+		u8 *values = writer->columns[column];
+
+		if(writer->compress) {
+			u32 sizes[2];
+			sizes[0] = chunk->rowCount * info->elementSize;
+			sizes[1] = packColumn(values, chunk->rowCount, info->elementSize,
+			                      writer->transposed, writer->packed);
+			if(fwrite(sizes, sizeof(sizes), 1, file) != 1 ||
+			   fwrite(writer->packed, 1, sizes[1], file) != sizes[1]) {
+				writer->writeFailed = true;
+				return;
+			}
+		}
+		else if(fwrite(values, info->elementSize, chunk->rowCount, file) != chunk->rowCount) {
+			writer->writeFailed = true;
+			return;
+		}
+	}
+
+	writer->rowCount += chunk->rowCount;
+	++writer->chunkCount;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI trajectoryWriterProc(LPVOID parameter) {
+#else
+static void *trajectoryWriterProc(void *parameter) {
+#endif
+	trajectory_writer *writer = (trajectory_writer *)parameter;
+	for(;;) {
+		waitSemaphore(&writer->fullChunks);
+		trajectory_chunk *chunk = writer->chunks + (writer->read % Trajectory_Queue_Chunks);
+		if(chunk->rowCount == 0) {
+			break;
+		}
+
+		writeChunk(writer, chunk);
+		chunk->rowCount = 0;
+		++writer->read;
+		signalSemaphore(&writer->freeChunks);
+	}
+
+	return 0;
+}
+
+// Hands the current chunk to the writer thread and waits for a free one.
+static void submitTrajectoryChunk(trajectory_writer *writer) {
+	trajectory_chunk *chunk = writer->chunks + (writer->written % Trajectory_Queue_Chunks);
+	chunk->rowCount = (u32)(writer->nextRow - chunk->rows);
+	u64 firstRow = chunk->firstRow + chunk->rowCount;
+
+	_mm_sfence();
+	++writer->written;
+	signalSemaphore(&writer->fullChunks);
+	waitSemaphore(&writer->freeChunks);
+
+	chunk = writer->chunks + (writer->written % Trajectory_Queue_Chunks);
+	chunk->firstRow = firstRow;
+	writer->nextRow = chunk->rows;
+	writer->endRow = chunk->rows + Trajectory_Chunk_Rows;
+}
+
+// Every step records environmentCount rows, environment 0 first, starting
+// with the step at firstTick; games are the environments as that step
+// starts, for the scores of episodes already under way. Returns 0 if any of
+// the column files can't be created.
+trajectory_writer *openTrajectoryWriter(const char *directory, bool compress, u64 firstTick,
+                                        game_state *games, u32 environmentCount) {
+	size_t columnBytes = Trajectory_Chunk_Rows * sizeof(u64);
+	size_t size = (Align16(sizeof(trajectory_writer)) + Align16(2*environmentCount*sizeof(u32)) +
+	               Trajectory_Queue_Chunks*Align16(Trajectory_Chunk_Rows * sizeof(trajectory_row)) +
+	               Trajectory_Column_Count*Align16(columnBytes) + Align16(columnBytes) +
+	               Align16(Trajectory_Packed_Bound(columnBytes)));
+
+	void *memory = calloc(1, size);
+	if(!memory) {
+		return 0;
+	}
+
+	memory_arena arena;
+	initArena(&arena, memory, size);
+
+	trajectory_writer *writer = pushStruct(&arena, trajectory_writer);
+	writer->compress = compress;
+	writer->firstTick = firstTick;
+	writer->environmentCount = environmentCount;
+	writer->scores = pushArray(&arena, 2*environmentCount, u32);
+	for(u32 i=0; i < environmentCount; ++i) {
+		writer->scores[2*i + 0] = games[i].players[0].score;
+		writer->scores[2*i + 1] = games[i].players[1].score;
+	}
+	for(u32 i=0; i < Trajectory_Queue_Chunks; ++i) {
+		writer->chunks[i].rows = pushArray(&arena, Trajectory_Chunk_Rows, trajectory_row);
+	}
+	writer->nextRow = writer->chunks[0].rows;
+	writer->endRow = writer->chunks[0].rows + Trajectory_Chunk_Rows;
+	for(u32 column=0; column < Trajectory_Column_Count; ++column) {
+		writer->columns[column] = (u8 *)pushSize(&arena, Trajectory_Chunk_Rows*globalTrajectoryColumns[column].elementSize);
+	}
+	writer->transposed = (u8 *)pushSize(&arena, columnBytes);
+	writer->packed = (u8 *)pushSize(&arena, Trajectory_Packed_Bound(columnBytes));
+
+	for(u32 column=0; column < Trajectory_Column_Count; ++column) {
+		char path[1024];
+		sprintf(path, "%.900s/%s.col", directory, globalTrajectoryColumns[column].name);
+		writer->files[column] = fopen(path, "wb");
+		if(!writer->files[column]) {
+			for(u32 i=0; i < column; ++i) {
+				fclose(writer->files[i]);
+			}
+			free(writer);
+			return 0;
+		}
+
+		// Every write is a whole column of a chunk already. Unbuffered, a
+		// failure shows up in the chunk that caused it rather than in a later
+		// flush, and the header still gets rewritten over the rows before it.
+		setvbuf(writer->files[column], 0, _IONBF, 0);
+		writeColumnHeader(writer, column);
+	}
+
+	// The producer always owns one chunk, so one fewer is free to start with.
+	initSemaphore(&writer->freeChunks, Trajectory_Queue_Chunks);
+	initSemaphore(&writer->fullChunks, Trajectory_Queue_Chunks);
+	for(u32 i=0; i < Trajectory_Queue_Chunks - 1; ++i) {
+		signalSemaphore(&writer->freeChunks);
+	}
+
+#if defined(_WIN32)
+	writer->thread = CreateThread(0, 0, trajectoryWriterProc, writer, 0, 0);
+#else
+	pthread_create(&writer->thread, 0, trajectoryWriterProc, writer);
+#endif
+
+	return writer;
+}
+
+// Appends one row: the state a step ended in (before any reset), the input
+// that was held during it, and the points each side scored in it. A point
+// takes the ball across the arena, so no step scores 256.
+inline void recordTrajectoryRow(trajectory_writer *writer, game_state *gameState, u32 points0, u32 points1,
+                                bool firstStep, bool done) {
+	program_input *input = gameState->input;
+	u32 buttons0 = (input[0].up.endedDown ? 1 : 0) | (input[0].down.endedDown ? 2 : 0);
+	u32 flags = (done ? TrajectoryRowDone : 0) | (firstStep ? TrajectoryRowFirst : 0);
+	u32 packed = points0 | (points1 << 8) | (flags << 16) | (buttons0 << 24);
+
+	// The row goes together in registers, in trajectory_row's order: stored
+	// field by field and read back, the wide loads would stall on the
+	// narrow stores.
+	__m128 first = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (__m64 *)&gameState->ball.pos),
+	                            (__m64 *)&gameState->ball.velocity);
+	__m128 paddles = _mm_unpacklo_ps(_mm_set_ss(gameState->players[0].pos.y),
+	                                 _mm_set_ss(gameState->players[1].pos.y));
+	__m128 held1 = _mm_set_ss(input[1].down.heldFraction - input[1].up.heldFraction);
+	__m128 rest = _mm_unpacklo_ps(held1, _mm_castsi128_ps(_mm_cvtsi32_si128((int)packed)));
+	__m128 second = _mm_movelh_ps(paddles, rest);
+
+	// Nothing reads the row back on this thread, so skip pulling the lines
+	// into the cache.
+	__m128i *dest = (__m128i *)writer->nextRow;
+	_mm_stream_si128(dest + 0, _mm_castps_si128(first));
+	_mm_stream_si128(dest + 1, _mm_castps_si128(second));
+
+	if(++writer->nextRow == writer->endRow) {
+		submitTrajectoryChunk(writer);
+	}
+}
+
+// Flushes the partial chunk, waits for the writer thread, fills in the final
+// row counts and closes the files. Returns false if anything failed to
+// write; the headers then count the rows written before it.
+bool closeTrajectoryWriter(trajectory_writer *writer) {
+	trajectory_chunk *chunk = writer->chunks + (writer->written % Trajectory_Queue_Chunks);
+	if(writer->nextRow != chunk->rows) {
+		submitTrajectoryChunk(writer);
+	}
+
+	++writer->written;
+	signalSemaphore(&writer->fullChunks);
+
+#if defined(_WIN32)
+	WaitForSingleObject(writer->thread, INFINITE);
+	CloseHandle(writer->thread);
+	CloseHandle(writer->freeChunks);
+	CloseHandle(writer->fullChunks);
+#else
+	pthread_join(writer->thread, 0);
+	sem_destroy(&writer->freeChunks);
+	sem_destroy(&writer->fullChunks);
+#endif
+
+	for(u32 column=0; column < Trajectory_Column_Count; ++column) {
+		writeColumnHeader(writer, column);
+		if(fclose(writer->files[column]) != 0) {
+			writer->writeFailed = true;
+		}
+	}
+
+	bool result = !writer->writeFailed;
+	free(writer);
+	return result;
+}
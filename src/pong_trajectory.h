@@ -0,0 +1,160 @@
+#ifndef PONG_TRAJECTORY_H
+#define PONG_TRAJECTORY_H
+
+// Column files for recorded trajectories. Every column lives in its own
+// file, <directory>/<name>.col, made of a trajectory_column_header followed
+// by the rows:
+//
+//   - uncompressed: the rows back to back, so mapping the file and skipping
+//     the 64 byte header gives a plain array of rowCount elements.
+//   - compressed: chunkCount chunks, each a u32 raw size and a u32 packed
+//     size followed by the packed bytes (see packColumn()).
+
+#define Trajectory_Column_Version 1
+#define Trajectory_Chunk_Rows 65536
+
+// Full chunks waiting for the writer thread. The simulation blocks when all
+// of them are in use rather than letting memory grow.
+#define Trajectory_Queue_Chunks 4
+
+enum trajectory_column {
+	ColumnTick,
+	ColumnEnvironment,
+	ColumnDone,
+	ColumnReward,
+	ColumnBallX,
+	ColumnBallY,
+	ColumnBallVelocityX,
+	ColumnBallVelocityY,
+	ColumnPaddle0Y,
+	ColumnPaddle1Y,
+	ColumnScore0,
+	ColumnScore1,
+	ColumnButtons,
+	ColumnHeld0Up,
+	ColumnHeld0Down,
+	ColumnHeld1Up,
+	ColumnHeld1Down,
+
+	Trajectory_Column_Count
+};
+
+enum trajectory_type {
+	TrajectoryU8,
+	TrajectoryU32,
+	TrajectoryU64,
+	TrajectoryF32,
+};
+
+struct trajectory_column_info {
+	const char *name;
+	trajectory_type type;
+	u32 elementSize;
+	u32 offset;
+};
+
+// The tick column is 32 bits, so exporting ends at Trajectory_Max_Tick
+// rather than wrap.
+#define Trajectory_Max_Tick 0xFFFFFFFFull
+
+// Marks a column the row leaves out for the writer thread to rebuild
+#define Trajectory_Derived 0xFFFFFFFF
+
+// The simulation appends whole rows with streaming stores; splitting them
+// into columns is left to the writer thread. Rows carry only what the writer
+// can't work out by itself:
+//
+//   - the tick and environment follow from a row's position, since every
+//     step records each environment in order.
+//   - player 0 always holds whole steps of its action, so its held fractions
+//     are its buttons. Player 1 holds at most one button at a time, and only
+//     with a fraction above 0, so held1 is the up fraction negated or the
+//     down one, and its buttons follow from the sign.
+//   - the reward is the points scored during the step, and the scores are
+//     the points scored since the episode started (or since the export did,
+//     for an episode already under way).
+struct trajectory_row {
+	float ballX;
+	float ballY;
+	float ballVelocityX;
+	float ballVelocityY;
+	float paddle0Y;
+	float paddle1Y;
+	float held1;
+	u8 points0;
+	u8 points1;
+	u8 flags;
+	u8 buttons0;
+};
+
+enum trajectory_row_flags {
+	TrajectoryRowDone = 0x1,
+
+	// The step was the first of its episode, so the scores started from 0
+	TrajectoryRowFirst = 0x2,
+};
+
+static_assert(sizeof(trajectory_row) == 32, "trajectory rows are built in two SSE registers");
+
+struct trajectory_column_header {
+	char magic[4];
+	u32 version;
+	u32 type;
+	u32 elementSize;
+	u32 compressed;
+	u32 chunkRows;
+	u64 rowCount;
+	u64 chunkCount;
+	char name[24];
+};
+
+struct trajectory_chunk {
+	u32 rowCount;
+	trajectory_row *rows;
+
+	// Rows recorded before this chunk's first one
+	u64 firstRow;
+};
+
+struct trajectory_writer {
+	bool compress;
+	FILE *files[Trajectory_Column_Count];
+	u64 rowCount;
+	u64 chunkCount;
+
+	// The tick of the first row, and how many rows each step records
+	u64 firstTick;
+	u32 environmentCount;
+
+	// Each environment's scores as of the last row written for it
+	u32 *scores;
+
+	// Set by the first write that fails. Nothing more is written after it,
+	// so the headers only count the chunks that made it out whole.
+	bool writeFailed;
+
+	// The producer fills chunks[written % count], from nextRow up to endRow,
+	// and sets its rowCount when handing it over; the writer thread drains
+	// chunks[read % count]. A chunk with no rows tells the thread to stop.
+	trajectory_chunk chunks[Trajectory_Queue_Chunks];
+	trajectory_row *nextRow;
+	trajectory_row *endRow;
+	u32 written;
+	u32 read;
+	platform_semaphore freeChunks;
+	platform_semaphore fullChunks;
+
+	// Scratch for the writer thread: a chunk split into columns, and the
+	// packing of one of them
+	u8 *columns[Trajectory_Column_Count];
+	u8 *transposed;
+	u8 *packed;
+
+#if defined(_WIN32)
+	void *thread;
+#else
+	pthread_t thread;
+#endif
+};
+
+#endif